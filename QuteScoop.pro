@@ -21,6 +21,11 @@ CONFIG *= qt
 CONFIG *= warn_on
 TARGET = QuteScoop
 
+# count all operator new/delete calls for the benchmarks, e.g. --bench-update
+allocation_counter {
+    DEFINES += QS_ALLOCATION_COUNTER
+}
+
 DISTFILES += uncrustify.cfg
 
 win32: {
@@ -156,6 +161,7 @@ HEADERS += \
     src/Settings.h \
     src/Pilot.h \
     src/NavData.h \
+    src/Geodesic.h \
     src/NavAid.h \
     src/Metar.h \
     src/MapObject.h \
@@ -163,15 +169,24 @@ HEADERS += \
     src/LineReader.h \
     src/SectorReader.h \
     src/Sector.h \
+    src/SectorIndex.h \
+    src/SpatialIndex.h \
     src/FileReader.h \
     src/Controller.h \
+    src/DataBundle.h \
     src/Client.h \
     src/BookedController.h \
     src/Airline.h \
     src/Airway.h \
     src/Airport.h \
     src/Airac.h \
+    src/AiracCache.h \
+    src/NavStore.h \
+    src/AirwayGraph.h \
+    src/RouteFinder.h \
+    src/RouteCache.h \
     src/Window.h \
+    src/SearchIndex.h \
     src/SearchVisitor.h \
     src/SearchResultModel.h \
     src/PreferencesDialog.h \
@@ -204,6 +219,16 @@ HEADERS += \
     src/Net.h \
     src/SondeData.h \
     src/JobList.h \
+    src/JsonStreamReader.h \
+    src/WhazzupDecoder.h \
+    src/Benchmark.h \
+    src/ClientArena.h \
+    src/ClientRecords.h \
+    src/AllocationCounter.h \
+    src/StringPool.h \
+    src/PilotTable.h \
+    src/WhazzupArchive.h \
+    src/WhazzupIndex.h \
     src/MetarDelegate.h \
     src/Platform.h
 SOURCES += src/WhazzupData.cpp \
@@ -214,6 +239,7 @@ SOURCES += src/WhazzupData.cpp \
     src/QuteScoop.cpp \
     src/Pilot.cpp \
     src/NavData.cpp \
+    src/Geodesic.cpp \
     src/NavAid.cpp \
     src/Metar.cpp \
     src/MapObject.cpp \
@@ -221,14 +247,22 @@ SOURCES += src/WhazzupData.cpp \
     src/LineReader.cpp \
     src/SectorReader.cpp \
     src/Sector.cpp \
+    src/SectorIndex.cpp \
     src/FileReader.cpp \
     src/Controller.cpp \
+    src/DataBundle.cpp \
     src/Client.cpp \
     src/BookedController.cpp \
     src/Airway.cpp \
     src/Airport.cpp \
     src/Airac.cpp \
+    src/AiracCache.cpp \
+    src/NavStore.cpp \
+    src/AirwayGraph.cpp \
+    src/RouteFinder.cpp \
+    src/RouteCache.cpp \
     src/Window.cpp \
+    src/SearchIndex.cpp \
     src/SearchVisitor.cpp \
     src/SearchResultModel.cpp \
     src/PreferencesDialog.cpp \
@@ -260,6 +294,18 @@ SOURCES += src/WhazzupData.cpp \
     src/Net.cpp \
     src/SondeData.cpp \
     src/JobList.cpp \
+    src/JsonStreamReader.cpp \
+    src/WhazzupDecoder.cpp \
+    src/Benchmark.cpp \
+    src/BenchmarkIngest.cpp \
+    src/BenchmarkNav.cpp \
+    src/ClientArena.cpp \
+    src/ClientRecords.cpp \
+    src/AllocationCounter.cpp \
+    src/StringPool.cpp \
+    src/PilotTable.cpp \
+    src/WhazzupArchive.cpp \
+    src/WhazzupIndex.cpp \
     src/MetarDelegate.cpp \
     src/Platform.cpp
 RESOURCES += src/Resources.qrc
@@ -4,10 +4,12 @@
 
 #include "Airac.h"
 
+#include "AiracCache.h"
 #include "Airport.h"
 #include "FileReader.h"
 #include "Waypoint.h"
 #include "NavData.h"
+#include "RouteFinder.h"
 #include "Settings.h"
 #include "GuiMessage.h"
 
@@ -19,47 +21,233 @@ Airac *Airac::instance(bool createIfNoInstance) {
     return airacInstance;
 }
 
-Airac::Airac() {
+Airac::Airac() :
+    _routeFinder(0)
+{
+    connect(qApp, &QCoreApplication::aboutToQuit, this, &Airac::saveRouteCache);
 }
 
 Airac::~Airac() {
-    foreach (const QSet<Waypoint*> &wl, fixes.values())
-        foreach(Waypoint *w, wl)
-            delete w;
-    foreach (const QSet<NavAid*> &nl, navaids.values())
-        foreach(NavAid *n , nl)
-            delete n;
+    clear();
+}
+
+void Airac::clear() {
+    _pointIndex.clear();
+    _identIndex.clear();
+    qDeleteAll(_handles);
+    _handles.clear();
+    _handleIndices.clear();
+    qDeleteAll(_generatedFixes);
+    _generatedFixes.clear();
+    qDeleteAll(_airportPoints);
+    _airportPoints.clear();
+    foreach (const QList<Airway*> &al, airways.values())
+        foreach(Airway *a , al)
+            delete a;
+    delete _routeFinder;
+    _routeFinder = 0;
+    _store.clear();
+    _airwayGraph.clear();
+    airways.clear();
+}
+
+/**
+  Drops the navdata before it is read again. The Waypoint objects stay
+  alive, pilots might still have them in their routes.
+**/
+void Airac::forgetPoints() {
+    _pointIndex.clear();
+    _identIndex.clear();
+    _handles.clear();
+    _handleIndices.clear();
+    _generatedFixes.clear();
     foreach (const QList<Airway*> &al, airways.values())
         foreach(Airway *a , al)
             delete a;
+    delete _routeFinder;
+    _routeFinder = 0;
+    _store.clear();
+    _airwayGraph.clear();
+    airways.clear();
+}
+
+RouteFinder *Airac::routeFinder() {
+    if (_routeFinder == 0) {
+        _routeFinder = new RouteFinder(_store, _airwayGraph);
+    }
+    return _routeFinder;
+}
+
+Waypoint* Airac::point(int index) const {
+    Waypoint *&handle = _handles[index];
+    if (handle == 0) {
+        const NavStore::Point &p = _store.point(index);
+        if (_store.isNavaid(index)) {
+            handle = new NavAid(_store.ident(index), p.lat, p.lon, _store.regionCode(index), p.type,
+                                _store.freq(index), _store.hdg(index), _store.name(index));
+        } else {
+            handle = new Waypoint(_store.ident(index), p.lat, p.lon);
+            handle->regionCode = _store.regionCode(index);
+        }
+        _handleIndices.insert(handle, index);
+    }
+    return handle;
+}
+
+Waypoint *Airac::airportPoint(const Airport *airport) {
+    Waypoint *&point = _airportPoints[airport->label];
+    if (point == 0 || point->lat != airport->lat || point->lon != airport->lon) {
+        // a moved airport gets a new one, pilots might still have the old one in their routes
+        point = new Waypoint(airport->label, airport->lat, airport->lon);
+    }
+    return point;
 }
 
 void Airac::load() {
     qDebug() << "Airac::load()" << Settings::navdataDirectory();
     GuiMessages::status("Loading navigation database...", "airacload");
+    const QString dataVersion = Settings::useNavdata()? dataVersionOf(Settings::navdataDirectory()): QString("none");
+    if (dataVersion != _dataVersion) {
+        // the cached routes are point indices of the navdata they were resolved with
+        saveRouteCache();
+        _routeCache.clear();
+        _dataVersion = dataVersion;
+        _routeCache.read(RouteCache::defaultFileName(), _dataVersion);
+    }
     if (Settings::useNavdata()) {
-        readFixes(Settings::navdataDirectory());
-        readNavaids(Settings::navdataDirectory());
-        readAirways(Settings::navdataDirectory());
+        QElapsedTimer timer;
+        timer.start();
+        AiracCache cache(Settings::navdataDirectory());
+        forgetPoints();
+        if (cache.read(_store, airways)) {
+            _airwayGraph.build(_store.size(), airways);
+            qDebug() << "Airac::load() read" << cache.fileName() << "in" << timer.elapsed() << "ms";
+        } else {
+            readFromText(Settings::navdataDirectory());
+            cache.write(_store, airways);
+            qDebug() << "Airac::load() parsed navdata and wrote" << cache.fileName()
+                     << "in" << timer.elapsed() << "ms";
+        }
     }
 
-    allPoints.clear();
-    allPoints.reserve(fixes.size() + navaids.size());
-    foreach (const QSet<Waypoint*> &wl, fixes.values())
-        foreach(Waypoint *w, wl)
-            allPoints.insert(w);
-    foreach (const QSet<NavAid*> &nl, navaids.values())
-        foreach(NavAid *n , nl)
-            allPoints.insert(n);
+    buildIndices();
 
     GuiMessages::remove("airacload");
     emit loaded();
     qDebug() << "Airac::load() -- finished";
 }
 
-void Airac::readFixes(const QString& directory) {
-    fixes.clear();
+/**
+  The data cycle from the header of earth_fix.dat, with size and time of the
+  navdata files for hand-edited data.
+**/
+QString Airac::dataVersionOf(const QString &directory) {
+    QString result;
+    QFile file(directory + "/earth_fix.dat");
+    if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        // 2nd line: "1100 Version - data cycle 1802, build 20180215, ..."
+        file.readLine();
+        QRegExp cycle("data cycle (\\d+)");
+        if (cycle.indexIn(QString::fromLatin1(file.readLine())) >= 0) {
+            result = cycle.cap(1);
+        }
+    }
+    foreach (const QString &name, QStringList() << "earth_fix.dat" << "earth_nav.dat" << "earth_awy.dat") {
+        const QFileInfo info(directory + "/" + name);
+        result += QString(" %1:%2").arg(info.size()).arg(info.lastModified().toMSecsSinceEpoch());
+    }
+    return result;
+}
+
+void Airac::saveRouteCache() const {
+    if (_dataVersion.isEmpty() || _routeCache.stats().inserts == 0) {
+        return; // nothing new since read()
+    }
+    _routeCache.write(RouteCache::defaultFileName(), _dataVersion);
+}
+
+bool Airac::cachedFlightplan(quint64 key, QList<Waypoint*> &result) {
+    RouteCache::Route route;
+    if (!_routeCache.find(key, route)) {
+        return false;
+    }
+    QList<Waypoint*> waypoints;
+    waypoints.reserve(route.points.size());
+    foreach (const qint32 index, route.points) {
+        if (index >= _store.size() || -1 - index >= route.extras.size()) {
+            return false; // from other navdata
+        }
+        waypoints.append(index >= 0? point(index): extraPoint(route.extras[-1 - index]));
+    }
+    result = waypoints;
+    return true;
+}
+
+void Airac::cacheFlightplan(quint64 key, const QList<Waypoint*> &waypoints) {
+    RouteCache::Route route;
+    route.points.reserve(waypoints.size());
+    foreach (const Waypoint *w, waypoints) {
+        const QHash<const Waypoint*, int>::const_iterator it = _handleIndices.constFind(w);
+        if (it != _handleIndices.constEnd()) {
+            route.points.append(it.value());
+        } else {
+            const RouteCache::Extra extra = { w->label, w->lat, w->lon };
+            route.points.append(-1 - route.extras.size());
+            route.extras.append(extra);
+        }
+    }
+    _routeCache.insert(key, route);
+}
+
+// the airport or generated fix a route was resolved to
+Waypoint *Airac::extraPoint(const RouteCache::Extra &extra) {
+    const Airport *airport = NavData::instance()->airports.value(extra.ident, 0);
+    if (airport != 0 && airport->lat == extra.lat && airport->lon == extra.lon) {
+        return airportPoint(airport);
+    }
+    Waypoint *&fix = _generatedFixes[extra.ident];
+    if (fix == 0) {
+        fix = new Waypoint(extra.ident, extra.lat, extra.lon);
+    }
+    return fix;
+}
 
+void Airac::buildIndices() {
+    QElapsedTimer timer;
+    timer.start();
+    QList<const NavStore::Point*> points;
+    points.reserve(_store.size());
+    QHash<QString, QList<const NavStore::Point*> > crowded;
+    for (int i = 0; i < _store.size(); i++)
+        points.append(&_store.point(i));
+    // the points of one ident are one range in the store
+    for (int begin = 0, end = 0; begin < _store.size(); begin = end) {
+        end = _store.identRange(_store.ident(begin)).second;
+        if (end - begin > identIndexThreshold)
+            crowded.insert(_store.ident(begin), points.mid(begin, end - begin));
+    }
+    _pointIndex.build(points);
+    _identIndex.buildGroups(crowded);
+    qDebug() << "Airac::buildIndices()" << _pointIndex.size() << "points," << crowded.size()
+             << "shared idents in" << timer.elapsed() << "ms";
+}
+
+QList<Waypoint*> Airac::nearestPoints(double lat, double lon, int k, double maxDist) const {
+    QList<Waypoint*> result;
+    foreach (const NavStore::Point *p, _pointIndex.kNearest(lat, lon, k, maxDist))
+        result.append(point(_store.indexOf(p)));
+    return result;
+}
+
+void Airac::readFromText(const QString &directory) {
+    forgetPoints();
+    readFixes(directory);
+    readNavaids(directory);
+    _store.finish();
+    readAirways(directory);
+}
+
+void Airac::readFixes(const QString& directory) {
     const QString file(directory + "/earth_fix.dat");
     FileReader fr(file);
 
@@ -71,6 +259,7 @@ void Airac::readFixes(const QString& directory) {
         qCritical() << file << "is not in X-Plane version 11 data format";
     }
 
+    int count = 0;
     while(!fr.atEnd()) {
         // file format:
         //  49.862241667    9.348325000  SPESA ENRT ED 4530243
@@ -84,19 +273,18 @@ void Airac::readFixes(const QString& directory) {
         if(line == "99")
             break;
 
-        Waypoint *wp = new Waypoint(line.split(' ', Qt::SkipEmptyParts));
-        if (wp == 0 || wp->isNull())
+        const Waypoint wp(line.split(' ', Qt::SkipEmptyParts));
+        if (wp.isNull())
             continue;
 
-        fixes[wp->label].insert(wp);
+        _store.appendFix(wp.label, wp.lat, wp.lon, wp.regionCode);
+        count++;
     }
     qDebug() << "Read fixes from" << (directory + "/earth_fix.dat")
-             << "-" << fixes.size() << "imported";
+             << "-" << count << "imported";
 }
 
 void Airac::readNavaids(const QString& directory) {
-    navaids.clear();
-
     const QString file(directory + "/earth_nav.dat");
     FileReader fr(file);
 
@@ -108,6 +296,7 @@ void Airac::readNavaids(const QString& directory) {
         qCritical() << file << "is not in X-Plane version 11 data format";
     }
 
+    int count = 0;
     while(!fr.atEnd()) {
         // file format:
         //  3  52.721000000   -8.885222222      200    11330   130     -4.000  SHA ENRT EI SHANNON VOR/DME
@@ -121,14 +310,16 @@ void Airac::readNavaids(const QString& directory) {
         if(line == "99")
             break;
 
-        NavAid *nav = new NavAid(line.split(' ', Qt::SkipEmptyParts));
-        if (nav == 0 || nav->isNull())
+        const NavAid nav(line.split(' ', Qt::SkipEmptyParts));
+        if (nav.isNull())
             continue;
 
-        navaids[nav->label].insert(nav);
+        _store.appendNavaid(nav.label, nav.lat, nav.lon, nav.regionCode, nav.type(), nav.freq(),
+                            nav.hdg(), nav.name());
+        count++;
     }
     qDebug() << "Read navaids from" << (directory + "/earth_nav.dat")
-            << "-" << navaids.size() << "imported";
+            << "-" << count << "imported";
 }
 
 void Airac::readAirways(const QString& directory) {
@@ -148,7 +339,9 @@ void Airac::readAirways(const QString& directory) {
     }
 
     bool ok;
-    int segments = 0;
+    QStringList names;
+    QHash<QString, quint32> nameIndices;
+    QVector<AirwayGraph::Segment> segments;
     while(!fr.atEnd()) {
         QString line = fr.nextLine().trimmed();
         // file format:
@@ -175,8 +368,8 @@ void Airac::readAirways(const QString& directory) {
             qCritical() << "Airac::readAirways() unable to parse fix type (int):" << list;
             continue;
         }
-        Waypoint *start = waypoint(id, regionCode, fixType);
-        if(start == 0){
+        const int start = _store.find(id, regionCode, fixType);
+        if(start < 0){
             qCritical() << "Airac::readAirways() unable to find start waypoint:" << list;
             continue;
         }
@@ -188,46 +381,28 @@ void Airac::readAirways(const QString& directory) {
             qCritical() << "Airac::readAirways() unable to parse fix type (int):" << list;
             continue;
         }
-        Waypoint *end = waypoint(id, regionCode, fixType);
-        if(end == 0){
+        const int end = _store.find(id, regionCode, fixType);
+        if(end < 0){
             qCritical() << "Airac::readAirways() unable to find end waypoint:" << list;
             continue;
         }
 
-        QStringList names;
-        names = list[10].split('-', Qt::SkipEmptyParts);
-        for(int i = 0; i < names.size(); i++) {
-            addAirwaySegment(start, end, names[i]);
-            segments++;
+        foreach (const QString &name, list[10].split('-', Qt::SkipEmptyParts)) {
+            QHash<QString, quint32>::const_iterator it = nameIndices.constFind(name);
+            if (it == nameIndices.constEnd()) {
+                it = nameIndices.insert(name, names.size());
+                names.append(name);
+            }
+            const AirwayGraph::Segment segment = { start, end, it.value() };
+            segments.append(segment);
         }
     }
 
-    QHash<QString, QList<Airway*> >::iterator iter;
-    for(iter = airways.begin(); iter != airways.end(); ++iter) {
-        QList<Airway*>& list = iter.value();
-        const QList<Airway*> sorted = list[0]->sort();
-        delete list[0];
-        list = sorted;
-    }
+    _airwayGraph.build(_store.size(), names, segments);
+    airways = _airwayGraph.chains(_store);
 
     qDebug() << "Read airways from" << (directory + "/earth_awy.dat")
-            << "-" << airways.size() << "airways," << segments << "segments imported and sorted";
-}
-
-Waypoint* Airac::waypoint(const QString &id, const QString &regionCode, const int &type) const{
-    Waypoint *result = 0;
-    if (type == 11){
-        foreach(Waypoint *w, fixes[id]){
-            if(w->regionCode == regionCode)
-               return w;
-        }
-    } else {
-        foreach(NavAid *n, navaids[id]){
-            if (n->regionCode == regionCode)
-                return n;
-        }
-    }
-    return result;
+            << "-" << airways.size() << "airways," << segments.size() << "segments imported and sorted";
 }
 
 /**
@@ -242,27 +417,32 @@ Waypoint* Airac::waypointNearby(const QString& input, double lat, double lon, do
     Waypoint *result = 0;
     double minDist = 99999;
 
-    foreach (NavAid *n, navaids[input]) {
-        double d = NavData::distance(lat, lon, n->lat, n->lon);
-        if ((d < minDist) && (d < maxDist)) {
-            result = n;
-            minDist = d;
+    int found = -1;
+    if (_identIndex.hasGroup(input)) { // idents like "ALPHA" that exist all over the world
+        const NavStore::Point *p = _identIndex.nearestInGroup(input, lat, lon, maxDist);
+        if (p != 0) {
+            found = _store.indexOf(p);
+            minDist = NavData::distance(lat, lon, p->lat, p->lon);
         }
-    }
-    foreach (Waypoint *w, fixes[input]) {
-        double d = NavData::distance(lat, lon, w->lat, w->lon);
-        if ((d < minDist) && (d < maxDist)) {
-            result = w;
-            minDist = d;
+    } else {
+        const QPair<int, int> range = _store.identRange(input);
+        for (int i = range.first; i < range.second; i++) {
+            const NavStore::Point &p = _store.point(i);
+            double d = NavData::distance(lat, lon, p.lat, p.lon);
+            if ((d < minDist) && (d < maxDist)) {
+                found = i;
+                minDist = d;
+            }
         }
     }
+    if (found >= 0)
+        result = point(found);
     if (NavData::instance()->airports.contains(input)) { // trying aerodromes
         double d = NavData::distance(lat, lon,
-                                     NavData::instance()->airports[input]->lat,
-                                     NavData::instance()->airports[input]->lon);
+                                     NavData::instance()->airports.value(input)->lat,
+                                     NavData::instance()->airports.value(input)->lon);
         if ((d < minDist) && (d < maxDist)) {
-            result = new Waypoint(input, NavData::instance()->airports[input]->lat,
-                                  NavData::instance()->airports[input]->lon);
+            result = airportPoint(NavData::instance()->airports.value(input));
             minDist = d;
         }
     }
@@ -324,32 +504,24 @@ Waypoint* Airac::waypointNearby(const QString& input, double lat, double lon, do
                 foundId = NavData::toEurocontrol(foundLat, foundLon);
             }
 
-            if (fixes.contains(foundId)) {
-                auto founds = fixes.value(foundId).values();
-                if (founds.size() > 0) {
-                    return founds.at(0);
-                }
+            const QPair<int, int> range = _store.identRange(foundId);
+            if (range.first != range.second) {
+                return point(range.first);
+            }
+            if (_generatedFixes.contains(foundId)) {
+                return _generatedFixes.value(foundId);
             }
 
             result = new Waypoint(foundId, foundLat, foundLon);
             // we add it to our database
             // @todo consider if this is a good idea here
-            fixes[foundId].insert(result);
+            _generatedFixes.insert(foundId, result);
         }
     }
 
     return result;
 }
 
-Airway* Airac::airway(const QString& name) {
-    foreach(Airway *a, airways[name])
-        return a;
-
-    Airway* awy = new Airway(name);
-    airways[name].append(awy);
-    return awy;
-}
-
 Airway* Airac::airwayNearby(const QString& name, double lat, double lon) const {
     const QList<Airway*> list = airways[name];
     if(list.isEmpty())
@@ -360,10 +532,11 @@ Airway* Airac::airwayNearby(const QString& name, double lat, double lon) const {
     double minDist = 9999;
     Airway* result = 0;
     foreach(Airway *aw, list) {
-        Waypoint* wp = aw->closestPointTo(lat, lon);
-        if(wp == 0)
+        const int closest = aw->closestPointTo(_store, lat, lon);
+        if(closest < 0)
             continue;
-        double d = NavData::distance(lat, lon, wp->lat, wp->lon);
+        const NavStore::Point &wp = _store.point(closest);
+        double d = NavData::distance(lat, lon, wp.lat, wp.lon);
         if(qFuzzyIsNull(d))
             return aw;
         if(d < minDist) {
@@ -374,11 +547,6 @@ Airway* Airac::airwayNearby(const QString& name, double lat, double lon) const {
     return result;
 }
 
-void Airac::addAirwaySegment(Waypoint *from, Waypoint *to, const QString& name) {
-    Airway *awy = airway(name);
-    awy->addSegment(from, to);
-}
-
 /**
 * Returns a list of waypoints for the given planned route, starting at lat/lon.
 * Airways along the route will be replaced by the appropriate fixes along that
@@ -406,8 +574,8 @@ QList<Waypoint*> Airac::resolveFlightplan(QStringList plan, double lat, double l
             Waypoint* wp = waypointNearby(endId, lat, lon);
             if(wp != 0) {
                 if (currPoint != 0) {
-                    auto _expand = awy->expand(currPoint->label, wp->label);
-                    result.append(_expand);
+                    foreach (int index, awy->expand(_store, currPoint->label, wp->label))
+                        result.append(point(index));
                 }
                 currPoint = wp;
                 lat = wp->lat;
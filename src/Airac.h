@@ -8,6 +8,13 @@
 #include "Waypoint.h"
 #include "NavAid.h"
 #include "Airway.h"
+#include "AirwayGraph.h"
+#include "NavStore.h"
+#include "SpatialIndex.h"
+#include "RouteCache.h"
+
+class Airport;
+class RouteFinder;
 
 class Airac : public QObject {
         Q_OBJECT
@@ -15,30 +22,67 @@ class Airac : public QObject {
         static Airac *instance(bool createIfNoInstance = true);
         virtual ~Airac();
 
-        Waypoint* waypoint(const QString &id, const QString &regionCode, const int &type) const;
+        // the Waypoint or NavAid of a NavStore point, made on first use and kept until clear()
+        Waypoint* point(int index) const;
+        const NavStore &store() const { return _store; }
+        const AirwayGraph &airwayGraph() const { return _airwayGraph; }
+        // made from the airway graph on first use, until the navdata changes
+        RouteFinder *routeFinder();
+
         Waypoint* waypointNearby(const QString &id, double lat, double lon, double maxDist);
+        // the k fixes and navaids closest to lat/lon within maxDist (nm), closest first
+        QList<Waypoint*> nearestPoints(double lat, double lon, int k, double maxDist) const;
 
-        Airway* airway(const QString& name);
         Airway* airwayNearby(const QString& name, double lat, double lon) const;
 
         QList<Waypoint*> resolveFlightplan(QStringList plan, double lat, double lon);
+        // what resolveFlightplan() gave for key before, see RouteCache::key(). false if nothing.
+        bool cachedFlightplan(quint64 key, QList<Waypoint*> &result);
+        void cacheFlightplan(quint64 key, const QList<Waypoint*> &waypoints);
+        const RouteCache &routeCache() const { return _routeCache; }
+        // identifies the loaded navdata for the route cache
+        QString dataVersion() const { return _dataVersion; }
+        // the Waypoint of an airport in routes, made on first use and kept until clear()
+        Waypoint *airportPoint(const Airport *airport);
+
+        // parses the X-Plane files in directory, without AiracCache
+        void readFromText(const QString &directory);
+        void clear();
 
-        QSet<Waypoint*> allPoints;
-        QHash<QString, QSet<Waypoint*> > fixes;
-        QHash<QString, QSet<NavAid*> > navaids;
         QHash<QString, QList<Airway*> > airways;
     public slots:
         void load();
+        void saveRouteCache() const;
     signals:
         void loaded();
     private:
+        friend class Benchmark; // times readAirways()
         Airac();
         void readFixes(const QString &directory);
         void readNavaids(const QString &directory);
         void readAirways(const QString &directory);
-        void addAirwaySegment(Waypoint* from, Waypoint* to, const QString &name);
 
         QString fpTokenToWaypoint(QString token) const;
+        static QString dataVersionOf(const QString &directory);
+        Waypoint *extraPoint(const RouteCache::Extra &extra);
+        void buildIndices();
+        void forgetPoints();
+
+        NavStore _store;
+        AirwayGraph _airwayGraph;
+        RouteFinder *_routeFinder;
+        mutable QHash<int, Waypoint*> _handles;
+        mutable QHash<const Waypoint*, int> _handleIndices; // the other way round, for the route cache
+        // coordinates that were resolved to new fixes by waypointNearby()
+        QHash<QString, Waypoint*> _generatedFixes;
+        QHash<QString, Waypoint*> _airportPoints;
+        RouteCache _routeCache;
+        QString _dataVersion;
+
+        SpatialIndex<const NavStore::Point> _pointIndex;
+        // one tree per ident that is shared by more than identIndexThreshold points
+        SpatialIndex<const NavStore::Point> _identIndex;
+        static const int identIndexThreshold = 4;
 };
 
 #endif /* AIRAC_H_ */
@@ -0,0 +1,275 @@
+/**************************************************************************
+ *  This file is part of QuteScoop. See README for license
+ **************************************************************************/
+
+#include "AiracCache.h"
+
+#include "Settings.h"
+
+#include <cstring>
+
+static const quint32 cacheMagic = 0x51534143; // "QSAC"
+static const quint32 cacheVersion = 2;
+static const char *sourceFiles[] = { "earth_fix.dat", "earth_nav.dat", "earth_awy.dat" };
+
+AiracCache::AiracCache(const QString &navdataDirectory, const QString &fileName) :
+    _directory(navdataDirectory),
+    _fileName(fileName)
+{
+}
+
+QString AiracCache::defaultFileName() {
+    return Settings::dataDirectory("cache/airac.navcache");
+}
+
+template<typename T>
+static void copyArray(QVector<T> &vector, const uchar *data, int count) {
+    vector.resize(count);
+    memcpy(vector.data(), data, count * sizeof(T));
+}
+
+qint64 AiracCache::recordSize(SectionType type) {
+    switch (type) {
+        case PointSection: return sizeof(NavStore::Point);
+        case NavaidSection: return sizeof(NavStore::NavaidData);
+        case AirwaySection: return sizeof(AirwayChain);
+        case IdentCharSection: case StringSection: return 1;
+        default: return sizeof(quint32);
+    }
+}
+
+bool AiracCache::sourceStatus(Source *sources, bool withHash) const {
+    for (int i = 0; i < sourceCount; i++) {
+        QFileInfo info(QDir(_directory).filePath(sourceFiles[i]));
+        if (!info.exists()) {
+            return false;
+        }
+        sources[i].size = info.size();
+        sources[i].modifiedMsecs = info.lastModified().toMSecsSinceEpoch();
+        memset(sources[i].md5, 0, sizeof(sources[i].md5));
+        if (withHash) {
+            QFile file(info.filePath());
+            QCryptographicHash hash(QCryptographicHash::Md5);
+            if (!file.open(QIODevice::ReadOnly) || !hash.addData(&file)) {
+                return false;
+            }
+            memcpy(sources[i].md5, hash.result().constData(), sizeof(sources[i].md5));
+        }
+    }
+    return true;
+}
+
+bool AiracCache::read(NavStore &store, QHash<QString, QList<Airway*> > &airways) {
+    store.clear();
+    airways.clear();
+
+    QFile file(_fileName);
+    if (!file.open(QIODevice::ReadOnly) || file.size() < (qint64) sizeof(Header)) {
+        return false;
+    }
+    const qint64 size = file.size();
+    uchar *map = file.map(0, size);
+    if (map == 0) {
+        return false;
+    }
+    const Header *header = reinterpret_cast<const Header*>(map);
+
+    // cheap checks first, the hashes read all source files
+    Source sources[sourceCount];
+    bool valid = header->magic == cacheMagic && header->version == cacheVersion
+            && sourceStatus(sources, false);
+    for (int i = 0; i < SectionCount && valid; i++) {
+        const Section &section = header->sections[i];
+        valid = section.offset >= (qint64) sizeof(Header) && section.count >= 0
+                && section.offset + section.count * recordSize((SectionType) i) <= size;
+    }
+    for (int i = 0; i < sourceCount && valid; i++) {
+        valid = sources[i].size == header->sources[i].size
+                && sources[i].modifiedMsecs == header->sources[i].modifiedMsecs;
+    }
+    valid = valid && sourceStatus(sources, true);
+    for (int i = 0; i < sourceCount && valid; i++) {
+        valid = memcmp(sources[i].md5, header->sources[i].md5, sizeof(sources[i].md5)) == 0;
+    }
+    if (!valid) {
+        qDebug() << "AiracCache::read()" << _fileName << "is missing or does not match" << _directory;
+        file.unmap(map);
+        return false;
+    }
+
+    auto sectionData = [&](SectionType type) -> const uchar* {
+        return map + header->sections[type].offset;
+    };
+    auto sectionCount = [&](SectionType type) -> int {
+        return header->sections[type].count;
+    };
+    const uchar *strings = sectionData(StringSection);
+    const qint64 stringsSize = sectionCount(StringSection);
+    bool ok = true;
+    auto string = [&](quint32 offset) -> QString {
+        quint32 length = 0;
+        if (offset + (qint64) sizeof(length) <= stringsSize) {
+            memcpy(&length, strings + offset, sizeof(length));
+        }
+        if (offset + (qint64) sizeof(length) + 2 * (qint64) length > stringsSize) {
+            ok = false;
+            return QString();
+        }
+        return QString(reinterpret_cast<const QChar*>(strings + offset + sizeof(length)), length);
+    };
+    auto strings32 = [&](SectionType type) -> QStringList {
+        QStringList result;
+        const quint32 *offsets = reinterpret_cast<const quint32*>(sectionData(type));
+        for (int i = 0; i < sectionCount(type) && ok; i++) {
+            result.append(string(offsets[i]));
+        }
+        return result;
+    };
+
+    copyArray(store._points, sectionData(PointSection), sectionCount(PointSection));
+    copyArray(store._navaids, sectionData(NavaidSection), sectionCount(NavaidSection));
+    store._identChars = QByteArray(reinterpret_cast<const char*>(sectionData(IdentCharSection)),
+                                   sectionCount(IdentCharSection));
+    copyArray(store._identOffsets, sectionData(IdentOffsetSection), sectionCount(IdentOffsetSection));
+    copyArray(store._identBegin, sectionData(IdentBeginSection), sectionCount(IdentBeginSection));
+    store._regionCodes = strings32(RegionCodeSection);
+    store._names = strings32(NameSection);
+
+    // the store must be consistent, nothing later checks the indices again
+    const int pointCount = store._points.size(), identCount = store._identOffsets.size() - 1;
+    ok = ok && identCount >= 0 && store._identBegin.size() == identCount + 1
+            && store._identOffsets.last() == (quint32) store._identChars.size()
+            && store._identBegin.last() == (quint32) pointCount && !store._names.isEmpty();
+    for (int i = 0; i < identCount && ok; i++) {
+        ok = store._identOffsets[i] <= store._identOffsets[i + 1]
+                && store._identBegin[i] <= store._identBegin[i + 1];
+    }
+    for (int i = 0; i < pointCount && ok; i++) {
+        const NavStore::Point &p = store._points[i];
+        ok = (int) p.ident < identCount && p.regionCode < store._regionCodes.size()
+                && p.navaid < store._navaids.size()
+                && (p.navaid >= 0 || p.type == NavStore::fixType);
+    }
+    for (int i = 0; i < store._navaids.size() && ok; i++) {
+        ok = (int) store._navaids[i].name < store._names.size();
+    }
+    for (int i = 0; i < store._regionCodes.size() && ok; i++) {
+        store._regionCodeIndices.insert(store._regionCodes[i], i);
+    }
+
+    const AirwayChain *chains = reinterpret_cast<const AirwayChain*>(sectionData(AirwaySection));
+    const quint32 *chain = reinterpret_cast<const quint32*>(sectionData(ChainSection));
+    for (int i = 0; i < sectionCount(AirwaySection) && ok; i++) {
+        const AirwayChain &c = chains[i];
+        if ((qint64) c.first + c.count > sectionCount(ChainSection)) {
+            ok = false;
+            break;
+        }
+        QVector<int> points(c.count);
+        for (quint32 k = 0; k < c.count && ok; k++) {
+            const quint32 index = chain[c.first + k];
+            ok = index < (quint32) pointCount;
+            points[k] = index;
+        }
+        const QString name = string(c.name);
+        if (ok) {
+            airways[name].append(new Airway(name, points, store));
+        }
+    }
+    file.unmap(map);
+
+    if (!ok) {
+        qWarning() << "AiracCache::read()" << _fileName << "is broken";
+        foreach (const QList<Airway*> &list, airways) {
+            qDeleteAll(list);
+        }
+        store.clear();
+        airways.clear();
+        return false;
+    }
+    return true;
+}
+
+bool AiracCache::write(const NavStore &store, const QHash<QString, QList<Airway*> > &airways) {
+    Header header;
+    memset(&header, 0, sizeof(header));
+    header.magic = cacheMagic;
+    header.version = cacheVersion;
+    if (!sourceStatus(header.sources, true)) {
+        return false;
+    }
+
+    QByteArray strings;
+    QHash<QString, quint32> stringOffsets;
+    auto addString = [&](const QString &s) -> quint32 {
+        const QHash<QString, quint32>::const_iterator it = stringOffsets.constFind(s);
+        if (it != stringOffsets.constEnd()) {
+            return it.value();
+        }
+        const quint32 offset = strings.size();
+        const quint32 length = s.size();
+        strings.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        strings.append(reinterpret_cast<const char*>(s.constData()), 2 * length);
+        while (strings.size() % 4 != 0) {
+            strings.append('\0');
+        }
+        stringOffsets.insert(s, offset);
+        return offset;
+    };
+    QVector<quint32> regionCodes, names;
+    foreach (const QString &s, store._regionCodes) {
+        regionCodes.append(addString(s));
+    }
+    foreach (const QString &s, store._names) {
+        names.append(addString(s));
+    }
+
+    QVector<AirwayChain> chains;
+    QVector<quint32> chain;
+    foreach (const QList<Airway*> &list, airways) {
+        foreach (const Airway *awy, list) {
+            AirwayChain c = { addString(awy->name), (quint32) chain.size(), 0, 0 };
+            foreach (int index, awy->points()) {
+                chain.append(index);
+            }
+            c.count = chain.size() - c.first;
+            chains.append(c);
+        }
+    }
+
+    // sections one after the other behind the header, 8 byte aligned for the doubles
+    QByteArray body;
+    auto addSection = [&](SectionType type, const void *data, qint64 count) {
+        header.sections[type].offset = sizeof(Header) + body.size();
+        header.sections[type].count = count;
+        body.append(reinterpret_cast<const char*>(data), count * recordSize(type));
+        while (body.size() % 8 != 0) {
+            body.append('\0');
+        }
+    };
+    addSection(PointSection, store._points.constData(), store._points.size());
+    addSection(NavaidSection, store._navaids.constData(), store._navaids.size());
+    addSection(IdentCharSection, store._identChars.constData(), store._identChars.size());
+    addSection(IdentOffsetSection, store._identOffsets.constData(), store._identOffsets.size());
+    addSection(IdentBeginSection, store._identBegin.constData(), store._identBegin.size());
+    addSection(RegionCodeSection, regionCodes.constData(), regionCodes.size());
+    addSection(NameSection, names.constData(), names.size());
+    addSection(AirwaySection, chains.constData(), chains.size());
+    addSection(ChainSection, chain.constData(), chain.size());
+    addSection(StringSection, strings.constData(), strings.size());
+
+    QDir().mkpath(QFileInfo(_fileName).absolutePath());
+    QSaveFile file(_fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "AiracCache::write() could not open" << _fileName << file.errorString();
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(body);
+    if (!file.commit()) {
+        qWarning() << "AiracCache::write() could not write" << _fileName << file.errorString();
+        return false;
+    }
+    qDebug() << "AiracCache::write()" << _fileName << store.size() << "points," << chains.size() << "airways";
+    return true;
+}
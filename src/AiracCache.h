@@ -0,0 +1,60 @@
+/**************************************************************************
+ *  This file is part of QuteScoop. See README for license
+ **************************************************************************/
+
+#ifndef AIRACCACHE_H_
+#define AIRACCACHE_H_
+
+#include "Airway.h"
+#include "NavStore.h"
+
+#include <QtCore>
+
+/**
+  Compiled form of the X-Plane earth_fix.dat, earth_nav.dat and
+  earth_awy.dat of a navdata directory: the NavStore arrays as they are in
+  memory, the already sorted airway chains as point indices and one table
+  of UTF-16 strings. read() maps the file and copies the arrays back
+  without any text parsing or sorting.
+  The cache is only used when size, modification time and MD5 of all
+  three source files are the ones it was compiled from.
+**/
+class AiracCache {
+    public:
+        AiracCache(const QString &navdataDirectory, const QString &fileName = defaultFileName());
+        static QString defaultFileName();
+        QString fileName() const { return _fileName; }
+
+        // false if the cache is missing, outdated or broken. The containers are empty then.
+        bool read(NavStore &store, QHash<QString, QList<Airway*> > &airways);
+        bool write(const NavStore &store, const QHash<QString, QList<Airway*> > &airways);
+    private:
+        static const int sourceCount = 3;
+        struct Source {
+            qint64 size, modifiedMsecs;
+            char md5[16];
+        };
+        enum SectionType {
+            PointSection, NavaidSection, IdentCharSection, IdentOffsetSection, IdentBeginSection,
+            RegionCodeSection, NameSection, AirwaySection, ChainSection, StringSection, SectionCount
+        };
+        struct Section {
+            qint64 offset, count; // count in records, bytes for the identifiers and strings
+        };
+        struct Header {
+            quint32 magic, version;
+            Source sources[sourceCount];
+            Section sections[SectionCount];
+        };
+        struct AirwayChain {
+            quint32 name, first, count, reserved; // first: index into the chain array
+        };
+
+        static qint64 recordSize(SectionType type);
+        // size and time of the source files, MD5 only if withHash (it reads them)
+        bool sourceStatus(Source *sources, bool withHash) const;
+
+        QString _directory, _fileName;
+};
+
+#endif /* AIRACCACHE_H_ */
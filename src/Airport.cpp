@@ -6,8 +6,10 @@
 
 #include "helpers.h"
 #include "AirportDetails.h"
+#include "Geodesic.h"
 #include "Settings.h"
 #include "NavData.h"
+#include "StringPool.h"
 
 Airport::Airport(const QStringList& list, unsigned int debugLineNumber) :
         showRoutes(false),
@@ -23,7 +25,7 @@ Airport::Airport(const QStringList& list, unsigned int debugLineNumber) :
         exit(EXIT_FAILURE);
     }
 
-    label = list[0];
+    label = StringPool::intern(list[0]); // shared with the pilots' planDep/planDest
     name = list[1];
     city = list[2];
     countryCode = list[3];
@@ -41,6 +43,18 @@ Airport::Airport(const QStringList& list, unsigned int debugLineNumber) :
     lon = list[5].toDouble();
 }
 
+Airport::Airport(const QString &label, const QString &name, const QString &city, const QString &countryCode,
+                 double lat, double lon) :
+        name(name), city(city), countryCode(countryCode),
+        showRoutes(false),
+        _appDisplayList(0),
+        _twrDisplayList(0), _gndDisplayList(0), _delDisplayList(0) {
+    resetWhazzupStatus();
+    this->label = StringPool::intern(label);
+    this->lat = lat;
+    this->lon = lon;
+}
+
 Airport::~Airport() {
     if(_appDisplayList != 0) glDeleteLists(_appDisplayList, 1);
     if(_twrDisplayList != 0) glDeleteLists(_twrDisplayList, 1);
@@ -97,19 +111,19 @@ void Airport::appGl(const QColor &middleColor, const QColor &marginColor, const
             }
         }
     }
+    Geodesic::Points otherAirports;
+    foreach(auto *a, otherAirportsOfAppControllers) {
+        otherAirports.append(a->lat, a->lon);
+    }
+    const Geodesic::Vector center = Geodesic::vector(lat, lon);
 
+    Geodesic::Points fan;
+    Geodesic::circle(center, Airport::symbologyAppRadius_nm, 0., 10., 37, fan);
     glBegin(GL_TRIANGLE_FAN);
     glColor4f(middleColor.redF(), middleColor.greenF(), middleColor.blueF(), middleColor.alphaF());
     VERTEX(lat, lon);
-    for(short int i = 0; i <= 360; i += 10) {
-        auto _p = NavData::pointDistanceBearing(lat, lon, Airport::symbologyAppRadius_nm, i);
-
-        short int airportsClose = 0;
-        foreach(auto *a, otherAirportsOfAppControllers) {
-            auto _dist = NavData::distance(_p.first, _p.second, a->lat, a->lon);
-
-            airportsClose += _dist < Airport::symbologyAppRadius_nm;
-        }
+    for(int i = 0; i < fan.size(); i++) {
+        const int airportsClose = Geodesic::countWithin(fan.at(i), otherAirports, Airport::symbologyAppRadius_nm);
 
         if (airportsClose > 0) {
             // reduce opacity in overlap areas - https://github.com/qutescoop/qutescoop/issues/211
@@ -119,22 +133,17 @@ void Airport::appGl(const QColor &middleColor, const QColor &marginColor, const
             glColor4f(marginColor.redF(), marginColor.greenF(), marginColor.blueF(), marginColor.alphaF());
         }
 
-        VERTEX(_p.first,_p.second);
+        VERTEX(fan.lat(i), fan.lon(i));
     }
     glEnd();
 
+    Geodesic::Points border;
+    Geodesic::circle(center, Airport::symbologyAppRadius_nm, 0., 1., 361, border);
     glBegin(GL_LINE_STRIP);
     glLineWidth(borderLineWidth);
     glColor4f(borderColor.redF(), borderColor.greenF(), borderColor.blueF(), borderColor.alphaF());
-    for(short int i = 0; i <= 360; i += 1) {
-        auto _p = NavData::pointDistanceBearing(lat, lon, Airport::symbologyAppRadius_nm, i);
-
-        short int airportsClose = 0;
-        foreach(auto *a, otherAirportsOfAppControllers) {
-            auto _dist = NavData::distance(_p.first, _p.second, a->lat, a->lon);
-
-            airportsClose += _dist < Airport::symbologyAppRadius_nm;
-        }
+    for(int i = 0; i < border.size(); i++) {
+        const int airportsClose = Geodesic::countWithin(border.at(i), otherAirports, Airport::symbologyAppRadius_nm);
 
         if (airportsClose > 0) {
             // hide border line on overlap - https://github.com/qutescoop/qutescoop/issues/211
@@ -143,7 +152,7 @@ void Airport::appGl(const QColor &middleColor, const QColor &marginColor, const
             glColor4f(borderColor.redF(), borderColor.greenF(), borderColor.blueF(), borderColor.alphaF());
         }
 
-        VERTEX(_p.first,_p.second);
+        VERTEX(border.lat(i), border.lon(i));
     }
     glEnd();
 }
@@ -171,13 +180,14 @@ const GLuint& Airport::twrDisplayList() {
 
 
 void Airport::twrGl(const QColor &middleColor, const QColor &marginColor, const QColor &borderColor, const GLfloat &borderLineWidth) const {
+    Geodesic::Points circle;
+    Geodesic::circle(Geodesic::vector(lat, lon), Airport::symbologyTwrRadius_nm, 0., 10., 37, circle);
     glBegin(GL_TRIANGLE_FAN);
     glColor4f(middleColor.redF(), middleColor.greenF(), middleColor.blueF(), middleColor.alphaF());
     VERTEX(lat, lon);
     glColor4f(marginColor.redF(), marginColor.greenF(), marginColor.blueF(), marginColor.alphaF());
-    for(int i = 0; i <= 360; i += 10) {
-        auto _p = NavData::pointDistanceBearing(lat, lon, Airport::symbologyTwrRadius_nm, i);
-        VERTEX(_p.first,_p.second);
+    for(int i = 0; i < circle.size(); i++) {
+        VERTEX(circle.lat(i), circle.lon(i));
     }
     glEnd();
 
@@ -185,9 +195,8 @@ void Airport::twrGl(const QColor &middleColor, const QColor &marginColor, const
         glLineWidth(borderLineWidth);
         glBegin(GL_LINE_LOOP);
         glColor4f(borderColor.redF(), borderColor.greenF(), borderColor.blueF(), borderColor.alphaF());
-        for(int i = 0; i <= 360; i += 10) {
-            auto _p = NavData::pointDistanceBearing(lat, lon, Airport::symbologyTwrRadius_nm, i);
-            VERTEX(_p.first,_p.second);
+        for(int i = 0; i < circle.size(); i++) {
+            VERTEX(circle.lat(i), circle.lon(i));
         }
         glEnd();
     }
@@ -20,6 +20,8 @@ class Airport: public MapObject {
         const static int symbologyDelRadius_nm = 10;
 
         Airport(const QStringList &list, unsigned int debugLineNumber = 0);
+        Airport(const QString &label, const QString &name, const QString &city, const QString &countryCode,
+                double lat, double lon);
         ~Airport();
 
         virtual void showDetailsDialog();
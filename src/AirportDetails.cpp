@@ -197,8 +197,9 @@ void AirportDetails::onGotMetar(const QString &airportLabel, const QString &enco
 QSet<Controller*> AirportDetails::checkSectors() const {
     QSet<Controller*> result;
 
+    const QVector<Sector*> sectors = NavData::instance()->sectorIndex.sectorsAt(_airport->lat, _airport->lon);
     foreach(Controller *c, Whazzup::instance()->whazzupData().controllersWithSectors()) {
-        if(c->sector->containsPoint(QPointF(_airport->lat, _airport->lon)))
+        if(sectors.contains(c->sector))
             result.insert(c);
     }
     return result;
@@ -4,104 +4,23 @@
 
 #include "Airway.h"
 
-#include "NavData.h"
-
-Airway::Segment::Segment(Waypoint* from, Waypoint* to) {
-	this->from = from;
-	this->to = to;
-}
-
-bool Airway::Segment::operator==(const Airway::Segment& other) const {
-	return (from == other.from || from == other.to) &&
-			(to == other.from || to == other.to);
-}
-
-Airway::Airway(const QString& name) {
-	this->name = name;
-}
-
-void Airway::addSegment(Waypoint* from, Waypoint* to) {
-	Segment newSegment(from, to);
-	// check if we already have this segment
-	for(int i = 0; i < _segments.size(); i++) {
-		if(_segments[i].from == newSegment.from && _segments[i].to == newSegment.to) {
-			return;
-		}
+#include "helpers.h"
+
+Airway::Airway(const QString& name, const QVector<int>& points, const NavStore& store) :
+	name(name), _points(points) {
+	_positions.reserve(points.size());
+	for(int i = 0; i < points.size(); i++) {
+		const quint32 ident = store.point(points[i]).ident;
+		if(!_positions.contains(ident))
+			_positions.insert(ident, i);
 	}
-	_segments.append(newSegment);
 }
 
-Airway* Airway::createFromSegments() {
-	if(_segments.isEmpty())
-		return 0;
-
-	Airway* result = new Airway(name);
-	Segment seg = _segments.first();
-	_segments.removeFirst();
-	result->_waypoints.append(seg.from);
-	result->_waypoints.append(seg.to);
-
-	bool nothingRemoved = false;
-	while(!_segments.isEmpty() && !nothingRemoved) {
-		nothingRemoved = true;
-
-		for(int i = 0; i < _segments.size() && nothingRemoved; i++) {
-			Segment s = _segments[i];
-			Waypoint *p = result->_waypoints.last();
-
-			if(s.from == p) {
-				result->_waypoints.append(s.to);
-				_segments.removeAt(i);
-				nothingRemoved = false;
-				continue;
-			}
-			if(s.to == p) {
-				result->_waypoints.append(s.from);
-				_segments.removeAt(i);
-				nothingRemoved = false;
-				continue;
-			}
-
-			p = result->_waypoints.first();
-			if(s.from == p) {
-				result->_waypoints.prepend(s.to);
-				_segments.removeAt(i);
-				nothingRemoved = false;
-				continue;
-			}
-			if(s.to == p) {
-				result->_waypoints.prepend(s.from);
-				_segments.removeAt(i);
-				nothingRemoved = false;
-				continue;
-			}
-		}
-	}
-
-	return result;
-}
-
-QList<Airway*> Airway::sort() {
-	QList<Airway*> result;
-	if(_segments.isEmpty())
-		return result;
-	Airway *awy = 0;
-	do {
-		awy = createFromSegments();
-		if(awy != 0)
-			result.append(awy);
-	} while(awy != 0);
-
-        return result;
-}
-
-int Airway::index(const QString& id) const {
-	for(int i = 0; i < _waypoints.size(); i++) {
-		if(_waypoints[i]->label == id) {
-			return i;
-		}
-	}
-	return -1;
+int Airway::index(const NavStore& store, const QString& id) const {
+	const QPair<int, int> range = store.identRange(id);
+	if(range.first == range.second)
+		return -1;
+	return _positions.value(store.point(range.first).ident, -1);
 }
 
 /**
@@ -109,10 +28,10 @@ int Airway::index(const QString& id) const {
  * to end. The expanded list will not include the given start
  * point, but will include the given end point.
  */
-QList<Waypoint*> Airway::expand(const QString& startId, const QString& endId) const {
-	QList<Waypoint*> result;
-	int startIndex = index(startId);
-	int endIndex = index(endId);
+QVector<int> Airway::expand(const NavStore& store, const QString& startId, const QString& endId) const {
+	QVector<int> result;
+	int startIndex = index(store, startId);
+	int endIndex = index(store, endId);
 
 	if(startIndex < 0 || endIndex < 0)
 		return result;
@@ -123,21 +42,23 @@ QList<Waypoint*> Airway::expand(const QString& startId, const QString& endId) co
 
 	for(int i = startIndex; i != endIndex; i += direction)
 		if(i != startIndex)  // don't append first waypoint in list
-			result.append(_waypoints[i]);
-	result.append(_waypoints[endIndex]);
+			result.append(_points[i]);
+	result.append(_points[endIndex]);
 	return result;
 }
 
-Waypoint* Airway::closestPointTo(double lat, double lon) const {
-	Waypoint* result = 0;
-	double minDist = 9999.;
-	for(int i = 0; i < _waypoints.size(); i++) {
-		double d = NavData::distance(lat, lon, _waypoints[i]->lat, _waypoints[i]->lon);
-		if(qFuzzyIsNull(d))
-			return _waypoints[i];
-		if(d < minDist) {
-			minDist = d;
-			result = _waypoints[i];
+int Airway::closestPointTo(const NavStore& store, double lat, double lon) const {
+	// the closest point has the largest cosine of the central angle - no need for acos()
+	const double sinLat = qSin(lat * Pi180), cosLat = qCos(lat * Pi180);
+	int result = -1;
+	double maxCos = -2.;
+	for(int i = 0; i < _points.size(); i++) {
+		const NavStore::Point& p = store.point(_points[i]);
+		const double wLat = p.lat * Pi180;
+		double c = sinLat * qSin(wLat) + cosLat * qCos(wLat) * qCos((lon - p.lon) * Pi180);
+		if(c > maxCos) {
+			maxCos = c;
+			result = _points[i];
 		}
 	}
 	return result;
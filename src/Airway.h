@@ -5,36 +5,29 @@
 #ifndef AIRWAY_H_
 #define AIRWAY_H_
 
-#include "Waypoint.h"
+#include "NavStore.h"
 
+/**
+  An airway as a chain of NavStore point indices, see AirwayGraph::chains().
+  The position of an ident on the chain is looked up in a hash.
+**/
 class Airway {
     public:
-        Airway(const QString& name);
+        Airway(const QString& name, const QVector<int>& points, const NavStore& store);
         virtual ~Airway() {}
 
-        QList<Waypoint*> waypoints() const { return _waypoints; };
-        QList<Waypoint*> expand(const QString& startId, const QString& endId) const;
-        Waypoint* closestPointTo(double lat, double lon) const;
-        void addSegment(Waypoint* from, Waypoint* to);
-        QList<Airway*> sort();
+        QVector<int> points() const { return _points; };
+        QVector<int> expand(const NavStore& store, const QString& startId, const QString& endId) const;
+        // -1 if the airway is empty
+        int closestPointTo(const NavStore& store, double lat, double lon) const;
 
         QString name;
 
     private:
-        int index(const QString& id) const;
+        int index(const NavStore& store, const QString& id) const;
 
-        class Segment {
-            public:
-                Segment(Waypoint *from, Waypoint *to);
-                bool operator==(const Segment& other) const;
-                Waypoint *from;
-                Waypoint *to;
-        };
-
-        QList<Segment> _segments;
-        QList<Waypoint*> _waypoints;
-
-        Airway* createFromSegments();
+        QVector<int> _points;
+        QHash<quint32, int> _positions; // NavStore ident -> first position in _points
 };
 
 #endif /* AIRWAY_H_ */
@@ -0,0 +1,146 @@
+/**************************************************************************
+ *  This file is part of QuteScoop. See README for license
+ **************************************************************************/
+
+#include "AirwayGraph.h"
+
+#include <algorithm>
+
+AirwayGraph::AirwayGraph() {
+    clear();
+}
+
+void AirwayGraph::clear() {
+    _names.clear();
+    _edgeBegin = QVector<quint32>() << 0;
+    _edges.clear();
+}
+
+void AirwayGraph::build(int pointCount, const QStringList &names, const QVector<Segment> &segments) {
+    _names = names;
+
+    // counting sort of both directions of every segment by their start point
+    QVector<quint32> begin(pointCount + 1, 0);
+    foreach (const Segment &s, segments) {
+        begin[s.from + 1]++;
+        begin[s.to + 1]++;
+    }
+    for (int p = 0; p < pointCount; p++) {
+        begin[p + 1] += begin[p];
+    }
+    QVector<Edge> edges(begin[pointCount]);
+    QVector<quint32> fill = begin;
+    foreach (const Segment &s, segments) {
+        const Edge forward = { s.to, s.airway }, backward = { s.from, s.airway };
+        edges[fill[s.from]++] = forward;
+        edges[fill[s.to]++] = backward;
+    }
+
+    // drop duplicates within the (short) edge list of every point
+    _edgeBegin.resize(pointCount + 1);
+    _edges.clear();
+    _edges.reserve(edges.size());
+    _edgeBegin[0] = 0;
+    for (int p = 0; p < pointCount; p++) {
+        Edge *first = edges.data() + begin[p], *last = edges.data() + begin[p + 1];
+        std::sort(first, last, [](const Edge &a, const Edge &b) {
+            return a.airway < b.airway || (a.airway == b.airway && a.to < b.to);
+        });
+        for (Edge *e = first; e != last; ++e) {
+            if (e->to == p) { // a segment from a point to itself would not make a chain
+                continue;
+            }
+            if (_edges.size() > (int) _edgeBegin[p] && _edges.last().to == e->to
+                    && _edges.last().airway == e->airway) {
+                continue;
+            }
+            _edges.append(*e);
+        }
+        _edgeBegin[p + 1] = _edges.size();
+    }
+    _edges.squeeze();
+}
+
+void AirwayGraph::build(int pointCount, const QHash<QString, QList<Airway*> > &airways) {
+    QStringList names;
+    QVector<Segment> segments;
+    for (QHash<QString, QList<Airway*> >::const_iterator it = airways.constBegin(); it != airways.constEnd(); ++it) {
+        const quint32 airway = names.size();
+        names.append(it.key());
+        foreach (const Airway *awy, it.value()) {
+            const QVector<int> points = awy->points();
+            for (int i = 1; i < points.size(); i++) {
+                const Segment s = { points[i - 1], points[i], airway };
+                segments.append(s);
+            }
+        }
+    }
+    build(pointCount, names, segments);
+}
+
+/**
+  Every edge is walked once: a chain starts at an unused edge and grows at
+  its back, then at its front, as long as the end point has an unused edge
+  of the same airway. Points only have a few edges, so the search at each
+  end is short.
+**/
+QHash<QString, QList<Airway*> > AirwayGraph::chains(const NavStore &store) const {
+    QHash<QString, QList<Airway*> > result;
+    QVector<bool> used(_edges.size(), false);
+
+    // marks the edge from -> to of airway and its reverse, false if it was used already
+    auto take = [&](int from, int index) -> bool {
+        if (used[index]) {
+            return false;
+        }
+        used[index] = true;
+        const Edge &e = _edges[index];
+        for (quint32 r = _edgeBegin[e.to]; r < _edgeBegin[e.to + 1]; r++) {
+            if (_edges[r].to == from && _edges[r].airway == e.airway) {
+                used[r] = true;
+                break;
+            }
+        }
+        return true;
+    };
+    // the next unused edge of airway at point, -1 if there is none
+    auto next = [&](int point, quint32 airway) -> int {
+        for (quint32 i = _edgeBegin[point]; i < _edgeBegin[point + 1]; i++) {
+            if (!used[i] && _edges[i].airway == airway) {
+                return i;
+            }
+        }
+        return -1;
+    };
+
+    for (int p = 0; p < pointCount(); p++) {
+        for (quint32 i = _edgeBegin[p]; i < _edgeBegin[p + 1]; i++) {
+            if (!take(p, i)) {
+                continue;
+            }
+            const quint32 airway = _edges[i].airway;
+            QVector<int> back, front; // front in reverse order
+            back << p << _edges[i].to;
+            int end = back.last();
+            for (int e = next(end, airway); e >= 0; e = next(end, airway)) {
+                take(end, e);
+                end = _edges[e].to;
+                back.append(end);
+            }
+            end = p;
+            for (int e = next(end, airway); e >= 0; e = next(end, airway)) {
+                take(end, e);
+                end = _edges[e].to;
+                front.append(end);
+            }
+            std::reverse(front.begin(), front.end());
+            front += back;
+            result[_names[airway]].append(new Airway(_names[airway], front, store));
+        }
+    }
+    return result;
+}
+
+qint64 AirwayGraph::memoryUsage() const {
+    return _edgeBegin.capacity() * sizeof(quint32) + _edges.capacity() * sizeof(Edge);
+}
@@ -0,0 +1,54 @@
+/**************************************************************************
+ *  This file is part of QuteScoop. See README for license
+ **************************************************************************/
+
+#ifndef AIRWAYGRAPH_H_
+#define AIRWAYGRAPH_H_
+
+#include "Airway.h"
+#include "NavStore.h"
+
+/**
+  The airway segments of the AIRAC as an undirected graph over the NavStore
+  points, in adjacency arrays: the edges of point p are
+  edge(edgeRange(p).first) .. edge(edgeRange(p).second - 1), each labeled
+  with its airway name. Duplicate segments are dropped.
+  chains() walks the graph into the sorted airways in linear time.
+**/
+class AirwayGraph {
+    public:
+        struct Segment {
+            qint32 from, to;
+            quint32 airway; // index into the names of build()
+        };
+        struct Edge {
+            qint32 to;
+            quint32 airway;
+        };
+
+        AirwayGraph();
+
+        void build(int pointCount, const QStringList &names, const QVector<Segment> &segments);
+        // from the consecutive points of already sorted airways
+        void build(int pointCount, const QHash<QString, QList<Airway*> > &airways);
+        void clear();
+
+        int pointCount() const { return _edgeBegin.size() - 1; }
+        int edgeCount() const { return _edges.size(); } // both directions
+        QPair<int, int> edgeRange(int point) const {
+            return qMakePair((int) _edgeBegin[point], (int) _edgeBegin[point + 1]);
+        }
+        const Edge &edge(int index) const { return _edges[index]; }
+        QString airwayName(quint32 airway) const { return _names[airway]; }
+
+        // the airways as chains of connected points, a name can have more than one chain
+        QHash<QString, QList<Airway*> > chains(const NavStore &store) const;
+
+        qint64 memoryUsage() const;
+    private:
+        QStringList _names;
+        QVector<quint32> _edgeBegin; // per point into _edges, one more for the end
+        QVector<Edge> _edges;
+};
+
+#endif /* AIRWAYGRAPH_H_ */
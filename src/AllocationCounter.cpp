@@ -0,0 +1,76 @@
+/**************************************************************************
+ *  This file is part of QuteScoop. See README for license
+ **************************************************************************/
+
+#include "AllocationCounter.h"
+
+#include <cstdlib>
+#include <new>
+
+#ifdef QS_ALLOCATION_COUNTER
+
+static QAtomicInteger<quint64> allocationCount(0), deallocationCount(0);
+
+static void *countedAllocate(std::size_t size) {
+    allocationCount.fetchAndAddRelaxed(1);
+    void *p = std::malloc(size == 0? 1: size);
+    if (p == 0)
+        throw std::bad_alloc();
+    return p;
+}
+
+static void countedDeallocate(void *p) {
+    if (p == 0)
+        return;
+    deallocationCount.fetchAndAddRelaxed(1);
+    std::free(p);
+}
+
+void *operator new(std::size_t size) { return countedAllocate(size); }
+void *operator new[](std::size_t size) { return countedAllocate(size); }
+void *operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return countedAllocate(size);
+    } catch (...) {
+        return 0;
+    }
+}
+void *operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return countedAllocate(size);
+    } catch (...) {
+        return 0;
+    }
+}
+void operator delete(void *p) noexcept { countedDeallocate(p); }
+void operator delete[](void *p) noexcept { countedDeallocate(p); }
+void operator delete(void *p, const std::nothrow_t&) noexcept { countedDeallocate(p); }
+void operator delete[](void *p, const std::nothrow_t&) noexcept { countedDeallocate(p); }
+
+bool AllocationCounter::isEnabled() {
+    return true;
+}
+
+quint64 AllocationCounter::allocations() {
+    return allocationCount.loadRelaxed();
+}
+
+quint64 AllocationCounter::deallocations() {
+    return deallocationCount.loadRelaxed();
+}
+
+#else
+
+bool AllocationCounter::isEnabled() {
+    return false;
+}
+
+quint64 AllocationCounter::allocations() {
+    return 0;
+}
+
+quint64 AllocationCounter::deallocations() {
+    return 0;
+}
+
+#endif
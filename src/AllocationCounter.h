@@ -0,0 +1,24 @@
+/**************************************************************************
+ *  This file is part of QuteScoop. See README for license
+ **************************************************************************/
+
+#ifndef ALLOCATIONCOUNTER_H_
+#define ALLOCATIONCOUNTER_H_
+
+#include <QtCore>
+
+/**
+  Counts calls to the global operator new and delete (that is, C++ heap
+  allocations; Qt containers that malloc() directly are not included).
+  Only available when built with "qmake CONFIG+=allocation_counter", which
+  replaces the global operators. Otherwise isEnabled() is false and the
+  counts stay 0.
+**/
+class AllocationCounter {
+    public:
+        static bool isEnabled();
+        static quint64 allocations();
+        static quint64 deallocations();
+};
+
+#endif /*ALLOCATIONCOUNTER_H_*/
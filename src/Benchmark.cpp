@@ -0,0 +1,108 @@
+/**************************************************************************
+ *  This file is part of QuteScoop. See README for license
+ **************************************************************************/
+
+#include "Benchmark.h"
+
+/**
+  All benchmarks by name. input says what --input has to be, empty if it
+  is not used. The flags and the unit of --cycles are in the description.
+**/
+const QVector<Benchmark::Entry> &Benchmark::entries() {
+    static const QVector<Entry> table = {
+        // ingest
+        { "warp", "file", "Peak memory while switching warp on and off, based on the Whazzup file. "
+          "Flag deep-copies: deep copy the clients on every snapshot copy.",
+          [](const Options &o) { return warpMemory(o.input, o.cycles, o.flags.contains("deep-copies")); } },
+        { "update", "file", "Allocations of the Whazzup update cycle, based on the Whazzup file. "
+          "Flag no-arena: allocate the client objects on the heap one by one.",
+          [](const Options &o) { return updateAllocations(o.input, o.cycles, !o.flags.contains("no-arena")); } },
+        { "strings", "file", "Memory saved by interning the client strings of the Whazzup file.",
+          [](const Options &o) { return internedStrings(o.input); } },
+        { "pilot-scan", "", "Position scans over synthetic pilots through QHash and PilotTable.",
+          [](const Options &) { return pilotTableScan(); } },
+        { "archive", "directory", "Size and decode speed of the Whazzup archive against the raw *.whazzup "
+          "files in the directory.",
+          [](const Options &o) { return archive(o.input); } },
+        { "replay", "directory", "Feed the Whazzups in the directory through the ingest pipeline. "
+          "Flag percentiles: latency percentiles per stage instead of one line per snapshot.",
+          [](const Options &o) { return replay(o.input, o.flags.contains("percentiles")); } },
+        { "parser", "directory", "Parse the vatsim-data.json of each fixture in the directory (e.g. "
+          "tests/fixtures) with QJsonDocument and with the streaming parser, compare every client field.",
+          [](const Options &o) { return parser(o.input); } },
+        // navdata
+        { "airport-index", "", "Airport lookups through the spatial index against linear scans "
+          "(100 queries per cycle).",
+          [](const Options &o) { return airportIndex(o.cycles * 100); } },
+        { "sector-index", "", "Sector lookups through the sector index against Sector::containsPoint() "
+          "(1000 queries per cycle).",
+          [](const Options &o) { return sectorIndex(o.cycles * 1000); } },
+        { "search", "file", "Searches through the search index against SearchVisitor on the Whazzup file "
+          "(100 searches per cycle).",
+          [](const Options &o) { return search(o.input, o.cycles * 100); } },
+        { "geodesic", "", "The geodesic kernels against the former trigonometric formulas "
+          "(10000 pairs per cycle).",
+          [](const Options &o) { return geodesic(o.cycles * 10000); } },
+        { "airac", "directory", "Airac load times from the X-Plane files in the directory with and without "
+          "the cache.",
+          [](const Options &o) { return airacCache(o.input); } },
+        { "airways", "directory", "Reading the airways from the X-Plane files in the directory and expanding "
+          "airway tokens (1000 per cycle).",
+          [](const Options &o) { return airways(o.input, o.cycles * 1000); } },
+        { "routes", "directory", "Generating routes along the airways from the X-Plane files in the directory "
+          "(10 per cycle).",
+          [](const Options &o) { return routes(o.input, o.cycles * 10); } },
+    };
+    return table;
+}
+
+int Benchmark::run(const QString &name, const Options &options) {
+    if (name == "list") {
+        return list();
+    }
+    foreach (const Entry &entry, entries()) {
+        if (name != entry.name) {
+            continue;
+        }
+        if (*entry.input != '\0' && options.input.isEmpty()) {
+            QTextStream(stdout) << "--bench " << name << " needs --input <" << entry.input << ">" << Qt::endl;
+            return EXIT_FAILURE;
+        }
+        return entry.run(options);
+    }
+    QTextStream(stdout) << "No benchmark " << name << ", see --bench list" << Qt::endl;
+    return EXIT_FAILURE;
+}
+
+int Benchmark::list() {
+    QTextStream out(stdout);
+    foreach (const Entry &entry, entries()) {
+        out << entry.name;
+        if (*entry.input != '\0') {
+            out << " --input <" << entry.input << ">";
+        }
+        out << Qt::endl << "    " << entry.description << Qt::endl;
+    }
+    return EXIT_SUCCESS;
+}
+
+QString Benchmark::megabytes(qint64 bytes) {
+    return QString::number(bytes / 1048576., 'f', 1) + " MB";
+}
+
+qint64 Benchmark::percentile(const QVector<qint64> &sorted, double p) {
+    if (sorted.isEmpty()) {
+        return 0;
+    }
+    return sorted[qMin(sorted.size() - 1, (int) (p / 100. * sorted.size()))];
+}
+
+bool Benchmark::readFile(const QString &fileName, QByteArray &bytes) {
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        QTextStream(stdout) << "Could not open " << fileName << Qt::endl;
+        return false;
+    }
+    bytes = file.readAll();
+    return true;
+}
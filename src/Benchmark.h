@@ -0,0 +1,75 @@
+/**************************************************************************
+ *  This file is part of QuteScoop. See README for license
+ **************************************************************************/
+
+#ifndef BENCHMARK_H_
+#define BENCHMARK_H_
+
+#include <QtCore>
+
+/**
+  Headless measurements and checks, started from the command line with
+  --bench <name> (see main()). They are listed in one table in
+  Benchmark.cpp and implemented per subsystem: BenchmarkIngest.cpp for
+  decoding, merging and storing Whazzups, BenchmarkNav.cpp for navdata
+  lookups and routes. Results are written to stdout, the return value is
+  the exit code.
+**/
+class Benchmark {
+    public:
+        // what the command line passes on
+        struct Options {
+            QString input; // --input: the file or directory the benchmark reads
+            int cycles; // --cycles, scaled to its own unit by each benchmark
+            QStringList flags; // --flag: switches of single benchmarks
+        };
+
+        // runs the benchmark called name, "list" describes all of them
+        static int run(const QString &name, const Options &options);
+    private:
+        struct Entry {
+            const char *name, *input, *description;
+            int (*run)(const Options &options);
+        };
+        static const QVector<Entry> &entries();
+        static int list();
+
+        static QString megabytes(qint64 bytes);
+        static qint64 percentile(const QVector<qint64> &sorted, double p);
+        // false with a message on stdout if the file can not be read
+        static bool readFile(const QString &fileName, QByteArray &bytes);
+
+        // BenchmarkIngest.cpp
+        // peak RSS while switching warp on and off, based on a downloaded Whazzup
+        static int warpMemory(const QString &whazzupFile, int cycles, bool deepCopies);
+        // allocations and time of the Whazzup update cycle: decode, merge, release
+        static int updateAllocations(const QString &whazzupFile, int cycles, bool useArena);
+        // bytes of the interned client strings in one snapshot, with and without sharing
+        static int internedStrings(const QString &whazzupFile);
+        // full position scan over synthetic pilots: QHash of Pilot* vs PilotTable
+        static int pilotTableScan();
+        // size and decode speed of a WhazzupArchive against the raw *.whazzup files in a directory
+        static int archive(const QString &directory);
+        // feeds the snapshots of a directory through the ingest pipeline, per-stage timings
+        static int replay(const QString &directory, bool percentiles);
+        // the streaming Whazzup parser against the QJsonDocument one it replaced, on the fixtures in a directory
+        static int parser(const QString &directory);
+
+        // BenchmarkNav.cpp
+        // NavData::airportIndex against a linear scan over the airports: nearest within 3 NM, within 30 NM
+        static int airportIndex(int queries);
+        // NavData::sectorIndex against Sector::containsPoint() over all sectors
+        static int sectorIndex(int queries);
+        // NavData::searchIndex against SearchVisitor for type-ahead searches, based on a downloaded Whazzup
+        static int search(const QString &whazzupFile, int queries);
+        // Geodesic against the trigonometric formulas it replaced: deviations, scalar and batch timings
+        static int geodesic(int pairs);
+        // Airac load times from the X-Plane files in a directory: text, first load writing AiracCache, cached
+        static int airacCache(const QString &directory);
+        // Airac::readAirways() and Airway::expand() against the linear ident search it replaced
+        static int airways(const QString &directory, int tokens);
+        // RouteFinder::find() between random points on the airways of a directory, one and five routes
+        static int routes(const QString &directory, int queries);
+};
+
+#endif /*BENCHMARK_H_*/
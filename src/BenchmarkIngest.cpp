@@ -0,0 +1,760 @@
+/**************************************************************************
+ *  This file is part of QuteScoop. See README for license
+ **************************************************************************/
+
+#include "Benchmark.h"
+
+#include "AllocationCounter.h"
+#include "Airac.h"
+#include "ClientArena.h"
+#include "ClientRecords.h"
+#include "NavData.h"
+#include "Platform.h"
+#include "Settings.h"
+#include "StringPool.h"
+#include "Pilot.h"
+#include "Controller.h"
+#include "PilotTable.h"
+#include "WhazzupData.h"
+#include "WhazzupArchive.h"
+
+/**
+  Replays what Whazzup does when the user plays with the time warp:
+  warp to the time of the real data (the real snapshot becomes the predicted
+  view), warp a few minutes ahead, get new real data while the previous
+  snapshot is kept, warp off.
+  With deepCopies, every copy is detached like before copy-on-write.
+  Peak RSS only grows, so compare separate runs with and without.
+**/
+int Benchmark::warpMemory(const QString &whazzupFile, int cycles, bool deepCopies) {
+    QTextStream out(stdout);
+    QByteArray bytes;
+    if (!readFile(whazzupFile, bytes)) {
+        return EXIT_FAILURE;
+    }
+
+    // airports are needed to predict
+    NavData::instance()->load();
+
+    WhazzupData real(&bytes, WhazzupData::WHAZZUP, 0);
+    const WhazzupData update(&bytes, WhazzupData::WHAZZUP, 0);
+    if (real.isNull()) {
+        out << "Could not parse " << whazzupFile << Qt::endl;
+        return EXIT_FAILURE;
+    }
+
+    const qint64 baseline = Platform::peakRss();
+    QElapsedTimer timer;
+    timer.start();
+
+    WhazzupData predicted;
+    for (int i = 0; i < cycles; i++) {
+        predicted = real;
+        if (deepCopies)
+            predicted.detach();
+
+        predicted.updateFrom(WhazzupData(real.whazzupTime.addSecs(60 * (i % 30 + 1)), real));
+
+        WhazzupData previous(real);
+        if (deepCopies)
+            previous.detach();
+        real.updateFrom(update);
+
+        predicted = WhazzupData();
+    }
+
+    const qint64 elapsedMs = timer.elapsed();
+    const qint64 peak = Platform::peakRss();
+    out << "warp benchmark: " << (deepCopies? "deep copies": "copy-on-write") << ", "
+        << real.pilots.size() << " pilots, " << real.controllers.size() << " controllers, "
+        << cycles << " cycles" << Qt::endl;
+    out << "time:               " << elapsedMs << " ms, "
+        << QString::number((double) elapsedMs / qMax(cycles, 1), 'f', 1) << " ms/cycle" << Qt::endl;
+    out << "peak RSS before:    " << megabytes(baseline) << Qt::endl;
+    out << "peak RSS after:     " << megabytes(peak) << Qt::endl;
+    out << "peak RSS increase:  " << megabytes(peak - baseline) << Qt::endl;
+    return EXIT_SUCCESS;
+}
+
+/**
+  What every download does: decode a new snapshot, merge it into the real
+  data and release it. Heap allocations of the client objects themselves
+  are counted by the arenas; all C++ allocations are counted when built with
+  CONFIG+=allocation_counter.
+**/
+int Benchmark::updateAllocations(const QString &whazzupFile, int cycles, bool useArena) {
+    QTextStream out(stdout);
+    QByteArray bytes;
+    if (!readFile(whazzupFile, bytes)) {
+        return EXIT_FAILURE;
+    }
+
+    NavData::instance()->load();
+    ClientArena::setEnabled(useArena);
+
+    WhazzupData real(&bytes, WhazzupData::WHAZZUP, 0);
+    if (real.isNull()) {
+        out << "Could not parse " << whazzupFile << Qt::endl;
+        return EXIT_FAILURE;
+    }
+
+    const quint64 arenaAllocationsBefore = ClientArena::heapAllocations();
+    const quint64 allocationsBefore = AllocationCounter::allocations();
+    const quint64 deallocationsBefore = AllocationCounter::deallocations();
+    QElapsedTimer timer;
+    timer.start();
+
+    for (int i = 0; i < cycles; i++) {
+        WhazzupData update(&bytes, WhazzupData::WHAZZUP, 0);
+        real.updateFrom(update);
+    }
+
+    const qint64 elapsedMs = timer.elapsed();
+    const double n = qMax(cycles, 1);
+    out << "update benchmark: " << (useArena? "client arena": "client objects on the heap") << ", "
+        << real.pilots.size() << " pilots, " << real.controllers.size() << " controllers, "
+        << cycles << " cycles" << Qt::endl;
+    out << "time:                       " << QString::number(elapsedMs / n, 'f', 1) << " ms/cycle" << Qt::endl;
+    out << "client object allocations:  "
+        << QString::number((ClientArena::heapAllocations() - arenaAllocationsBefore) / n, 'f', 1) << "/cycle" << Qt::endl;
+    if (AllocationCounter::isEnabled()) {
+        out << "operator new calls:         "
+            << QString::number((AllocationCounter::allocations() - allocationsBefore) / n, 'f', 1) << "/cycle" << Qt::endl;
+        out << "operator delete calls:      "
+            << QString::number((AllocationCounter::deallocations() - deallocationsBefore) / n, 'f', 1) << "/cycle" << Qt::endl;
+    } else {
+        out << "(build with CONFIG+=allocation_counter to count all operator new/delete calls)" << Qt::endl;
+    }
+    return EXIT_SUCCESS;
+}
+
+/**
+  Adds up the storage of the interned client strings of one snapshot twice:
+  once as if every client had its own copy (before interning) and once per
+  distinct buffer, which is what is actually allocated.
+**/
+int Benchmark::internedStrings(const QString &whazzupFile) {
+    QTextStream out(stdout);
+    QByteArray bytes;
+    if (!readFile(whazzupFile, bytes)) {
+        return EXIT_FAILURE;
+    }
+
+    NavData::instance()->load();
+
+    WhazzupData real(&bytes, WhazzupData::WHAZZUP, 0);
+    if (real.isNull()) {
+        out << "Could not parse " << whazzupFile << Qt::endl;
+        return EXIT_FAILURE;
+    }
+
+    QList<QString> strings;
+    foreach (const Pilot *p, real.allPilots()) {
+        strings << p->label << p->homeBase << p->server
+                << p->planAircraft << p->planAircraftFaa << p->planAircraftFull
+                << p->planTAS << p->planDep << p->planAlt << p->planDest << p->planAltAirport
+                << p->planRevision << p->planFlighttype << p->planDeptime << p->planActtime
+                << p->transponder << p->transponderAssigned;
+    }
+    foreach (const Controller *c, real.controllers) {
+        strings << c->label << c->homeBase << c->server << c->frequency << c->atisCode;
+    }
+
+    qint64 unshared = 0, shared = 0;
+    QSet<const QChar*> buffers;
+    foreach (const QString &string, strings) {
+        const qint64 size = StringPool::storageBytes(string);
+        unshared += size;
+        if (size > 0 && !buffers.contains(string.constData())) {
+            buffers.insert(string.constData());
+            shared += size;
+        }
+    }
+
+    out << "string interning: " << real.pilots.size() << " pilots, "
+        << real.bookedPilots.size() << " booked pilots, " << real.controllers.size() << " controllers" << Qt::endl;
+    out << "interned fields:    " << strings.size() << ", " << buffers.size() << " distinct buffers, "
+        << StringPool::size() << " strings in the pool" << Qt::endl;
+    out << "without interning:  " << unshared << " bytes" << Qt::endl;
+    out << "with interning:     " << shared << " bytes" << Qt::endl;
+    out << "saved per snapshot: " << unshared - shared << " bytes ("
+        << QString::number(100. * (unshared - shared) / qMax(unshared, (qint64) 1), 'f', 1) << "%)" << Qt::endl;
+    return EXIT_SUCCESS;
+}
+
+/**
+  The scan of GLWidget::objectsAt(): count the pilots within a radius around
+  a point, once through the QHash of Pilot* and once through the PilotTable,
+  over 2k, 20k and 200k synthetic pilots spread over the globe.
+**/
+int Benchmark::pilotTableScan() {
+    QTextStream out(stdout);
+    QRandomGenerator random(42);
+    WhazzupData data;
+    data.whazzupTime = QDateTime::currentDateTimeUtc();
+
+    out << "pilot scan benchmark: pilots within 300 NM, ns per pilot" << Qt::endl;
+    out << "pilots    QHash<Pilot*>  PilotTable" << Qt::endl;
+    foreach (const int n, QList<int>({ 2000, 20000, 200000 })) {
+        ClientArena arena;
+        QHash<QString, Pilot*> pilots;
+        for (int i = 0; i < n; i++) {
+            QJsonObject json;
+            json["callsign"] = QString("SYN%1").arg(i);
+            json["latitude"] = random.bounded(180.) - 90.;
+            json["longitude"] = random.bounded(360.) - 180.;
+            json["altitude"] = random.bounded(45000);
+            json["groundspeed"] = random.bounded(600);
+            json["heading"] = random.bounded(360);
+            Pilot *p = arena.create<Pilot>(json, &data);
+            pilots[p->label] = p;
+        }
+        PilotTable table;
+        table.rebuild(pilots);
+
+        // about 20M pilot visits per variant
+        const int rounds = qMax(20000000 / n, 1);
+        const double radiusDegQuad = Nm2Deg(300.) * Nm2Deg(300.);
+        QElapsedTimer timer;
+
+        int hashHits = 0;
+        timer.start();
+        for (int r = 0; r < rounds; r++) {
+            const double lat = (r % 170) - 85., lon = (r * 7 % 360) - 180.;
+            foreach (const Pilot *p, pilots) {
+                const double x = p->lat - lat, y = p->lon - lon;
+                if (x * x + y * y < radiusDegQuad)
+                    hashHits++;
+            }
+        }
+        const qint64 hashNs = timer.nsecsElapsed();
+
+        int tableHits = 0;
+        timer.restart();
+        for (int r = 0; r < rounds; r++) {
+            const double lat = (r % 170) - 85., lon = (r * 7 % 360) - 180.;
+            const double *lats = table.lat.constData(), *lons = table.lon.constData();
+            for (int i = 0; i < table.size(); i++) {
+                const double x = lats[i] - lat, y = lons[i] - lon;
+                if (x * x + y * y < radiusDegQuad)
+                    tableHits++;
+            }
+        }
+        const qint64 tableNs = timer.nsecsElapsed();
+
+        const double visits = (double) rounds * n;
+        out << QString("%1 %2 %3").arg(n, -9).arg(hashNs / visits, 13, 'f', 2).arg(tableNs / visits, 11, 'f', 2)
+            << (hashHits == tableHits? "": "  (hit counts differ!)") << Qt::endl;
+
+        foreach (const Pilot *p, pilots) {
+            arena.destroy(p);
+        }
+    }
+    return EXIT_SUCCESS;
+}
+
+/**
+  Writes all raw Whazzups of a directory into a temporary archive, then
+  compares the sizes (also against zlib on every raw file) and the time
+  to get a WhazzupData from the raw JSON and from the archive. Archive
+  reads are single lookups, which decode from the last keyframe.
+**/
+int Benchmark::archive(const QString &directory) {
+    QTextStream out(stdout);
+    QDir dir(directory);
+    QStringList files = dir.entryList(QStringList("*.whazzup"), QDir::Files | QDir::Readable, QDir::Name);
+    if (files.isEmpty()) {
+        out << "No *.whazzup files in " << directory << Qt::endl;
+        return EXIT_FAILURE;
+    }
+    QTemporaryDir tempDir;
+    if (!tempDir.isValid()) {
+        out << "Could not create a temporary directory" << Qt::endl;
+        return EXIT_FAILURE;
+    }
+    WhazzupArchive archive(tempDir.filePath("bench" + WhazzupArchive::suffix));
+
+    qint64 rawBytes = 0, zlibBytes = 0, rawParseNs = 0, writeNs = 0;
+    QList<QDateTime> times;
+    QList<int> clients;
+    QElapsedTimer timer;
+    foreach (const QString &filename, files) {
+        QFile file(dir.filePath(filename));
+        if (!file.open(QIODevice::ReadOnly)) {
+            continue;
+        }
+        QByteArray bytes = file.readAll();
+        rawBytes += bytes.size();
+        zlibBytes += qCompress(bytes, 9).size();
+
+        timer.start();
+        WhazzupData data(&bytes, WhazzupData::WHAZZUP, 0);
+        rawParseNs += timer.nsecsElapsed();
+        if (data.isNull()) {
+            continue;
+        }
+
+        timer.start();
+        if (archive.append(bytes, data.whazzupTime)) {
+            writeNs += timer.nsecsElapsed();
+            times << data.whazzupTime;
+            clients << data.pilots.size() + data.bookedPilots.size() + data.controllers.size();
+        }
+    }
+
+    qint64 archiveParseNs = 0;
+    int mismatches = 0;
+    for (int i = 0; i < times.size(); i++) {
+        timer.start();
+        const WhazzupData data = WhazzupArchive(archive.fileName()).whazzupData(times[i]);
+        archiveParseNs += timer.nsecsElapsed();
+        if (data.whazzupTime != times[i]
+                || data.pilots.size() + data.bookedPilots.size() + data.controllers.size() != clients[i]) {
+            mismatches++;
+        }
+    }
+
+    const qint64 archiveBytes = QFileInfo(archive.fileName()).size();
+    const double n = qMax(times.size(), 1);
+    out << "archive benchmark: " << files.size() << " raw files, " << times.size() << " snapshots archived, "
+        << "keyframe every " << WhazzupArchive::keyframeInterval << Qt::endl;
+    out << "raw:                " << megabytes(rawBytes) << Qt::endl;
+    out << "zlib per file:      " << megabytes(zlibBytes) << ", ratio "
+        << QString::number((double) rawBytes / qMax(zlibBytes, (qint64) 1), 'f', 1) << Qt::endl;
+    out << "archive:            " << megabytes(archiveBytes) << ", ratio "
+        << QString::number((double) rawBytes / qMax(archiveBytes, (qint64) 1), 'f', 1) << Qt::endl;
+    out << "append:             " << QString::number(writeNs / n / 1e6, 'f', 1) << " ms/snapshot" << Qt::endl;
+    out << "WhazzupData from raw:     " << QString::number(rawParseNs / qMax(files.size(), 1) / 1e6, 'f', 1)
+        << " ms/snapshot" << Qt::endl;
+    out << "WhazzupData from archive: " << QString::number(archiveParseNs / n / 1e6, 'f', 1)
+        << " ms/snapshot" << Qt::endl;
+    if (mismatches > 0) {
+        out << mismatches << " snapshots did not rebuild to the same time and client count!" << Qt::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+/**
+  What the GUI does with every download, without any widgets: decode the
+  snapshot, merge it into the real data, update the airports in NavData and
+  resolve the routes of the pilots (cached per pilot and in the route cache
+  of Airac as in the GUI, which starts with the routes of the last session).
+  Each decode reuses the ClientRecords of the one before, as
+  WhazzupDecoder does.
+  Snapshots are raw *.whazzup files and WhazzupArchive frames of the
+  directory, in time order.
+**/
+int Benchmark::replay(const QString &directory, bool percentiles) {
+    QTextStream out(stdout);
+    QDir dir(directory);
+    if (!dir.exists()) {
+        out << "No directory " << directory << Qt::endl;
+        return EXIT_FAILURE;
+    }
+
+    // snapshot time and where to get it from: a raw file, or an archive
+    struct Snapshot {
+        QDateTime time;
+        QString fileName;
+        QList<WhazzupArchive::Frame> chain;
+    };
+    QList<Snapshot> snapshots;
+    QRegExp dtRe("_(\\d{8}-\\d{6})\\.whazzup$"); // dateTime: 20110301-191050
+    foreach (const QFileInfo &file, dir.entryInfoList(QStringList("*.whazzup"), QDir::Files | QDir::Readable)) {
+        Snapshot snapshot;
+        if (dtRe.indexIn(file.fileName()) >= 0) {
+            snapshot.time = QDateTime::fromString(dtRe.cap(1), "yyyyMMdd-HHmmss");
+            snapshot.time.setTimeSpec(Qt::UTC);
+        }
+        snapshot.fileName = file.filePath();
+        snapshots.append(snapshot);
+    }
+    foreach (const QFileInfo &file, dir.entryInfoList(QStringList("*" + WhazzupArchive::suffix),
+                                                      QDir::Files | QDir::Readable)) {
+        QList<WhazzupArchive::Frame> chain;
+        foreach (const WhazzupArchive::Frame &frame, WhazzupArchive(file.filePath()).frames()) {
+            if (frame.isKeyframe) {
+                chain.clear();
+            }
+            chain.append(frame);
+            Snapshot snapshot;
+            snapshot.time = frame.time;
+            snapshot.fileName = file.filePath();
+            snapshot.chain = chain;
+            snapshots.append(snapshot);
+        }
+    }
+    std::stable_sort(snapshots.begin(), snapshots.end(),
+                     [](const Snapshot &a, const Snapshot &b) { return a.time < b.time; });
+    if (snapshots.isEmpty()) {
+        out << "No *.whazzup or *" << WhazzupArchive::suffix << " files in " << directory << Qt::endl;
+        return EXIT_FAILURE;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    NavData::instance()->load();
+    Airac::instance()->load();
+    out << "replay: " << snapshots.size() << " snapshots, navdata loaded in " << timer.elapsed() << " ms"
+        << (Settings::useNavdata()? "": " (navdata disabled in the settings, routes are not resolved)")
+        << Qt::endl;
+
+    const QStringList stages({ "read", "decode", "updateFrom", "NavData", "routes", "total" });
+    QVector<QVector<qint64> > ns(stages.size());
+    WhazzupData real;
+    QSharedPointer<const ClientRecords> records; // of the last snapshot, as WhazzupDecoder keeps them
+    ClientRecords::Counts pilotCounts, controllerCounts;
+    foreach (const Snapshot &snapshot, snapshots) {
+        QVector<qint64> stageNs(stages.size());
+        timer.start();
+        QByteArray bytes;
+        if (snapshot.chain.isEmpty()) {
+            QFile file(snapshot.fileName);
+            if (file.open(QIODevice::ReadOnly)) {
+                bytes = file.readAll();
+            }
+        } else {
+            bytes = WhazzupArchive(snapshot.fileName).whazzupJson(snapshot.chain);
+        }
+        stageNs[0] = timer.nsecsElapsed();
+
+        timer.start();
+        const WhazzupData data(&bytes, WhazzupData::WHAZZUP, 0, records);
+        stageNs[1] = timer.nsecsElapsed();
+        if (data.isNull()) {
+            out << "skipping " << snapshot.fileName << " " << snapshot.time.toString(Qt::ISODate)
+                << ": could not parse" << Qt::endl;
+            continue;
+        }
+        records = data.records();
+        pilotCounts.records += records->pilotCounts().records;
+        pilotCounts.unchanged += records->pilotCounts().unchanged;
+        pilotCounts.liveChanged += records->pilotCounts().liveChanged;
+        controllerCounts.records += records->controllerCounts().records;
+        controllerCounts.unchanged += records->controllerCounts().unchanged;
+        controllerCounts.liveChanged += records->controllerCounts().liveChanged;
+
+        timer.start();
+        real.updateFrom(data);
+        stageNs[2] = timer.nsecsElapsed();
+
+        timer.start();
+        NavData::instance()->updateData(real);
+        stageNs[3] = timer.nsecsElapsed();
+
+        timer.start();
+        int waypoints = 0;
+        foreach (Pilot *p, real.pilots) {
+            waypoints += p->routeWaypoints().size();
+        }
+        stageNs[4] = timer.nsecsElapsed();
+
+        for (int i = 0; i < stages.size() - 1; i++) {
+            stageNs[stages.size() - 1] += stageNs[i];
+        }
+        for (int i = 0; i < stages.size(); i++) {
+            ns[i].append(stageNs[i]);
+        }
+
+        if (!percentiles) {
+            const WhazzupData::Delta &delta = real.lastDelta();
+            out << real.whazzupTime.toString(Qt::ISODate) << ": "
+                << real.pilots.size() << " pilots (" << delta.addedPilots.size() << " added, "
+                << delta.flightplanChangedPilots.size() << " new flightplans), "
+                << real.controllers.size() << " controllers, " << waypoints << " route points;";
+            for (int i = 0; i < stages.size(); i++) {
+                out << " " << stages[i] << " " << QString::number(stageNs[i] / 1e6, 'f', 1) << " ms";
+            }
+            out << "; " << records->summary() << Qt::endl;
+        }
+    }
+
+    if (percentiles) {
+        out << QString("%1 %2 %3 %4 %5 %6").arg("stage [ms]", -12).arg("p50", 9).arg("p90", 9)
+               .arg("p99", 9).arg("max", 9).arg("mean", 9) << Qt::endl;
+        for (int i = 0; i < stages.size(); i++) {
+            QVector<qint64> sorted = ns[i];
+            std::sort(sorted.begin(), sorted.end());
+            qint64 sum = 0;
+            foreach (const qint64 v, sorted) {
+                sum += v;
+            }
+            out << QString("%1 %2 %3 %4 %5 %6").arg(stages[i], -12)
+                   .arg(percentile(sorted, 50) / 1e6, 9, 'f', 2)
+                   .arg(percentile(sorted, 90) / 1e6, 9, 'f', 2)
+                   .arg(percentile(sorted, 99) / 1e6, 9, 'f', 2)
+                   .arg((sorted.isEmpty()? 0: sorted.last()) / 1e6, 9, 'f', 2)
+                   .arg(sum / qMax(sorted.size(), 1) / 1e6, 9, 'f', 2) << Qt::endl;
+        }
+    }
+    if (pilotCounts.records > 0 || controllerCounts.records > 0) {
+        out << "reused: " << pilotCounts.unchanged << " unchanged and " << pilotCounts.liveChanged << " moved of "
+            << pilotCounts.records << " pilots ("
+            << QString::number(100. * (pilotCounts.unchanged + pilotCounts.liveChanged) / qMax(pilotCounts.records, 1), 'f', 1)
+            << "%), " << controllerCounts.unchanged << " unchanged and " << controllerCounts.liveChanged
+            << " with new ATIS of " << controllerCounts.records << " controllers ("
+            << QString::number(100. * (controllerCounts.unchanged + controllerCounts.liveChanged)
+                               / qMax(controllerCounts.records, 1), 'f', 1)
+            << "%)" << Qt::endl;
+    }
+    const RouteCache &routeCache = Airac::instance()->routeCache();
+    out << "route cache: " << routeCache.stats().hits << " hits, " << routeCache.stats().misses << " misses ("
+        << QString::number(100. * routeCache.stats().hitRate(), 'f', 1) << "%), " << routeCache.size()
+        << " routes with " << routeCache.points() << " points" << Qt::endl;
+    return ns[0].isEmpty()? EXIT_FAILURE: EXIT_SUCCESS;
+}
+
+/**
+  The Whazzup parsing WhazzupData did before JsonStreamReader, kept as a
+  reference: the whole document as a QJsonDocument, then the sections in
+  a fixed order. The clients are not stored in data's arena, the caller
+  deletes them.
+**/
+static bool domWhazzup(const QByteArray &bytes, WhazzupData &data, QList<Client*> &clients) {
+    const QJsonDocument document = QJsonDocument::fromJson(bytes);
+    if (document.isNull()) {
+        return false;
+    }
+    QJsonObject json = document.object();
+    if (json.contains("general") && json["general"].isObject()) {
+        QJsonObject generalObject = json["general"].toObject();
+        if (generalObject.contains("update_timestamp") && generalObject["update_timestamp"].isString()) {
+            data.whazzupTime = QDateTime::fromString(generalObject["update_timestamp"].toString(), Qt::ISODate);
+        }
+    }
+    if (!data.whazzupTime.isValid()) {
+        data.whazzupTime = QDateTime::currentDateTime();
+    }
+    if (json.contains("servers") && json["servers"].isArray()) {
+        foreach (const QJsonValue &value, json["servers"].toArray()) {
+            QJsonObject serverObject = value.toObject();
+            if (
+                serverObject.contains("ident") && serverObject["ident"].isString()
+                && serverObject.contains("hostname_or_ip") && serverObject["hostname_or_ip"].isString()
+                && serverObject.contains("location") && serverObject["location"].isString()
+                && serverObject.contains("name") && serverObject["name"].isString()
+                && serverObject.contains("clients_connection_allowed") && serverObject["clients_connection_allowed"].isDouble()
+            ) {
+                QStringList server;
+                server.append(serverObject["ident"].toString());
+                server.append(serverObject["hostname_or_ip"].toString());
+                server.append(serverObject["location"].toString());
+                server.append(serverObject["name"].toString());
+                server.append(serverObject["clients_connection_allowed"].toString());
+                data.servers += server;
+            }
+        }
+    }
+    foreach (const QString &section, QStringList({ "pilots", "controllers", "atis", "prefiles" })) {
+        if (!json.contains(section) || !json[section].isArray()) {
+            continue;
+        }
+        foreach (const QJsonValue &value, json[section].toArray()) {
+            if (section == "pilots" || section == "prefiles") {
+                Pilot *p = new Pilot(value.toObject(), &data);
+                (section == "pilots"? data.pilots: data.bookedPilots)[p->label] = p;
+                clients << p;
+            } else {
+                Controller *c = new Controller(value.toObject(), &data);
+                data.controllers[c->label] = c;
+                clients << c;
+            }
+        }
+    }
+    return true;
+}
+
+namespace {
+    // collects the fields of one client that the two parsers made different
+    class FieldComparison {
+        public:
+            explicit FieldComparison(const QString &client) : _client(client) {}
+
+            template <typename T>
+            void compare(const char *field, const T &dom, const T &stream) {
+                if (!(dom == stream)) {
+                    QString difference;
+                    QDebug(&difference) << _client << field << dom << "!=" << stream;
+                    _differences << difference;
+                }
+            }
+            const QStringList &differences() const { return _differences; }
+        private:
+            QString _client;
+            QStringList _differences;
+    };
+}
+
+static void compareClient(FieldComparison &c, const Client *dom, const Client *stream) {
+    c.compare("label", dom->label, stream->label);
+    c.compare("lat", dom->lat, stream->lat);
+    c.compare("lon", dom->lon, stream->lon);
+    c.compare("drawLabel", dom->drawLabel, stream->drawLabel);
+    c.compare("realName", dom->realName(), stream->realName());
+    c.compare("userId", dom->userId, stream->userId);
+    c.compare("homeBase", dom->homeBase, stream->homeBase);
+    c.compare("server", dom->server, stream->server);
+    c.compare("timeConnected", dom->timeConnected, stream->timeConnected);
+    c.compare("rating", dom->rating, stream->rating);
+}
+
+static QStringList comparePilot(const QString &section, const Pilot *dom, const Pilot *stream) {
+    FieldComparison c(section + "/" + dom->label);
+    compareClient(c, dom, stream);
+    c.compare("planAircraft", dom->planAircraft, stream->planAircraft);
+    c.compare("planAircraftFaa", dom->planAircraftFaa, stream->planAircraftFaa);
+    c.compare("planAircraftFull", dom->planAircraftFull, stream->planAircraftFull);
+    c.compare("planTAS", dom->planTAS, stream->planTAS);
+    c.compare("planDep", dom->planDep, stream->planDep);
+    c.compare("planAlt", dom->planAlt, stream->planAlt);
+    c.compare("planDest", dom->planDest, stream->planDest);
+    c.compare("planAltAirport", dom->planAltAirport, stream->planAltAirport);
+    c.compare("planRevision", dom->planRevision, stream->planRevision);
+    c.compare("planFlighttype", dom->planFlighttype, stream->planFlighttype);
+    c.compare("planDeptime", dom->planDeptime, stream->planDeptime);
+    c.compare("planActtime", dom->planActtime, stream->planActtime);
+    c.compare("transponder", dom->transponder, stream->transponder);
+    c.compare("transponderAssigned", dom->transponderAssigned, stream->transponderAssigned);
+    c.compare("planRemarks", dom->planRemarks, stream->planRemarks);
+    c.compare("planRoute", dom->planRoute, stream->planRoute);
+    c.compare("dayOfFlight", dom->dayOfFlight, stream->dayOfFlight);
+    c.compare("altitude", dom->altitude, stream->altitude);
+    c.compare("groundspeed", dom->groundspeed, stream->groundspeed);
+    c.compare("planEnroute_hrs", dom->planEnroute_hrs, stream->planEnroute_hrs);
+    c.compare("planEnroute_mins", dom->planEnroute_mins, stream->planEnroute_mins);
+    c.compare("planFuel_hrs", dom->planFuel_hrs, stream->planFuel_hrs);
+    c.compare("planFuel_mins", dom->planFuel_mins, stream->planFuel_mins);
+    c.compare("qnh_mb", dom->qnh_mb, stream->qnh_mb);
+    c.compare("trueHeading", dom->trueHeading, stream->trueHeading);
+    c.compare("qnh_inHg", dom->qnh_inHg, stream->qnh_inHg);
+    c.compare("whazzupTime", dom->whazzupTime, stream->whazzupTime);
+    c.compare("airline", dom->airline, stream->airline);
+    c.compare("depAirport", dom->depAirport(), stream->depAirport());
+    c.compare("destAirport", dom->destAirport(), stream->destAirport());
+    c.compare("altAirport", dom->altAirport(), stream->altAirport());
+    c.compare("distanceFromDeparture", dom->distanceFromDeparture(), stream->distanceFromDeparture());
+    c.compare("distanceToDestination", dom->distanceToDestination(), stream->distanceToDestination());
+    c.compare("plannedDistance", dom->plannedDistance(), stream->plannedDistance());
+    c.compare("flightStatus", (int) dom->flightStatus(), (int) stream->flightStatus());
+    c.compare("etd", dom->etd(), stream->etd());
+    c.compare("eta", dom->eta(), stream->eta());
+    c.compare("etaPlan", dom->etaPlan(), stream->etaPlan());
+    return c.differences();
+}
+
+static QStringList compareController(const Controller *dom, const Controller *stream) {
+    FieldComparison c((dom->isAtis()? "atis/": "controllers/") + dom->label);
+    compareClient(c, dom, stream);
+    c.compare("frequency", dom->frequency, stream->frequency);
+    c.compare("atisMessage", dom->atisMessage, stream->atisMessage);
+    c.compare("atisCode", dom->atisCode, stream->atisCode);
+    c.compare("facilityType", dom->facilityType, stream->facilityType);
+    c.compare("visualRange", dom->visualRange, stream->visualRange);
+    c.compare("assumeOnlineUntil", dom->assumeOnlineUntil, stream->assumeOnlineUntil);
+    c.compare("sector", dom->sector, stream->sector);
+    c.compare("facility", (int) dom->facility(), (int) stream->facility());
+    c.compare("controllerSectorName", dom->controllerSectorName(), stream->controllerSectorName());
+    c.compare("airports", dom->airports(), stream->airports());
+    return c.differences();
+}
+
+/**
+  Parses the vatsim-data.json of every fixture (tests/fixtures/<issue>/)
+  with domWhazzup() and with WhazzupData and compares the snapshots field
+  by field: the time, the servers and every pilot, prefile, controller and
+  ATIS. Fails on any difference.
+**/
+int Benchmark::parser(const QString &directory) {
+    QTextStream out(stdout);
+    QDir dir(directory);
+    const QStringList fixtures = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
+
+    NavData::instance()->load();
+    int checked = 0, clients = 0, differences = 0;
+    qint64 domNs = 0, streamNs = 0;
+    QElapsedTimer timer;
+    foreach (const QString &fixture, fixtures) {
+        QFile file(dir.filePath(fixture + "/vatsim-data.json"));
+        if (!file.open(QIODevice::ReadOnly)) {
+            continue;
+        }
+        QByteArray bytes = file.readAll();
+        file.close();
+
+        timer.start();
+        WhazzupData dom;
+        QList<Client*> domClients;
+        const bool domParsed = domWhazzup(bytes, dom, domClients);
+        domNs += timer.nsecsElapsed();
+
+        timer.start();
+        const WhazzupData stream(&bytes, WhazzupData::WHAZZUP, 0);
+        streamNs += timer.nsecsElapsed();
+
+        QStringList fixtureDifferences;
+        if (!domParsed || stream.isNull()) {
+            fixtureDifferences << QString("parsed: QJsonDocument %1, stream %2")
+                                  .arg(domParsed? "yes": "no", stream.isNull()? "no": "yes");
+        } else {
+            if (dom.whazzupTime != stream.whazzupTime) {
+                fixtureDifferences << "whazzupTime " + dom.whazzupTime.toString(Qt::ISODateWithMs)
+                                      + " != " + stream.whazzupTime.toString(Qt::ISODateWithMs);
+            }
+            if (dom.servers != stream.servers) {
+                fixtureDifferences << "servers";
+            }
+            auto comparePilots = [&fixtureDifferences](const QString &section, const QHash<QString, Pilot*> &domPilots,
+                                                       const QHash<QString, Pilot*> &streamPilots) {
+                foreach (const Pilot *p, domPilots) {
+                    const Pilot *streamPilot = streamPilots.value(p->label, 0);
+                    if (streamPilot == 0) {
+                        fixtureDifferences << section + "/" + p->label + " missing";
+                    } else {
+                        fixtureDifferences << comparePilot(section, p, streamPilot);
+                    }
+                }
+                if (streamPilots.size() != domPilots.size()) {
+                    fixtureDifferences << QString("%1: %2 != %3").arg(section).arg(domPilots.size())
+                                          .arg(streamPilots.size());
+                }
+            };
+            comparePilots("pilots", dom.pilots, stream.pilots);
+            comparePilots("prefiles", dom.bookedPilots, stream.bookedPilots);
+            foreach (const Controller *c, dom.controllers) {
+                const Controller *streamController = stream.controllers.value(c->label, 0);
+                if (streamController == 0) {
+                    fixtureDifferences << "controllers/" + c->label + " missing";
+                } else {
+                    fixtureDifferences << compareController(c, streamController);
+                }
+            }
+            if (stream.controllers.size() != dom.controllers.size()) {
+                fixtureDifferences << QString("controllers and atis: %1 != %2").arg(dom.controllers.size())
+                                      .arg(stream.controllers.size());
+            }
+            clients += stream.pilots.size() + stream.bookedPilots.size() + stream.controllers.size();
+        }
+        qDeleteAll(domClients);
+
+        checked++;
+        differences += fixtureDifferences.size();
+        out << fixture << ": " << (fixtureDifferences.isEmpty()? "same": "differs") << Qt::endl;
+        foreach (const QString &difference, fixtureDifferences) {
+            out << "  " << difference << Qt::endl;
+        }
+    }
+
+    if (checked == 0) {
+        out << "No */vatsim-data.json in " << directory << Qt::endl;
+        return EXIT_FAILURE;
+    }
+    out << "parser check: " << checked << " fixtures, " << clients << " clients" << Qt::endl;
+    out << "QJsonDocument: " << QString::number(domNs / checked / 1e6, 'f', 1) << " ms/fixture" << Qt::endl;
+    out << "stream:        " << QString::number(streamNs / checked / 1e6, 'f', 1) << " ms/fixture" << Qt::endl;
+    if (differences > 0) {
+        out << differences << " differences between the parsers!" << Qt::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,672 @@
+/**************************************************************************
+ *  This file is part of QuteScoop. See README for license
+ **************************************************************************/
+
+#include "Benchmark.h"
+
+#include "Airac.h"
+#include "Airport.h"
+#include "AiracCache.h"
+#include "Geodesic.h"
+#include "NavData.h"
+#include "Platform.h"
+#include "Pilot.h"
+#include "Controller.h"
+#include "RouteFinder.h"
+#include "SearchVisitor.h"
+#include "SectorIndex.h"
+#include "WhazzupData.h"
+#include "helpers.h"
+
+/**
+  Query points are taken at random airports (moved up to ~5 NM, like BUSH
+  pilots at their departure) and at random places. The linear scans are
+  the ones that were used before: the first airport in range for
+  NavData::airportAt(), all airports for picking.
+**/
+int Benchmark::airportIndex(int queries) {
+    QTextStream out(stdout);
+    NavData *navData = NavData::instance();
+    navData->load();
+    const QList<Airport*> airports = navData->airports.values();
+    if (airports.isEmpty()) {
+        out << "No airports loaded" << Qt::endl;
+        return EXIT_FAILURE;
+    }
+    QRandomGenerator random(42);
+    QVector<QPair<double, double> > points(queries);
+    for (int i = 0; i < queries; i++) {
+        if (i % 2 == 0) {
+            const Airport *a = airports[random.bounded(airports.size())];
+            points[i] = QPair<double, double>(a->lat + random.bounded(.16) - .08, a->lon + random.bounded(.16) - .08);
+        } else {
+            points[i] = QPair<double, double>(qRadiansToDegrees(qAsin(random.bounded(2.) - 1.)),
+                                              random.bounded(360.) - 180.);
+        }
+    }
+    QElapsedTimer timer;
+
+    timer.start();
+    SpatialIndex<Airport> index;
+    index.build(airports);
+    const qint64 buildMs = timer.elapsed();
+
+    int firstHits = 0;
+    timer.restart();
+    foreach (const DoublePair &q, points) {
+        foreach (Airport *a, airports) {
+            if (NavData::distance(a->lat, a->lon, q.first, q.second) <= 3.) {
+                firstHits++;
+                break;
+            }
+        }
+    }
+    const qint64 firstNs = timer.nsecsElapsed();
+
+    int indexHits = 0, mismatches = 0;
+    qint64 indexNs = 0;
+    foreach (const DoublePair &q, points) {
+        timer.restart();
+        const Airport *nearest = index.nearest(q.first, q.second, 3.);
+        indexNs += timer.nsecsElapsed();
+        indexHits += nearest != 0? 1: 0;
+        // the nearest by brute force, not timed
+        double minDist = 3.;
+        const Airport *expected = 0;
+        foreach (const Airport *a, airports) {
+            const double d = NavData::distance(a->lat, a->lon, q.first, q.second);
+            if (d <= minDist) {
+                minDist = d;
+                expected = a;
+            }
+        }
+        if (expected != nearest && (expected == 0 || nearest == 0
+                                    || qAbs(NavData::distance(nearest->lat, nearest->lon, q.first, q.second)
+                                            - minDist) > 1e-6)) {
+            mismatches++;
+        }
+    }
+
+    int scanWithin = 0, indexWithin = 0;
+    timer.restart();
+    foreach (const DoublePair &q, points) {
+        foreach (const Airport *a, airports) {
+            if (NavData::distance(a->lat, a->lon, q.first, q.second) <= 30.)
+                scanWithin++;
+        }
+    }
+    const qint64 scanWithinNs = timer.nsecsElapsed();
+    timer.restart();
+    foreach (const DoublePair &q, points) {
+        indexWithin += index.within(q.first, q.second, 30.).size();
+    }
+    const qint64 indexWithinNs = timer.nsecsElapsed();
+
+    const double n = qMax(queries, 1);
+    out << "airport index benchmark: " << airports.size() << " airports, " << queries << " queries, index built in "
+        << buildMs << " ms" << Qt::endl;
+    out << "airportAt, first within 3 NM (scan): " << QString::number(firstNs / n / 1000., 'f', 2) << " us/query, "
+        << firstHits << " hits" << Qt::endl;
+    out << "nearest within 3 NM (index):         " << QString::number(indexNs / n / 1000., 'f', 2) << " us/query, "
+        << indexHits << " hits" << Qt::endl;
+    out << "within 30 NM (scan):                 " << QString::number(scanWithinNs / n / 1000., 'f', 2)
+        << " us/query, " << scanWithin << " airports" << Qt::endl;
+    out << "within 30 NM (index):                " << QString::number(indexWithinNs / n / 1000., 'f', 2)
+        << " us/query, " << indexWithin << " airports" << Qt::endl;
+    if (mismatches > 0 || scanWithin != indexWithin) {
+        out << mismatches << " nearest airports differ from the brute force ones, within counts "
+            << (scanWithin == indexWithin? "match": "differ") << "!" << Qt::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+int Benchmark::sectorIndex(int queries) {
+    QTextStream out(stdout);
+    NavData *navData = NavData::instance();
+    navData->load();
+    const QList<Sector*> sectors = navData->sectors.values();
+    if (sectors.isEmpty()) {
+        out << "No sectors loaded" << Qt::endl;
+        return EXIT_FAILURE;
+    }
+    // half of the points close to sector outlines, the rest anywhere on the globe
+    QRandomGenerator random(42);
+    QVector<QPair<double, double> > points(queries);
+    for (int i = 0; i < queries; i++) {
+        const QList<QPair<double, double> > &outline = sectors[random.bounded(sectors.size())]->points();
+        if (i % 2 == 0 && !outline.isEmpty()) {
+            const QPair<double, double> &p = outline[random.bounded(outline.size())];
+            points[i] = QPair<double, double>(p.first + random.bounded(2.) - 1., p.second + random.bounded(2.) - 1.);
+        } else {
+            points[i] = QPair<double, double>(qRadiansToDegrees(qAsin(random.bounded(2.) - 1.)),
+                                              random.bounded(360.) - 180.);
+        }
+    }
+    QElapsedTimer timer;
+
+    timer.start();
+    SectorIndex index;
+    index.build(sectors);
+    const qint64 buildMs = timer.elapsed();
+
+    QVector<QVector<Sector*> > scanned(queries);
+    timer.restart();
+    for (int i = 0; i < queries; i++) {
+        foreach (Sector *sector, sectors) {
+            if (sector->containsPoint(QPointF(points[i].first, points[i].second)))
+                scanned[i].append(sector);
+        }
+    }
+    const qint64 scanNs = timer.nsecsElapsed();
+
+    QVector<QVector<Sector*> > indexed(queries);
+    timer.restart();
+    for (int i = 0; i < queries; i++) {
+        index.sectorsAt(points[i].first, points[i].second, indexed[i]);
+    }
+    const qint64 indexNs = timer.nsecsElapsed();
+
+    int hits = 0, mismatches = 0;
+    for (int i = 0; i < queries; i++) {
+        hits += scanned[i].size();
+        std::sort(scanned[i].begin(), scanned[i].end());
+        std::sort(indexed[i].begin(), indexed[i].end());
+        if (scanned[i] != indexed[i])
+            mismatches++;
+    }
+
+    const double n = qMax(queries, 1);
+    out << "sector index benchmark: " << sectors.size() << " sectors, " << index.size() << " polygons, " << queries
+        << " queries, index built in " << buildMs << " ms, " << index.memoryUsage() / 1024 << " KiB" << Qt::endl;
+    out << "Sector::containsPoint() (scan): " << QString::number(scanNs / n / 1000., 'f', 3) << " us/query, "
+        << hits << " sectors" << Qt::endl;
+    out << "sectorsAt() (index):            " << QString::number(indexNs / n / 1000., 'f', 3) << " us/query"
+        << Qt::endl;
+    if (mismatches > 0) {
+        out << mismatches << " queries found other sectors than the scan!" << Qt::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+// what the search dock shows for a result, to compare objects of both ways
+static QStringList searchResultKeys(const QList<MapObject*> &objects) {
+    QStringList result;
+    foreach (const MapObject *o, objects) {
+        result << o->label + "\t" + o->toolTip();
+    }
+    result.sort();
+    return result;
+}
+
+int Benchmark::search(const QString &whazzupFile, int queries) {
+    QTextStream out(stdout);
+    QByteArray bytes;
+    if (!readFile(whazzupFile, bytes)) {
+        return EXIT_FAILURE;
+    }
+
+    NavData *navData = NavData::instance();
+    navData->load();
+    const WhazzupData real(&bytes, WhazzupData::WHAZZUP, 0);
+    if (real.isNull()) {
+        out << "Could not parse " << whazzupFile << Qt::endl;
+        return EXIT_FAILURE;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    navData->searchIndex.updateClients(real);
+    const qint64 clientsMs = timer.elapsed();
+
+    // type-ahead: the first one to four characters of callsigns, airports and names, some with wildcards
+    QStringList words;
+    foreach (const Pilot *p, real.pilots) {
+        words << p->label << p->name();
+    }
+    foreach (const Controller *c, real.controllers) {
+        words << c->label;
+    }
+    foreach (const Airport *a, navData->airports) {
+        words << a->label << a->city;
+    }
+    words.removeAll(QString());
+    QRandomGenerator random(42);
+    QStringList searches;
+    for (int i = 0; i < queries && !words.isEmpty(); i++) {
+        QString search = words[random.bounded(words.size())].left(1 + random.bounded(4));
+        if (i % 10 == 0) {
+            search.insert(random.bounded(search.size() + 1), '*');
+        } else if (i % 10 == 1) {
+            search += " " + words[random.bounded(words.size())].left(2);
+        }
+        searches << search;
+    }
+
+    qint64 visitorNs = 0, indexNs = 0, maxIndexNs = 0;
+    int results = 0, mismatches = 0;
+    foreach (const QString &search, searches) {
+        timer.restart();
+        SearchVisitor visitor(search);
+        navData->accept(&visitor);
+        real.accept(&visitor);
+        const QList<MapObject*> visited = visitor.result();
+        visitorNs += timer.nsecsElapsed();
+
+        timer.restart();
+        const QList<MapObject*> indexed = navData->searchIndex.find(search, real);
+        const qint64 ns = timer.nsecsElapsed();
+        indexNs += ns;
+        maxIndexNs = qMax(maxIndexNs, ns);
+
+        results += indexed.size();
+        if (searchResultKeys(visited) != searchResultKeys(indexed)) {
+            mismatches++;
+            out << "differs: \"" << search << "\", " << visited.size() << " against " << indexed.size()
+                << " results" << Qt::endl;
+        }
+        foreach (MapObject *o, visited) { // SearchVisitor makes the airlines into new objects
+            if (dynamic_cast<Airport*>(o) == 0 && dynamic_cast<Client*>(o) == 0) {
+                delete o;
+            }
+        }
+    }
+
+    const double n = qMax(searches.size(), 1);
+    out << "search benchmark: " << navData->searchIndex.size() << " index entries, " << real.pilots.size()
+        << " pilots, " << real.controllers.size() << " controllers indexed in " << clientsMs << " ms, "
+        << searches.size() << " searches, " << QString::number(results / n, 'f', 1) << " results on average"
+        << Qt::endl;
+    out << "SearchVisitor: " << QString::number(visitorNs / n / 1000., 'f', 1) << " us/search" << Qt::endl;
+    out << "SearchIndex:   " << QString::number(indexNs / n / 1000., 'f', 1) << " us/search, slowest "
+        << QString::number(maxIndexNs / 1000., 'f', 1) << " us" << Qt::endl;
+    if (mismatches > 0) {
+        out << mismatches << " searches found other results than SearchVisitor!" << Qt::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+// the trigonometric formulas NavData used before Geodesic, to compare with
+static double formerDistance(double lat1, double lon1, double lat2, double lon2) {
+    lat1 *= Pi180; lon1 *= Pi180; lat2 *= Pi180; lon2 *= Pi180;
+    const double result = qAcos(qSin(lat1) * qSin(lat2) + qCos(lat1) * qCos(lat2) * qCos(lon1 - lon2));
+    return qIsNaN(result)? 0.: result * 60. / Pi180;
+}
+
+static double formerCourse(double lat1, double lon1, double lat2, double lon2) {
+    lat1 *= Pi180; lon1 *= Pi180; lat2 *= Pi180; lon2 *= Pi180;
+    const double d = qAcos(qSin(lat1) * qSin(lat2) + qCos(lat1) * qCos(lat2) * qCos(lon1 - lon2));
+    const double tc = qAcos((qSin(lat2) - qSin(lat1) * qCos(d)) / (qSin(d) * qCos(lat1)));
+    return 360. - (qSin(lon2 - lon1) < 0.? tc: 2 * M_PI - tc) / Pi180;
+}
+
+static DoublePair formerFraction(double lat1, double lon1, double lat2, double lon2, double f) {
+    lat1 *= Pi180; lon1 *= Pi180; lat2 *= Pi180; lon2 *= Pi180;
+    const double d = qAcos(qSin(lat1) * qSin(lat2) + qCos(lat1) * qCos(lat2) * qCos(lon1 - lon2));
+    const double A = qSin((1. - f) * d) / qSin(d), B = qSin(f * d) / qSin(d);
+    const double x = A * qCos(lat1) * qCos(lon1) + B * qCos(lat2) * qCos(lon2);
+    const double y = A * qCos(lat1) * qSin(lon1) + B * qCos(lat2) * qSin(lon2);
+    const double z = A * qSin(lat1) + B * qSin(lat2);
+    return DoublePair(qAtan2(z, qSqrt(x * x + y * y)) / Pi180, qAtan2(y, x) / Pi180);
+}
+
+static DoublePair formerDestination(double lat, double lon, double dist, double heading) {
+    lat *= Pi180; lon *= Pi180;
+    heading = (360 - heading) * Pi180;
+    dist = dist / 60. * Pi180;
+    const double rlat = qAsin(qSin(lat) * qCos(dist) + qCos(lat) * qSin(dist) * qCos(heading));
+    const double dlon = qAtan2(qSin(heading) * qSin(dist) * qCos(lat), qCos(dist) - qSin(lat) * qSin(lat));
+    return DoublePair(rlat / Pi180, (fmod(lon - dlon + M_PI, 2 * M_PI) - M_PI) / Pi180);
+}
+
+/**
+  Geodesic against the former formulas: the deviations documented in
+  Geodesic.h, and the time of the scalar and batch forms over random
+  points. Fails if a deviation is out of its tolerance.
+**/
+int Benchmark::geodesic(int pairs) {
+    QTextStream out(stdout);
+    QRandomGenerator random(42);
+    auto randomLat = [&random]() { return qRadiansToDegrees(qAsin(random.bounded(2.) - 1.)); };
+    QVector<double> lat1(pairs), lon1(pairs), lat2(pairs), lon2(pairs);
+    Geodesic::Points a, b;
+    for (int i = 0; i < pairs; i++) {
+        lat1[i] = randomLat();
+        lon1[i] = random.bounded(360.) - 180.;
+        if (i % 2 == 0) { // short legs, where the acos formulas are weakest
+            const DoublePair near = NavData::pointDistanceBearing(lat1[i], lon1[i], random.bounded(200.),
+                                                                   random.bounded(360.));
+            lat2[i] = near.first;
+            lon2[i] = near.second;
+        } else {
+            lat2[i] = randomLat();
+            lon2[i] = random.bounded(360.) - 180.;
+        }
+        a.append(lat1[i], lon1[i]);
+        b.append(lat2[i], lon2[i]);
+    }
+
+    double maxDistance = 0., maxCourse = 0., maxFraction = 0., maxDestination = 0.;
+    for (int i = 0; i < pairs; i++) {
+        const double d = Geodesic::distance(a.at(i), b.at(i));
+        maxDistance = qMax(maxDistance, qAbs(d - formerDistance(lat1[i], lon1[i], lat2[i], lon2[i])));
+        if (d > 1. && qAbs(lat1[i]) < 89.9) {
+            const double c = qAbs(Geodesic::course(a.at(i), b.at(i)) - formerCourse(lat1[i], lon1[i], lat2[i], lon2[i]));
+            maxCourse = qMax(maxCourse, qMin(c, 360. - c));
+        }
+        if (d > .01 && d < 10700.) { // not (nearly) antipodal, where the formula is undefined
+            const double f = random.bounded(1.2) - .1;
+            const DoublePair p = formerFraction(lat1[i], lon1[i], lat2[i], lon2[i], f);
+            maxFraction = qMax(maxFraction, Geodesic::distance(Geodesic::fraction(a.at(i), b.at(i), f),
+                                                               Geodesic::vector(p.first, p.second)));
+        }
+        if (qAbs(lat1[i]) < 60.) {
+            const double dist = random.bounded(50.), course = random.bounded(360.);
+            const DoublePair p = formerDestination(lat1[i], lon1[i], dist, course);
+            maxDestination = qMax(maxDestination,
+                                  Geodesic::distance(Geodesic::destination(a.at(i), dist, course),
+                                                     Geodesic::vector(p.first, p.second)) / qMax(dist, 1.));
+        }
+    }
+
+    QElapsedTimer timer;
+    volatile double sink = 0.; // keeps the timed loops
+    timer.start();
+    for (int i = 0; i < pairs; i++)
+        sink += formerDistance(lat1[i], lon1[i], lat2[i], lon2[i]);
+    const qint64 formerNs = timer.nsecsElapsed();
+    timer.restart();
+    for (int i = 0; i < pairs; i++)
+        sink += NavData::distance(lat1[i], lon1[i], lat2[i], lon2[i]);
+    const qint64 scalarNs = timer.nsecsElapsed();
+    QVector<double> distances(pairs);
+    timer.restart();
+    Geodesic::distances(a, b, distances.data());
+    const qint64 batchNs = timer.nsecsElapsed();
+
+    // one point against the first 64 others, like a route or the airports around an approach circle
+    const int n = qMin(pairs, 64);
+    Geodesic::Points group;
+    for (int i = 0; i < n; i++)
+        group.append(b.at(i));
+    int formerNearest = 0, batchNearest = 0, formerWithin = 0, batchWithin = 0;
+    timer.restart();
+    for (int i = 0; i < pairs; i++) {
+        double minDist = 0.;
+        int best = -1;
+        for (int j = 0; j < n; j++) {
+            const double d = formerDistance(lat1[i], lon1[i], lat2[j], lon2[j]);
+            if (best < 0 || d < minDist) {
+                minDist = d;
+                best = j;
+            }
+            formerWithin += d < 3000.;
+        }
+        formerNearest += best;
+    }
+    const qint64 formerGroupNs = timer.nsecsElapsed();
+    timer.restart();
+    for (int i = 0; i < pairs; i++) {
+        batchNearest += Geodesic::nearest(a.at(i), group);
+        batchWithin += Geodesic::countWithin(a.at(i), group, 3000.);
+    }
+    const qint64 batchGroupNs = timer.nsecsElapsed();
+
+    // 100 points along each leg
+    const int legs = qMin(pairs, 1000);
+    timer.restart();
+    for (int i = 0; i < legs; i++)
+        for (int k = 0; k < 100; k++)
+            sink += formerFraction(lat1[i], lon1[i], lat2[i], lon2[i], k / 100.).first;
+    const qint64 formerSlerpNs = timer.nsecsElapsed();
+    Geodesic::Points along;
+    timer.restart();
+    for (int i = 0; i < legs; i++) {
+        along.clear();
+        Geodesic::interpolate(a.at(i), b.at(i), .01, 100, along);
+        for (int k = 0; k < 100; k++)
+            sink += along.lat(k);
+    }
+    const qint64 batchSlerpNs = timer.nsecsElapsed();
+
+    const double perPair = qMax(pairs, 1);
+    out << "geodesic benchmark: " << pairs << " random pairs, half of them within 200 nm" << Qt::endl;
+    out << "deviation from the former formulas: distance " << maxDistance << " nm, course " << maxCourse
+        << " deg, fraction " << maxFraction << " nm, destination " << maxDestination
+        << " of the distance (50 nm legs below 60 deg)" << Qt::endl;
+    out << "distance, former:             " << QString::number(formerNs / perPair, 'f', 1) << " ns/pair" << Qt::endl;
+    out << "distance, NavData (Geodesic): " << QString::number(scalarNs / perPair, 'f', 1) << " ns/pair" << Qt::endl;
+    out << "distances, batch of vectors:  " << QString::number(batchNs / perPair, 'f', 1) << " ns/pair" << Qt::endl;
+    out << "nearest + within of " << n << ", former: " << QString::number(formerGroupNs / perPair, 'f', 1)
+        << " ns/query" << Qt::endl;
+    out << "nearest + within of " << n << ", batch:  " << QString::number(batchGroupNs / perPair, 'f', 1)
+        << " ns/query" << Qt::endl;
+    out << "100 points along a leg, former: " << QString::number(formerSlerpNs / (double) qMax(legs, 1) / 1000., 'f', 2)
+        << " us/leg" << Qt::endl;
+    out << "100 points along a leg, batch:  " << QString::number(batchSlerpNs / (double) qMax(legs, 1) / 1000., 'f', 2)
+        << " us/leg" << Qt::endl;
+    if (maxDistance > 1e-6 || maxCourse > 1e-3 || maxFraction > 1e-9
+            || formerNearest != batchNearest || formerWithin != batchWithin) {
+        out << "Geodesic is out of its documented tolerance!" << Qt::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+/**
+  Times Airac::load() with and without AiracCache. "cold" is the first
+  start with new navdata (parse the text files and write the cache),
+  "warm" every start after that. The files are in the OS file cache for
+  all of them.
+  Memory is the size of the NavStore against the growth of the RSS when
+  every point gets its Waypoint or NavAid object, which is what the
+  navdata took before NavStore (without the per-ident sets).
+**/
+int Benchmark::airacCache(const QString &directory) {
+    QTextStream out(stdout);
+    if (!QFileInfo::exists(QDir(directory).filePath("earth_fix.dat"))) {
+        out << "No earth_fix.dat in " << directory << Qt::endl;
+        return EXIT_FAILURE;
+    }
+    QTemporaryDir tempDir;
+    if (!tempDir.isValid()) {
+        out << "Could not create a temporary directory" << Qt::endl;
+        return EXIT_FAILURE;
+    }
+    Airac *airac = Airac::instance();
+    AiracCache cache(directory, tempDir.filePath("airac.navcache"));
+    QElapsedTimer timer;
+
+    timer.start();
+    airac->readFromText(directory);
+    const qint64 textMs = timer.elapsed();
+    const int points = airac->store().size(), idents = airac->store().identCount(),
+            airways = airac->airways.size();
+
+    timer.start();
+    const bool written = cache.write(airac->store(), airac->airways);
+    const qint64 writeMs = timer.elapsed();
+    airac->clear();
+    if (!written) {
+        out << "Could not write " << cache.fileName() << Qt::endl;
+        return EXIT_FAILURE;
+    }
+
+    timer.start();
+    NavStore store;
+    QHash<QString, QList<Airway*> > cachedAirways;
+    const bool read = cache.read(store, cachedAirways);
+    const qint64 warmMs = timer.elapsed();
+
+    airac->readFromText(directory);
+    const qint64 storeBytes = airac->store().memoryUsage(), baseline = Platform::currentRss();
+    for (int i = 0; i < airac->store().size(); i++)
+        airac->point(i);
+    const qint64 objectBytes = Platform::currentRss() - baseline;
+    airac->clear();
+
+    out << "Airac benchmark: " << directory << ", " << points << " fixes and navaids with " << idents
+        << " idents, " << airways << " airway names" << Qt::endl;
+    out << "text:                " << textMs << " ms" << Qt::endl;
+    out << "cold (text + write): " << textMs + writeMs << " ms" << Qt::endl;
+    out << "warm (cache):        " << warmMs << " ms, cache " << megabytes(QFileInfo(cache.fileName()).size())
+        << Qt::endl;
+    out << "NavStore:            " << megabytes(storeBytes) << Qt::endl;
+    out << "one object per point: +" << megabytes(objectBytes) << " RSS" << Qt::endl;
+    foreach (const QList<Airway*> &list, cachedAirways)
+        qDeleteAll(list);
+    if (!read || store.size() != points || store.identCount() != idents || cachedAirways.size() != airways) {
+        out << "The cache did not read back to the same navdata!" << Qt::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+/**
+  readAirways() is timed on its own, after the fixes and navaids. The
+  expand tokens are pairs of points on random airways; "linear" searches
+  both idents by string compare along the airway, like Airway::index()
+  did before the position hash.
+**/
+int Benchmark::airways(const QString &directory, int tokens) {
+    QTextStream out(stdout);
+    if (!QFileInfo::exists(QDir(directory).filePath("earth_awy.dat"))) {
+        out << "No earth_awy.dat in " << directory << Qt::endl;
+        return EXIT_FAILURE;
+    }
+    Airac *airac = Airac::instance();
+    airac->readFromText(directory);
+    const NavStore &store = airac->store();
+    foreach (const QList<Airway*> &list, airac->airways)
+        qDeleteAll(list);
+
+    QElapsedTimer timer;
+    timer.start();
+    airac->readAirways(directory);
+    const qint64 readMs = timer.elapsed();
+
+    QList<Airway*> all;
+    foreach (const QList<Airway*> &list, airac->airways)
+        foreach (Airway *awy, list)
+            if (awy->points().size() > 1)
+                all.append(awy);
+    if (all.isEmpty()) {
+        out << "No airways in " << directory << Qt::endl;
+        return EXIT_FAILURE;
+    }
+
+    struct Token {
+        const Airway *airway;
+        QString start, end;
+    };
+    QVector<Token> queries;
+    queries.reserve(tokens);
+    QRandomGenerator random(42);
+    for (int i = 0; i < tokens; i++) {
+        const Airway *awy = all[random.bounded(all.size())];
+        const QVector<int> points = awy->points();
+        const Token token = { awy, store.ident(points[random.bounded(points.size())]),
+                              store.ident(points[random.bounded(points.size())]) };
+        queries.append(token);
+    }
+
+    qint64 expanded = 0;
+    timer.start();
+    foreach (const Token &t, queries)
+        expanded += t.airway->expand(store, t.start, t.end).size();
+    const qint64 hashNs = timer.nsecsElapsed();
+
+    qint64 linearFound = 0;
+    timer.start();
+    foreach (const Token &t, queries) {
+        const QVector<int> points = t.airway->points();
+        int start = -1, end = -1;
+        for (int i = 0; i < points.size() && (start < 0 || end < 0); i++) {
+            const QString ident = store.ident(points[i]);
+            if (start < 0 && ident == t.start)
+                start = i;
+            if (end < 0 && ident == t.end)
+                end = i;
+        }
+        linearFound += qAbs(end - start);
+    }
+    const qint64 linearNs = timer.nsecsElapsed();
+
+    const AirwayGraph &graph = airac->airwayGraph();
+    out << "airway benchmark: " << directory << ", " << airac->airways.size() << " airway names, "
+        << all.size() << " chains, " << graph.edgeCount() / 2 << " segments" << Qt::endl;
+    out << "readAirways():       " << readMs << " ms, graph " << megabytes(graph.memoryUsage()) << Qt::endl;
+    out << "expand (hash):       " << QString::number(hashNs / (double) tokens, 'f', 0) << " ns/token, "
+        << expanded << " points" << Qt::endl;
+    out << "ident search (linear): " << QString::number(linearNs / (double) tokens, 'f', 0) << " ns/token, "
+        << linearFound << " hops" << Qt::endl;
+    airac->clear();
+    return EXIT_SUCCESS;
+}
+
+/**
+  Route queries between random airway points 300..3000 NM apart, so that
+  they start and end on the graph like a route between two airports would.
+**/
+int Benchmark::routes(const QString &directory, int queries) {
+    QTextStream out(stdout);
+    if (!QFileInfo::exists(QDir(directory).filePath("earth_awy.dat"))) {
+        out << "No earth_awy.dat in " << directory << Qt::endl;
+        return EXIT_FAILURE;
+    }
+    Airac *airac = Airac::instance();
+    airac->readFromText(directory);
+    const NavStore &store = airac->store();
+    const AirwayGraph &graph = airac->airwayGraph();
+
+    QElapsedTimer timer;
+    timer.start();
+    RouteFinder *finder = airac->routeFinder();
+    const qint64 prepareMs = timer.elapsed();
+
+    QVector<int> onAirways;
+    for (int p = 0; p < graph.pointCount(); p++) {
+        if (graph.edgeRange(p).first != graph.edgeRange(p).second)
+            onAirways.append(p);
+    }
+    if (onAirways.isEmpty()) {
+        out << "No airways in " << directory << Qt::endl;
+        airac->clear();
+        return EXIT_FAILURE;
+    }
+    QVector<QPair<int, int> > pairs;
+    QRandomGenerator random(42);
+    while (pairs.size() < queries) {
+        const int a = onAirways[random.bounded(onAirways.size())], b = onAirways[random.bounded(onAirways.size())];
+        const double distance = NavData::distance(store.point(a).lat, store.point(a).lon,
+                                                  store.point(b).lat, store.point(b).lon);
+        if (distance >= 300. && distance <= 3000.)
+            pairs.append(qMakePair(a, b));
+    }
+
+    out << "route benchmark: " << directory << ", " << finder->nodeCount() << " nodes, prepared in "
+        << prepareMs << " ms" << Qt::endl;
+    foreach (int k, QList<int>() << 1 << 5) {
+        QVector<qint64> times;
+        int found = 0, answered = 0;
+        double stretch = 0.;
+        foreach (const QPair<int, int> &pair, pairs) {
+            const NavStore::Point &a = store.point(pair.first), &b = store.point(pair.second);
+            timer.start();
+            const QList<RouteFinder::Route> result = finder->find(a.lat, a.lon, b.lat, b.lon, k);
+            times.append(timer.nsecsElapsed() / 1000);
+            found += result.size();
+            if (!result.isEmpty()) {
+                answered++;
+                stretch += result.first().distance / NavData::distance(a.lat, a.lon, b.lat, b.lon);
+            }
+        }
+        std::sort(times.begin(), times.end());
+        out << QString("k=%1: p50 %2 us, p95 %3 us, max %4 us, %5 routes, shortest %6x great circle")
+               .arg(k).arg(percentile(times, 50)).arg(percentile(times, 95)).arg(times.last())
+               .arg(found).arg(stretch / qMax(1, answered), 0, 'f', 2) << Qt::endl;
+    }
+    airac->clear();
+    return EXIT_SUCCESS;
+}
@@ -4,26 +4,33 @@
 
 #include "Client.h"
 
+#include "NavData.h"
 #include "Whazzup.h"
 #include "Settings.h"
+#include "StringPool.h"
 
 #include <QInputDialog>
 
-Client::Client(const QJsonObject& json, const WhazzupData*) :
+Client::Client(const QJsonObject& json, const WhazzupData*, const Derived *previous) :
     server("")
 {
-    label = json["callsign"].toString();
+    label = StringPool::intern(json["callsign"].toString());
     userId = QString::number(json["cid"].toInt());
-    m_name = json["name"].toString();
     lat = json["latitude"].toDouble();
     lon = json["longitude"].toDouble();
-    server = json["server"].toString();
+    server = StringPool::intern(json["server"].toString());
     rating = json["rating"].toInt();
     timeConnected = QDateTime::fromString(json["logon_time"].toString(), Qt::ISODate);
 
-    if(m_name.contains(QRegExp("\\b[A-Z]{4}$"))) {
-        homeBase = m_name.right(4);
-        m_name = m_name.left(m_name.length() - 4).trimmed();
+    if (previous != 0) {
+        m_name = previous->name;
+        homeBase = previous->homeBase;
+    } else {
+        m_name = json["name"].toString();
+        if(m_name.contains(QRegExp("\\b[A-Z]{4}$"))) {
+            homeBase = StringPool::intern(m_name.right(4));
+            m_name = m_name.left(m_name.length() - 4).trimmed();
+        }
     }
 }
 
@@ -73,6 +80,7 @@ bool Client::showAliasDialog(QWidget *parent) const
     );
     if (ok) {
         Settings::setClientAlias(userId, alias);
+        NavData::instance()->searchIndex.invalidateClients(); // controllers are found by their alias
     }
     return ok;
 }
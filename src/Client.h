@@ -11,7 +11,12 @@
 
 class Client: public MapObject {
     public:
-        Client(const QJsonObject& json, const WhazzupData *whazzup);
+        // what the constructor makes of the record's name, see ClientRecords
+        struct Derived {
+            QString name, homeBase;
+        };
+        // previous: derived from a record with the same name
+        Client(const QJsonObject& json, const WhazzupData *whazzup, const Derived *previous = 0);
 
         virtual QString toolTip() const;
         virtual QString rank() const { return QString(); }
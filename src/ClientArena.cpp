@@ -0,0 +1,75 @@
+/**************************************************************************
+ *  This file is part of QuteScoop. See README for license
+ **************************************************************************/
+
+#include "ClientArena.h"
+
+#include <cstddef>
+
+static QAtomicInt arenasEnabled(1);
+static QAtomicInteger<quint64> arenaHeapAllocations(0);
+
+ClientArena::ClientArena() :
+    _enabled(isEnabled()),
+    _current(0), _end(0)
+{
+}
+
+ClientArena::~ClientArena() {
+    foreach (char *block, _blocks)
+        ::operator delete(block);
+}
+
+void ClientArena::setEnabled(bool enabled) {
+    arenasEnabled.storeRelaxed(enabled? 1: 0);
+}
+
+bool ClientArena::isEnabled() {
+    return arenasEnabled.loadRelaxed() != 0;
+}
+
+quint64 ClientArena::heapAllocations() {
+    return arenaHeapAllocations.loadRelaxed();
+}
+
+size_t ClientArena::slotSize(size_t size) {
+    const size_t alignment = alignof(std::max_align_t);
+    return qMax((size + alignment - 1) / alignment * alignment, sizeof(FreeSlot));
+}
+
+void *ClientArena::allocate(size_t size) {
+    if (!_enabled) {
+        arenaHeapAllocations.fetchAndAddRelaxed(1);
+        return ::operator new(size);
+    }
+
+    size = slotSize(size);
+    FreeSlot *slot = _freeSlots.value(size, 0);
+    if (slot != 0) {
+        _freeSlots[size] = slot->next;
+        return slot;
+    }
+
+    if (_current == 0 || (size_t) (_end - _current) < size) {
+        const size_t newBlockSize = qMax(blockSize, size);
+        _current = static_cast<char*>(::operator new(newBlockSize));
+        _end = _current + newBlockSize;
+        _blocks.append(_current);
+        arenaHeapAllocations.fetchAndAddRelaxed(1);
+    }
+    void *p = _current;
+    _current += size;
+    return p;
+}
+
+void ClientArena::deallocate(void *p, size_t size) {
+    if (!_enabled) {
+        ::operator delete(p);
+        return;
+    }
+
+    size = slotSize(size);
+    FreeSlot *slot = static_cast<FreeSlot*>(p);
+    slot->next = _freeSlots.value(size, 0);
+    _freeSlots[size] = slot;
+}
@@ -0,0 +1,66 @@
+/**************************************************************************
+ *  This file is part of QuteScoop. See README for license
+ **************************************************************************/
+
+#ifndef CLIENTARENA_H_
+#define CLIENTARENA_H_
+
+#include <QtCore>
+
+#include <new>
+#include <utility>
+
+/**
+  Bump allocator for the client objects of one WhazzupData snapshot.
+  Objects are placed into large blocks which are released in one go when
+  the arena dies. Destroyed objects leave their slot on a free list for
+  objects of the same size, so snapshots that are updated in place for a
+  whole session do not grow with every pilot that comes and goes.
+  Destructors still run (QStrings, QObject internals live on the heap), the
+  arena only saves the allocation of the objects themselves.
+  Not thread safe: one arena is only used from one thread at a time.
+**/
+class ClientArena {
+    public:
+        ClientArena();
+        ~ClientArena();
+
+        template<typename T, typename... Args>
+        T *create(Args&&... args) {
+            return new (allocate(sizeof(T))) T(std::forward<Args>(args)...);
+        }
+        template<typename T>
+        void destroy(const T *object) {
+            if (object == 0)
+                return;
+            object->~T();
+            deallocate(const_cast<T*>(object), sizeof(T));
+        }
+
+        // arenas created after setEnabled(false) pass every object to the heap (for comparisons)
+        static void setEnabled(bool enabled);
+        static bool isEnabled();
+        // heap allocations made by all arenas: blocks, or objects when disabled
+        static quint64 heapAllocations();
+
+        int blockCount() const { return _blocks.size(); }
+    private:
+        Q_DISABLE_COPY(ClientArena)
+
+        static const size_t blockSize = 64 * 1024;
+
+        void *allocate(size_t size);
+        void deallocate(void *p, size_t size);
+        static size_t slotSize(size_t size);
+
+        struct FreeSlot {
+            FreeSlot *next;
+        };
+
+        const bool _enabled;
+        QList<char*> _blocks;
+        char *_current, *_end;
+        QHash<size_t, FreeSlot*> _freeSlots; // by slot size
+};
+
+#endif /*CLIENTARENA_H_*/
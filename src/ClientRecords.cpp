@@ -0,0 +1,158 @@
+/**************************************************************************
+ *  This file is part of QuteScoop. See README for license
+ **************************************************************************/
+
+#include "ClientRecords.h"
+
+#include "ClientArena.h"
+
+#include <QJsonArray>
+
+namespace {
+    const quint64 fnvOffset = 14695981039346656037ULL;
+    const quint64 fnvPrime = 1099511628211ULL;
+
+    void mix(quint64 &hash, const void *data, size_t size) {
+        const uchar *bytes = static_cast<const uchar*>(data);
+        for (size_t i = 0; i < size; i++) {
+            hash = (hash ^ bytes[i]) * fnvPrime;
+        }
+    }
+
+    void mixString(quint64 &hash, const QString &s) {
+        const int size = s.size();
+        mix(hash, &size, sizeof(size)); // "ab", "c" is not "a", "bc"
+        mix(hash, s.constData(), size * sizeof(QChar));
+    }
+
+    void mixValue(quint64 &hash, const QJsonValue &value) {
+        const uchar type = value.type();
+        mix(hash, &type, 1);
+        switch (value.type()) {
+            case QJsonValue::Bool: {
+                const uchar b = value.toBool();
+                mix(hash, &b, 1);
+                break;
+            }
+            case QJsonValue::Double: {
+                const double d = value.toDouble();
+                mix(hash, &d, sizeof(d));
+                break;
+            }
+            case QJsonValue::String:
+                mixString(hash, value.toString());
+                break;
+            case QJsonValue::Array: {
+                const QJsonArray array = value.toArray();
+                const int size = array.size();
+                mix(hash, &size, sizeof(size));
+                foreach (const QJsonValue &v, array) {
+                    mixValue(hash, v);
+                }
+                break;
+            }
+            case QJsonValue::Object: {
+                const QJsonObject object = value.toObject();
+                const int size = object.size();
+                mix(hash, &size, sizeof(size));
+                for (QJsonObject::const_iterator it = object.constBegin(); it != object.constEnd(); ++it) {
+                    mixString(hash, it.key());
+                    mixValue(hash, it.value());
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+}
+
+ClientRecords::Fingerprint ClientRecords::fingerprint(const QJsonObject &json, const QStringList &liveKeys) {
+    // nothing is derived from these, and they change with almost every download
+    static const QStringList ignoredKeys = QStringList()
+            << "last_updated" << "heading" << "transponder" << "qnh_i_hg" << "qnh_mb";
+
+    Fingerprint result = { fnvOffset, fnvOffset };
+    for (QJsonObject::const_iterator it = json.constBegin(); it != json.constEnd(); ++it) {
+        if (ignoredKeys.contains(it.key())) {
+            continue;
+        }
+        quint64 &hash = liveKeys.contains(it.key())? result.live: result.stable;
+        mixString(hash, it.key());
+        mixValue(hash, it.value());
+    }
+    return result;
+}
+
+Pilot *ClientRecords::createPilot(const QJsonObject &json, bool prefiled, const WhazzupData *whazzup,
+                                  ClientArena &arena, const ClientRecords *previous) {
+    static const QStringList liveKeys = QStringList() << "latitude" << "longitude" << "altitude" << "groundspeed";
+
+    PilotRecord record;
+    record.fingerprint = fingerprint(json, liveKeys);
+    const Pilot::Derived *reused = 0;
+    bool samePosition = false;
+    if (previous != 0) {
+        const QHash<QString, PilotRecord> &records = prefiled? previous->_prefiles: previous->_pilots;
+        const QHash<QString, PilotRecord>::const_iterator it = records.constFind(json["callsign"].toString());
+        if (it != records.constEnd() && it->fingerprint.stable == record.fingerprint.stable) {
+            reused = &it->derived;
+            samePosition = it->fingerprint.live == record.fingerprint.live;
+        }
+    }
+
+    Pilot *p = arena.create<Pilot>(json, whazzup, reused, samePosition);
+    record.derived = p->derived();
+    (prefiled? _prefiles: _pilots).insert(p->label, record);
+
+    _pilotCounts.records++;
+    if (reused != 0) {
+        if (samePosition) {
+            _pilotCounts.unchanged++;
+        } else {
+            _pilotCounts.liveChanged++;
+        }
+    }
+    return p;
+}
+
+Controller *ClientRecords::createController(const QJsonObject &json, const WhazzupData *whazzup,
+                                            ClientArena &arena, const ClientRecords *previous) {
+    static const QStringList liveKeys = QStringList() << "text_atis";
+
+    ControllerRecord record;
+    record.fingerprint = fingerprint(json, liveKeys);
+    const Controller::Derived *reused = 0;
+    bool sameAtis = false;
+    if (previous != 0) {
+        const QHash<QString, ControllerRecord>::const_iterator it =
+                previous->_controllers.constFind(json["callsign"].toString());
+        if (it != previous->_controllers.constEnd() && it->fingerprint.stable == record.fingerprint.stable) {
+            reused = &it->derived;
+            sameAtis = it->fingerprint.live == record.fingerprint.live;
+        }
+    }
+
+    Controller *c = arena.create<Controller>(json, whazzup, reused, sameAtis);
+    record.derived = c->derived();
+    _controllers.insert(c->label, record);
+
+    _controllerCounts.records++;
+    if (reused != 0) {
+        if (sameAtis) {
+            _controllerCounts.unchanged++;
+        } else {
+            _controllerCounts.liveChanged++;
+        }
+    }
+    return c;
+}
+
+QString ClientRecords::summary() const {
+    return QString("pilots %1 unchanged, %2 moved, %3 built of %4; controllers %5 unchanged, %6 new ATIS, %7 built of %8")
+            .arg(_pilotCounts.unchanged).arg(_pilotCounts.liveChanged)
+            .arg(_pilotCounts.records - _pilotCounts.unchanged - _pilotCounts.liveChanged).arg(_pilotCounts.records)
+            .arg(_controllerCounts.unchanged).arg(_controllerCounts.liveChanged)
+            .arg(_controllerCounts.records - _controllerCounts.unchanged - _controllerCounts.liveChanged)
+            .arg(_controllerCounts.records);
+}
@@ -0,0 +1,68 @@
+/**************************************************************************
+ *  This file is part of QuteScoop. See README for license
+ **************************************************************************/
+
+#ifndef CLIENTRECORDS_H_
+#define CLIENTRECORDS_H_
+
+#include "Pilot.h"
+#include "Controller.h"
+
+#include <QJsonObject>
+
+class ClientArena;
+
+/**
+  Fingerprints of the client records of one Whazzup snapshot, with what the
+  clients derived from them (see Pilot::Derived, Controller::Derived).
+  Most records come back unchanged or with only their live values changed
+  in the next download. Their clients are still built from the JSON, but
+  the airline and airport lookups, sector centers and the regular
+  expressions over callsign, name and ATIS text are taken from here.
+  A record has two 64 bit FNV-1a hashes: over its live values (position,
+  altitude and speed of pilots, the ATIS text of controllers) and over the
+  rest. Values that nothing is derived from and that change all the time
+  (last_updated, heading, transponder, QNH) are left out of both.
+  Built while parsing and immutable afterwards, so the next parse can read
+  it from another thread. The pointers are into NavData: records do not
+  survive NavData::load().
+**/
+class ClientRecords {
+    public:
+        struct Counts {
+            Counts() : records(0), unchanged(0), liveChanged(0) {}
+            int records, unchanged, liveChanged;
+        };
+
+        // clients of the pilots and prefiles sections
+        Pilot *createPilot(const QJsonObject &json, bool prefiled, const WhazzupData *whazzup, ClientArena &arena,
+                           const ClientRecords *previous);
+        // clients of the controllers and atis sections
+        Controller *createController(const QJsonObject &json, const WhazzupData *whazzup, ClientArena &arena,
+                                     const ClientRecords *previous);
+
+        // how many of the records built a client with reused state
+        const Counts &pilotCounts() const { return _pilotCounts; }
+        const Counts &controllerCounts() const { return _controllerCounts; }
+        QString summary() const;
+    private:
+        struct Fingerprint {
+            quint64 stable, live;
+        };
+        struct PilotRecord {
+            Fingerprint fingerprint;
+            Pilot::Derived derived;
+        };
+        struct ControllerRecord {
+            Fingerprint fingerprint;
+            Controller::Derived derived;
+        };
+
+        static Fingerprint fingerprint(const QJsonObject &json, const QStringList &liveKeys);
+
+        QHash<QString, PilotRecord> _pilots, _prefiles;
+        QHash<QString, ControllerRecord> _controllers;
+        Counts _pilotCounts, _controllerCounts;
+};
+
+#endif /* CLIENTRECORDS_H_ */
@@ -9,14 +9,15 @@
 #include "ControllerDetails.h"
 #include "NavData.h"
 #include "src/Airport.h"
+#include "StringPool.h"
 
 #include <QJsonObject>
 
-Controller::Controller(const QJsonObject& json, const WhazzupData* whazzup):
-    Client(json, whazzup),
+Controller::Controller(const QJsonObject& json, const WhazzupData* whazzup, const Derived *previous, bool sameAtis):
+    Client(json, whazzup, previous),
     sector(0)
 {
-    frequency = json["frequency"].toString();
+    frequency = StringPool::intern(json["frequency"].toString());
     facilityType = json["facility"].toInt();
     if(label.right(4) == "_FSS") facilityType = 7; // workaround as VATSIM reports 1 for _FSS
 
@@ -32,32 +33,39 @@ Controller::Controller(const QJsonObject& json, const WhazzupData* whazzup):
 
     atisCode = "";
     if(json.contains("atis_code")) {
-        atisCode = json["atis_code"].toString();
+        atisCode = StringPool::intern(json["atis_code"].toString());
     }
 
-    // do some magic for Controller Info like "online until"...
-    QRegExp rxOnlineUntil = QRegExp(
-          "(open|close|online|offline|till|until)(\\W*\\w*\\W*){0,4}\\b(\\d{1,2}):?(\\d{2})\\W?(z|utc)?",
-          Qt::CaseInsensitive
-    );
-    if (rxOnlineUntil.indexIn(atisMessage) > 0) {
-        //fixme
-        QTime found = QTime::fromString(rxOnlineUntil.cap(3)+rxOnlineUntil.cap(4), "HHmm");
-        if(found.isValid()) {
-            if (qAbs(found.secsTo(whazzup->whazzupTime.time())) > 60*60 * 12) {
-                // e.g. now its 2200z, and he says "online until 0030z", allow for up to 12 hours
-                assumeOnlineUntil = QDateTime(whazzup->whazzupTime.date().addDays(1), found, Qt::UTC);
-            } else {
-                assumeOnlineUntil = QDateTime(whazzup->whazzupTime.date(), found, Qt::UTC);
-            }
+    const QTime found = previous != 0 && sameAtis? previous->onlineUntil: onlineUntilOf(atisMessage);
+    if(found.isValid()) {
+        if (qAbs(found.secsTo(whazzup->whazzupTime.time())) > 60*60 * 12) {
+            // e.g. now its 2200z, and he says "online until 0030z", allow for up to 12 hours
+            assumeOnlineUntil = QDateTime(whazzup->whazzupTime.date().addDays(1), found, Qt::UTC);
+        } else {
+            assumeOnlineUntil = QDateTime(whazzup->whazzupTime.date(), found, Qt::UTC);
         }
     }
 
-    QString icao = this->controllerSectorName();
+    if (previous != 0) {
+        _facility = previous->facility;
+        _sectorName = previous->sectorName;
+        _airports = previous->airports;
+        sector = previous->sector;
+        lat = previous->lat;
+        lon = previous->lon;
+        return;
+    }
+
+    // callsign derived values, the map asks for them on every hover and repaint
+    _facility = facilityOf(label);
+    _sectorName = sectorNameOf();
+    _airports = airportsOf(whazzup->navLookups());
+
+    QString icao = _sectorName;
     // Look for a sector name matching any part of the login down to 4 characters
     if (!icao.isEmpty()) {
         do {
-            this->sector = NavData::instance()->sectors.value(icao, 0);
+            this->sector = whazzup->navLookups().sectors.value(icao, 0);
             if (sector != 0) {
                 // We determine lat/lon from the sector
                 QPair<double, double> center = this->sector->getCenter();
@@ -74,7 +82,6 @@ Controller::Controller(const QJsonObject& json, const WhazzupData* whazzup):
         }
     } else {
         // We try to get lat/lng from covered airports
-        auto _airports = airports();
         if (_airports.size() == 1) {
             lat = _airports[0]->lat;
             lon = _airports[0]->lon;
@@ -94,6 +101,33 @@ Controller::Controller(const QJsonObject& json, const WhazzupData* whazzup):
     }
 }
 
+// do some magic for Controller Info like "online until"...
+QTime Controller::onlineUntilOf(const QString &atisMessage) {
+    QRegExp rxOnlineUntil = QRegExp(
+          "(open|close|online|offline|till|until)(\\W*\\w*\\W*){0,4}\\b(\\d{1,2}):?(\\d{2})\\W?(z|utc)?",
+          Qt::CaseInsensitive
+    );
+    if (rxOnlineUntil.indexIn(atisMessage) > 0) {
+        //fixme
+        return QTime::fromString(rxOnlineUntil.cap(3)+rxOnlineUntil.cap(4), "HHmm");
+    }
+    return QTime();
+}
+
+Controller::Derived Controller::derived() const {
+    Derived result;
+    result.name = m_name;
+    result.homeBase = homeBase;
+    result.onlineUntil = assumeOnlineUntil.time();
+    result.facility = _facility;
+    result.sectorName = _sectorName;
+    result.airports = _airports;
+    result.sector = sector;
+    result.lat = lat;
+    result.lon = lon;
+    return result;
+}
+
 QString Controller::facilityString() const {
     switch (facilityType) {
         case 0: return "OBS";
@@ -115,7 +149,7 @@ QStringList Controller::atcLabelTokens() const {
   return label.split('_', Qt::SkipEmptyParts);
 }
 
-QString Controller::controllerSectorName() const{
+QString Controller::sectorNameOf() const {
     auto _atcLabelTokens = atcLabelTokens();
 
     if(
@@ -128,37 +162,23 @@ QString Controller::controllerSectorName() const{
     return QString();
 }
 
-bool Controller::isCtrFss() const
-{
-  return label.endsWith("_CTR") || label.endsWith("FSS");
-}
-
-bool Controller::isAppDep() const
-{
-  return label.endsWith("_APP") || label.endsWith("DEP");
-}
-
-bool Controller::isTwr() const
-{
-  return label.endsWith("_TWR");
-}
-
-bool Controller::isGnd() const
-{
-  return label.endsWith("_GND");
-}
-
-bool Controller::isDel() const
-{
-  return label.endsWith("_DEL");
-}
-
-bool Controller::isAtis() const
-{
-  return label.endsWith("_ATIS");
+Controller::Facility Controller::facilityOf(const QString &label) {
+    if (label.endsWith("_CTR") || label.endsWith("FSS"))
+        return CtrFss;
+    if (label.endsWith("_APP") || label.endsWith("DEP"))
+        return AppDep;
+    if (label.endsWith("_TWR"))
+        return Twr;
+    if (label.endsWith("_GND"))
+        return Gnd;
+    if (label.endsWith("_DEL"))
+        return Del;
+    if (label.endsWith("_ATIS"))
+        return Atis;
+    return OtherFacility;
 }
 
-QList <Airport*> Controller::airports() const {
+QList <Airport*> Controller::airportsOf(const NavLookups &navLookups) const {
     auto airports = QList<Airport*>();
     auto _atcLabelTokens = atcLabelTokens();
     if (_atcLabelTokens.empty()) {
@@ -167,20 +187,20 @@ QList <Airport*> Controller::airports() const {
     auto prefix = _atcLabelTokens.constFirst();
 
     // ordinary / normal match EDDS_STG_APP -> EDDS
-    auto a = NavData::instance()->airports.value(prefix, 0);
+    auto a = navLookups.airports.value(prefix, 0);
     if (a != 0) {
         airports.append(a);
     }
 
     auto suffix = _atcLabelTokens.constLast();
     // use matches from controllerAirportsMapping.dat
-    airports.append(NavData::instance()->additionalMatchedAirportsForController(prefix, suffix));
+    airports.append(navLookups.additionalMatchedAirportsForController(prefix, suffix));
 
     // if we have not had any match yet and since some
     // VATSIMmers still don't think ICAO codes are cool
     // IAH_TWR -> IAH
     if(airports.isEmpty() && prefix.length() == 3) {
-        auto a = NavData::instance()->airports.value("K" + prefix, 0);
+        auto a = navLookups.airports.value("K" + prefix, 0);
         if (a != 0) {
             airports.append(a);
         }
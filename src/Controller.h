@@ -15,7 +15,23 @@ class Airport;
 
 class Controller: public Client {
     public:
-        Controller(const QJsonObject& json, const WhazzupData* whazzup);
+        // what the callsign suffix says, see facilityOf()
+        enum Facility { OtherFacility, CtrFss, AppDep, Twr, Gnd, Del, Atis };
+
+        // what the constructor looks up and matches, see ClientRecords
+        struct Derived : Client::Derived {
+            QTime onlineUntil; // what the ATIS text says, invalid if nothing
+            Facility facility;
+            QString sectorName;
+            QList<Airport*> airports;
+            Sector *sector;
+            double lat, lon;
+        };
+
+        // previous: derived from a record with the same callsign and name, and the same ATIS text if sameAtis
+        Controller(const QJsonObject& json, const WhazzupData* whazzup,
+                   const Derived *previous = 0, bool sameAtis = false);
+        Derived derived() const;
 
         virtual void showDetailsDialog();
 
@@ -31,15 +47,17 @@ class Controller: public Client {
 
         QStringList atcLabelTokens() const;
 
-        QString controllerSectorName() const;
-        bool isCtrFss() const;
-        bool isAppDep() const;
-        bool isTwr() const;
-        bool isGnd() const;
-        bool isDel() const;
-        bool isAtis() const;
+        QString controllerSectorName() const { return _sectorName; }
+        Facility facility() const { return _facility; }
+        bool isCtrFss() const { return _facility == CtrFss; }
+        bool isAppDep() const { return _facility == AppDep; }
+        bool isTwr() const { return _facility == Twr; }
+        bool isGnd() const { return _facility == Gnd; }
+        bool isDel() const { return _facility == Del; }
+        bool isAtis() const { return _facility == Atis; }
 
-        QList<Airport*> airports() const;
+        // resolved from the callsign when the controller is built
+        const QList<Airport*> &airports() const { return _airports; }
 
         QString frequency, atisMessage, atisCode;
         int facilityType, visualRange;
@@ -49,6 +67,14 @@ class Controller: public Client {
 protected:
         QString specialAirportWorkarounds(const QString& rawAirport) const;
 private:
+        static Facility facilityOf(const QString &label);
+        static QTime onlineUntilOf(const QString &atisMessage);
+        QString sectorNameOf() const;
+        QList<Airport*> airportsOf(const NavLookups &navLookups) const;
+
+        Facility _facility;
+        QString _sectorName;
+        QList<Airport*> _airports;
 };
 
 #endif /*CONTROLLER_H_*/
@@ -0,0 +1,493 @@
+/**************************************************************************
+ *  This file is part of QuteScoop. See README for license
+ **************************************************************************/
+
+#include "DataBundle.h"
+
+#include "FileReader.h"
+#include "Settings.h"
+#include "helpers.h"
+
+#include <algorithm>
+#include <cstring>
+
+static const quint32 bundleMagic = 0x51534442; // "QSDB"
+static const quint32 bundleVersion = 1;
+static const quint32 emptySlot = 0xffffffff;
+static const char *sourceFiles[] = { "data/countrycodes.dat", "data/airports.dat", "data/airlines.dat",
+                                     "data/firlist.dat", "data/firdisplay.dat", "data/coastline.dat",
+                                     "data/countries.dat" };
+
+QString DataBundle::defaultFileName() {
+    return Settings::dataDirectory("cache/data.bundle");
+}
+
+DataBundle::DataBundle(const QString &fileName) :
+    _file(fileName),
+    _map(0)
+{
+}
+
+DataBundle::~DataBundle() {
+    if (_map != 0) {
+        _file.unmap(_map);
+    }
+}
+
+bool DataBundle::sourceStatus(Source *sources) {
+    for (int i = 0; i < sourceCount; i++) {
+        QFileInfo info(Settings::dataDirectory(sourceFiles[i]));
+        if (!info.exists()) {
+            return false;
+        }
+        sources[i].size = info.size();
+        sources[i].modifiedMsecs = info.lastModified().toMSecsSinceEpoch();
+    }
+    return true;
+}
+
+bool DataBundle::open() {
+    if (_map != 0) {
+        return true;
+    }
+    if (!_file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    if (_file.size() < (qint64) sizeof(Header) || (_map = _file.map(0, _file.size())) == 0) {
+        _file.close();
+        return false;
+    }
+
+    static const qint64 recordSize[SectionCount] = {
+        sizeof(CountryCodeRecord), sizeof(AirportRecord), sizeof(quint32), sizeof(quint32), sizeof(AirlineRecord),
+        sizeof(SectorRecord), sizeof(Point), sizeof(LineRecord), sizeof(Point),
+        sizeof(LineRecord), sizeof(Point), 1
+    };
+    bool valid = header()->magic == bundleMagic && header()->version == bundleVersion;
+    for (int i = 0; i < SectionCount && valid; i++) {
+        const Section &s = header()->sections[i];
+        valid = s.offset >= (qint64) sizeof(Header) && s.count >= 0
+                && s.offset + s.count * recordSize[i] <= _file.size();
+    }
+    Source sources[sourceCount];
+    valid = valid && sourceStatus(sources);
+    for (int i = 0; i < sourceCount && valid; i++) {
+        valid = sources[i].size == header()->sources[i].size
+                && sources[i].modifiedMsecs == header()->sources[i].modifiedMsecs;
+    }
+    if (!valid) {
+        qDebug() << "DataBundle::open()" << _file.fileName() << "does not match the data files";
+        _file.unmap(_map);
+        _map = 0;
+        _file.close();
+        return false;
+    }
+    return true;
+}
+
+QString DataBundle::string(quint32 offset) const {
+    const QHash<quint32, QString>::const_iterator it = _strings.constFind(offset);
+    if (it != _strings.constEnd()) {
+        return it.value();
+    }
+    const qint64 size = count(StringSection);
+    quint32 length = 0;
+    if (offset + (qint64) sizeof(length) > size) {
+        return QString();
+    }
+    const uchar *data = section<uchar>(StringSection) + offset;
+    memcpy(&length, data, sizeof(length));
+    if (offset + (qint64) sizeof(length) + 2 * (qint64) length > size) {
+        return QString();
+    }
+    const QString result(reinterpret_cast<const QChar*>(data + sizeof(length)), length);
+    _strings.insert(offset, result);
+    return result;
+}
+
+QHash<QString, QString> DataBundle::countryCodes() const {
+    QHash<QString, QString> result;
+    const CountryCodeRecord *records = section<CountryCodeRecord>(CountryCodeSection);
+    for (qint64 i = 0; i < count(CountryCodeSection); i++) {
+        result[string(records[i].code)] = string(records[i].name);
+    }
+    return result;
+}
+
+QVector<Airport*> DataBundle::airports() const {
+    QVector<Airport*> result;
+    result.reserve(count(AirportSection));
+    const AirportRecord *records = section<AirportRecord>(AirportSection);
+    for (qint64 i = 0; i < count(AirportSection); i++) {
+        const AirportRecord &r = records[i];
+        result.append(new Airport(string(r.label), string(r.name), string(r.city), string(r.countryCode),
+                                  r.lat, r.lon));
+    }
+    return result;
+}
+
+QList<Airline*> DataBundle::airlines() const {
+    QList<Airline*> result;
+    const AirlineRecord *records = section<AirlineRecord>(AirlineSection);
+    for (qint64 i = 0; i < count(AirlineSection); i++) {
+        const AirlineRecord &r = records[i];
+        result.append(new Airline(string(r.code), string(r.name), string(r.callsign), string(r.country)));
+    }
+    return result;
+}
+
+QList<Sector*> DataBundle::sectors() const {
+    QList<Sector*> result;
+    const SectorRecord *records = section<SectorRecord>(SectorSection);
+    const Point *points = section<Point>(SectorPointSection);
+    for (qint64 i = 0; i < count(SectorSection); i++) {
+        const SectorRecord &r = records[i];
+        Sector *sector = new Sector(string(r.icao), string(r.name), string(r.id));
+        if (r.pointCount > 0 && (qint64) r.firstPoint + r.pointCount <= count(SectorPointSection)) {
+            QList<QPair<double, double> > pointList;
+            pointList.reserve(r.pointCount);
+            for (quint32 k = r.firstPoint; k < r.firstPoint + r.pointCount; k++) {
+                pointList.append(QPair<double, double>(points[k].lat, points[k].lon));
+            }
+            sector->setPoints(pointList, QPair<double, double>(r.centerLat, r.centerLon));
+        }
+        result.append(sector);
+    }
+    return result;
+}
+
+QVector<DataBundle::Polyline> DataBundle::lines(LineSet lineSet) const {
+    const SectionType lineSection = lineSet == Coastlines? CoastlineSection: CountryLineSection;
+    const SectionType pointSection = lineSet == Coastlines? CoastlinePointSection: CountryLinePointSection;
+    QVector<Polyline> result;
+    const LineRecord *records = section<LineRecord>(lineSection);
+    const Point *points = section<Point>(pointSection);
+    for (qint64 i = 0; i < count(lineSection); i++) {
+        if ((qint64) records[i].firstPoint + records[i].pointCount > count(pointSection)) {
+            break;
+        }
+        const Polyline line = { points + records[i].firstPoint, (int) records[i].pointCount };
+        result.append(line);
+    }
+    return result;
+}
+
+quint32 DataBundle::icaoHash(const QString &icao, quint32 seed) {
+    // FNV-1a, finished like MurmurHash2, stable across Qt versions unlike qHash()
+    quint32 h = 2166136261u ^ (seed * 16777619u);
+    for (int i = 0; i < icao.size(); i++) {
+        h ^= icao.at(i).unicode();
+        h *= 16777619u;
+    }
+    h ^= h >> 13;
+    h *= 0x5bd1e995;
+    h ^= h >> 15;
+    return h;
+}
+
+int DataBundle::airportIndex(const QString &icao) const {
+    const qint64 bucketCount = count(AirportBucketSection), slotCount = count(AirportSlotSection);
+    if (bucketCount == 0 || slotCount == 0) {
+        return -1;
+    }
+    const quint32 displacement = section<quint32>(AirportBucketSection)[icaoHash(icao, 0) % bucketCount];
+    const quint32 index = section<quint32>(AirportSlotSection)[icaoHash(icao, displacement) % slotCount];
+    if (index >= count(AirportSection) || string(section<AirportRecord>(AirportSection)[index].label) != icao) {
+        return -1;
+    }
+    return index;
+}
+
+/**
+  Hash and displace: the keys are grouped into buckets by their hash,
+  then for each bucket (largest first) a seed is searched that puts all
+  of its keys into free slots. A lookup is two hashes and one compare.
+**/
+bool DataBundle::buildPerfectHash(const QStringList &keys, QVector<quint32> &buckets, QVector<quint32> &slots) {
+    const int bucketCount = keys.size() / 4 + 1, slotCount = keys.size() + keys.size() / 8 + 1;
+    QVector<QVector<int> > members(bucketCount);
+    for (int i = 0; i < keys.size(); i++) {
+        members[icaoHash(keys[i], 0) % bucketCount].append(i);
+    }
+    QVector<int> order(bucketCount);
+    for (int b = 0; b < bucketCount; b++) {
+        order[b] = b;
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [&members](int a, int b) { return members[a].size() > members[b].size(); });
+
+    buckets.fill(0, bucketCount);
+    slots.fill(emptySlot, slotCount);
+    QVector<quint32> positions;
+    foreach (int b, order) {
+        if (members[b].isEmpty()) {
+            break;
+        }
+        bool placed = false;
+        for (quint32 seed = 1; seed < (1u << 20) && !placed; seed++) {
+            positions.clear();
+            placed = true;
+            foreach (int i, members[b]) {
+                const quint32 position = icaoHash(keys[i], seed) % slotCount;
+                if (slots[position] != emptySlot || positions.contains(position)) {
+                    placed = false;
+                    break;
+                }
+                positions.append(position);
+            }
+            if (placed) {
+                buckets[b] = seed;
+                for (int k = 0; k < positions.size(); k++) {
+                    slots[positions[k]] = members[b][k];
+                }
+            }
+        }
+        if (!placed) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+  Parses the data files like NavData, SectorReader and LineReader do,
+  but does not exit on malformed lines: the bundle is not written then and
+  the next start reports the error from the text files.
+**/
+bool DataBundle::compile(const QString &fileName) {
+    QElapsedTimer timer;
+    timer.start();
+    Header header;
+    memset(&header, 0, sizeof(header));
+    header.magic = bundleMagic;
+    header.version = bundleVersion;
+    if (!sourceStatus(header.sources)) {
+        qWarning() << "DataBundle::compile() data files are missing";
+        return false;
+    }
+
+    QByteArray strings;
+    QHash<QString, quint32> stringOffsets;
+    auto addString = [&](const QString &s) -> quint32 {
+        const QHash<QString, quint32>::const_iterator it = stringOffsets.constFind(s);
+        if (it != stringOffsets.constEnd()) {
+            return it.value();
+        }
+        const quint32 offset = strings.size();
+        const quint32 length = s.size();
+        strings.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        strings.append(reinterpret_cast<const char*>(s.constData()), 2 * length);
+        while (strings.size() % 4 != 0) {
+            strings.append('\0');
+        }
+        stringOffsets.insert(s, offset);
+        return offset;
+    };
+
+    // countrycodes.dat
+    QVector<CountryCodeRecord> countryCodes;
+    QHash<QString, QString> countryNames;
+    FileReader countryFile(Settings::dataDirectory(sourceFiles[0]));
+    while (!countryFile.atEnd()) {
+        const QString line = countryFile.nextLine().trimmed();
+        if (line.isEmpty() || line.startsWith(";")) {
+            continue;
+        }
+        const QStringList fields = line.split(':');
+        if (fields.size() != 2) {
+            qWarning() << "DataBundle::compile() malformed country code" << line;
+            return false;
+        }
+        countryNames[fields.first()] = fields.last();
+        const CountryCodeRecord record = { addString(fields.first()), addString(fields.last()) };
+        countryCodes.append(record);
+    }
+
+    // airports.dat, the last line of an ICAO code wins like in NavData::airports
+    QVector<AirportRecord> airports;
+    QStringList airportIcaos;
+    QHash<QString, int> airportIndices;
+    FileReader airportFile(Settings::dataDirectory(sourceFiles[1]));
+    while (!airportFile.atEnd()) {
+        const QString line = airportFile.nextLine().trimmed();
+        if (line.isEmpty() || line.startsWith(";")) {
+            continue;
+        }
+        const QStringList fields = line.split(':');
+        if (fields.size() != 6 || (fields[3] != "" && countryNames.value(fields[3], "") == "")) {
+            qWarning() << "DataBundle::compile() malformed airport" << line;
+            return false;
+        }
+        const AirportRecord record = { fields[4].toDouble(), fields[5].toDouble(), addString(fields[0]),
+                                       addString(fields[1]), addString(fields[2]), addString(fields[3]) };
+        if (airportIndices.contains(fields[0])) {
+            airports[airportIndices[fields[0]]] = record;
+        } else {
+            airportIndices.insert(fields[0], airports.size());
+            airports.append(record);
+            airportIcaos.append(fields[0]);
+        }
+    }
+    QVector<quint32> airportBuckets, airportSlots;
+    if (!buildPerfectHash(airportIcaos, airportBuckets, airportSlots)) {
+        qWarning() << "DataBundle::compile() could not build the airport index";
+        return false;
+    }
+
+    // airlines.dat
+    QVector<AirlineRecord> airlines;
+    FileReader airlineFile(Settings::dataDirectory(sourceFiles[2]));
+    while (!airlineFile.atEnd()) {
+        const QString line = airlineFile.nextLine();
+        const QStringList fields = line.split(0x09);
+        if (fields.size() != 4) {
+            qWarning() << "DataBundle::compile() malformed airline" << line;
+            return false;
+        }
+        const AirlineRecord record = { addString(fields[0]), addString(fields[1]), addString(fields[2]),
+                                       addString(fields[3]) };
+        airlines.append(record);
+    }
+
+    // firlist.dat and firdisplay.dat
+    QVector<SectorRecord> sectors;
+    QVector<Point> sectorPoints;
+    QHash<QString, int> sectorIndices;
+    QMultiMap<QString, QString> idIcaoMapping;
+    FileReader firFile(Settings::dataDirectory(sourceFiles[3]));
+    QString line = firFile.nextLine();
+    while (!line.isNull()) {
+        const QStringList fields = line.split(':');
+        if (fields.size() < 6) {
+            qWarning() << "DataBundle::compile() malformed sector" << line;
+            return false;
+        }
+        const SectorRecord record = { addString(fields[0]), addString(fields[1]), addString(fields[5]),
+                                      0, 0, 0, 0., 0. };
+        if (sectorIndices.contains(fields[0])) {
+            sectors[sectorIndices[fields[0]]] = record;
+        } else {
+            sectorIndices.insert(fields[0], sectors.size());
+            sectors.append(record);
+        }
+        idIcaoMapping.insert(fields[5], fields[0]);
+        line = firFile.nextLine();
+    }
+    FileReader displayFile(Settings::dataDirectory(sourceFiles[4]));
+    QString workingSectorId;
+    QList<QPair<double, double> > pointList;
+    while (!displayFile.atEnd()) {
+        const QString line = displayFile.nextLine();
+        if (line.startsWith("DISPLAY_LIST_")) {
+            if (!workingSectorId.isEmpty()) {
+                if (pointList.size() < 3) {
+                    qWarning() << "DataBundle::compile() sector" << workingSectorId << "has less than 3 points";
+                    return false;
+                }
+                const QPair<double, double> center = Helpers::polygonCenter(pointList);
+                const quint32 first = sectorPoints.size();
+                for (int i = 0; i < pointList.size(); i++) {
+                    const Point point = { pointList[i].first, pointList[i].second };
+                    sectorPoints.append(point);
+                }
+                foreach (const QString &icao, idIcaoMapping.values(workingSectorId)) {
+                    SectorRecord &record = sectors[sectorIndices[icao]];
+                    record.firstPoint = first;
+                    record.pointCount = pointList.size();
+                    record.centerLat = center.first;
+                    record.centerLon = center.second;
+                }
+            }
+            workingSectorId = line.split('_').last();
+            pointList.clear();
+        } else if (!workingSectorId.isEmpty() && !line.isEmpty()) {
+            const QStringList fields = line.split(':');
+            if (fields.size() < 2) {
+                continue;
+            }
+            const double lat = fields[0].toDouble();
+            const double lon = Helpers::modPositive(fields[1].toDouble() + 180., 360.) - 180.;
+            if (lat > 90. || lat < -90. || lon > 180. || lon < -180. || (qFuzzyIsNull(lat) && qFuzzyIsNull(lon))) {
+                qWarning() << "DataBundle::compile() sector" << workingSectorId << "has an invalid point" << line;
+                return false;
+            }
+            pointList.append(QPair<double, double>(lat, lon));
+        }
+    }
+
+    // coastline.dat and countries.dat, polylines separated by "end" lines
+    QVector<LineRecord> lineRecords[2];
+    QVector<Point> linePoints[2];
+    for (int set = 0; set < 2; set++) {
+        FileReader lineFile(Settings::dataDirectory(sourceFiles[5 + set]));
+        forever {
+            const quint32 first = linePoints[set].size();
+            while (!lineFile.atEnd()) {
+                const QString line = lineFile.nextLine();
+                if (line == "end" || line.isNull()) {
+                    break;
+                }
+                const QStringList fields = line.split(':');
+                if (fields.size() != 2) {
+                    continue;
+                }
+                bool latOk, lonOk;
+                const Point point = { fields[0].toDouble(&latOk), fields[1].toDouble(&lonOk) };
+                if (latOk && lonOk) {
+                    linePoints[set].append(point);
+                }
+            }
+            if ((quint32) linePoints[set].size() == first) {
+                break; // LineReader stops at the first empty line, too
+            }
+            const LineRecord record = { first, linePoints[set].size() - first };
+            lineRecords[set].append(record);
+        }
+    }
+
+    QByteArray body;
+    auto addSection = [&](SectionType type, const void *data, qint64 bytes, qint64 count) {
+        while ((sizeof(Header) + body.size()) % 8 != 0) {
+            body.append('\0');
+        }
+        header.sections[type].offset = sizeof(Header) + body.size();
+        header.sections[type].count = count;
+        body.append(reinterpret_cast<const char*>(data), bytes);
+    };
+    addSection(CountryCodeSection, countryCodes.constData(), countryCodes.size() * sizeof(CountryCodeRecord),
+               countryCodes.size());
+    addSection(AirportSection, airports.constData(), airports.size() * sizeof(AirportRecord), airports.size());
+    addSection(AirportBucketSection, airportBuckets.constData(), airportBuckets.size() * sizeof(quint32),
+               airportBuckets.size());
+    addSection(AirportSlotSection, airportSlots.constData(), airportSlots.size() * sizeof(quint32),
+               airportSlots.size());
+    addSection(AirlineSection, airlines.constData(), airlines.size() * sizeof(AirlineRecord), airlines.size());
+    addSection(SectorSection, sectors.constData(), sectors.size() * sizeof(SectorRecord), sectors.size());
+    addSection(SectorPointSection, sectorPoints.constData(), sectorPoints.size() * sizeof(Point),
+               sectorPoints.size());
+    addSection(CoastlineSection, lineRecords[0].constData(), lineRecords[0].size() * sizeof(LineRecord),
+               lineRecords[0].size());
+    addSection(CoastlinePointSection, linePoints[0].constData(), linePoints[0].size() * sizeof(Point),
+               linePoints[0].size());
+    addSection(CountryLineSection, lineRecords[1].constData(), lineRecords[1].size() * sizeof(LineRecord),
+               lineRecords[1].size());
+    addSection(CountryLinePointSection, linePoints[1].constData(), linePoints[1].size() * sizeof(Point),
+               linePoints[1].size());
+    addSection(StringSection, strings.constData(), strings.size(), strings.size());
+
+    QDir().mkpath(QFileInfo(fileName).absolutePath());
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "DataBundle::compile() could not open" << fileName << file.errorString();
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(body);
+    if (!file.commit()) {
+        qWarning() << "DataBundle::compile() could not write" << fileName << file.errorString();
+        return false;
+    }
+    qDebug() << "DataBundle::compile()" << fileName << airports.size() << "airports," << sectors.size()
+             << "sectors," << lineRecords[0].size() + lineRecords[1].size() << "lines in" << timer.elapsed() << "ms";
+    return true;
+}
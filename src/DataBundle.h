@@ -0,0 +1,110 @@
+/**************************************************************************
+ *  This file is part of QuteScoop. See README for license
+ **************************************************************************/
+
+#ifndef DATABUNDLE_H_
+#define DATABUNDLE_H_
+
+#include "Airport.h"
+#include "Airline.h"
+#include "Sector.h"
+
+#include <QtCore>
+
+/**
+  The data files that are parsed at every start (countrycodes.dat,
+  airports.dat, airlines.dat, firlist.dat, firdisplay.dat, coastline.dat
+  and countries.dat), compiled into one memory-mapped file:
+  fixed size records, a perfect hash over the airport ICAO codes, sector
+  outlines with their precomputed centers and the coastlines and country
+  borders as flat coordinate arrays.
+  compile() is run when the data files were updated (and by
+  NavData::load() when the bundle is missing or outdated). open() fails
+  when one of the data files differs in size or modification time from
+  what the bundle was compiled from, the text files are used then.
+**/
+class DataBundle {
+    public:
+        static QString defaultFileName();
+        // false if a data file could not be read or is malformed
+        static bool compile(const QString &fileName = defaultFileName());
+
+        explicit DataBundle(const QString &fileName = defaultFileName());
+        ~DataBundle();
+        QString fileName() const { return _file.fileName(); }
+
+        bool open();
+        bool isOpen() const { return _map != 0; }
+
+        // new objects
+        QHash<QString, QString> countryCodes() const;
+        QVector<Airport*> airports() const; // in the order of airportIndex()
+        QList<Airline*> airlines() const;
+        QList<Sector*> sectors() const;
+        // -1 if there is no airport with that ICAO code
+        int airportIndex(const QString &icao) const;
+
+        struct Point {
+            double lat, lon;
+        };
+        struct Polyline {
+            const Point *points; // into the mapped file
+            int count;
+        };
+        enum LineSet { Coastlines, CountryLines };
+        QVector<Polyline> lines(LineSet lineSet) const;
+    private:
+        Q_DISABLE_COPY(DataBundle)
+
+        enum SectionType {
+            CountryCodeSection, AirportSection, AirportBucketSection, AirportSlotSection, AirlineSection,
+            SectorSection, SectorPointSection, CoastlineSection, CoastlinePointSection,
+            CountryLineSection, CountryLinePointSection, StringSection, SectionCount
+        };
+        static const int sourceCount = 7;
+        struct Source {
+            qint64 size, modifiedMsecs;
+        };
+        struct Section {
+            qint64 offset, count; // count in records, bytes for the strings
+        };
+        struct Header {
+            quint32 magic, version;
+            Source sources[sourceCount];
+            Section sections[SectionCount];
+        };
+        struct CountryCodeRecord {
+            quint32 code, name; // offsets into the string table
+        };
+        struct AirportRecord {
+            double lat, lon;
+            quint32 label, name, city, countryCode;
+        };
+        struct AirlineRecord {
+            quint32 code, name, callsign, country;
+        };
+        struct SectorRecord {
+            quint32 icao, name, id;
+            quint32 firstPoint, pointCount, reserved;
+            double centerLat, centerLon;
+        };
+        struct LineRecord {
+            quint32 firstPoint, pointCount;
+        };
+
+        static bool sourceStatus(Source *sources);
+        static quint32 icaoHash(const QString &icao, quint32 seed);
+        static bool buildPerfectHash(const QStringList &keys, QVector<quint32> &buckets, QVector<quint32> &slots);
+        template<typename T> const T *section(SectionType type) const {
+            return reinterpret_cast<const T*>(_map + header()->sections[type].offset);
+        }
+        qint64 count(SectionType type) const { return header()->sections[type].count; }
+        const Header *header() const { return reinterpret_cast<const Header*>(_map); }
+        QString string(quint32 offset) const;
+
+        QFile _file;
+        uchar *_map;
+        mutable QHash<quint32, QString> _strings; // shared copies, e.g. of the country codes
+};
+
+#endif /* DATABUNDLE_H_ */
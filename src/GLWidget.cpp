@@ -5,6 +5,7 @@
 #include "GLWidget.h"
 
 #include "helpers.h"
+#include "DataBundle.h"
 #include "LineReader.h"
 #include "Pilot.h"
 #include "Controller.h"
@@ -37,7 +38,7 @@ GLWidget::GLWidget(QGLFormat fmt, QWidget *parent) :
         _controllerLabelZoomTreshold(2.), _allWaypointsLabelZoomTreshold(.1),
         _usedWaypointsLabelZoomThreshold(1.2),
         _xRot(0), _yRot(0), _zRot(0), _zoom(2), _aspectRatio(1),
-        _highlighter(0) {
+        _highlighter(0), _whazzupGeneration(-1) {
     setAutoFillBackground(false);
     setMouseTracking(true);
 
@@ -230,18 +231,18 @@ void GLWidget::createPilotsList() {
 
     glNewList(_pilotsList, GL_COMPILE);
 
-    QList<Pilot*> pilots = Whazzup::instance()->whazzupData().pilots.values();
+    const PilotTable pilots = Whazzup::instance()->whazzupData().pilotTable;
 
     // aircraft dots
     if (Settings::pilotDotSize() > 0.) {
         glPointSize(Settings::pilotDotSize());
         glBegin(GL_POINTS);
         qglColor(Settings::pilotDotColor());
-        foreach(const Pilot *p, pilots) {
-            if (qFuzzyIsNull(p->lat) && qFuzzyIsNull(p->lon))
+        for (int i = 0; i < pilots.size(); i++) {
+            if (!pilots.hasPosition(i))
                 continue;
 
-            VERTEX(p->lat, p->lon);
+            VERTEX(pilots.lat[i], pilots.lon[i]);
         }
         glEnd();
     }
@@ -251,15 +252,19 @@ void GLWidget::createPilotsList() {
         glLineWidth(Settings::timeLineStrength());
         glBegin(GL_LINES);
         qglColor(Settings::leaderLineColor());
-        foreach(const Pilot *p, pilots) {
-            if (p->groundspeed < 30)
+        const double hours = Settings::timelineSeconds() / 3600.;
+        for (int i = 0; i < pilots.size(); i++) {
+            if (pilots.groundspeed[i] < 30)
                 continue;
 
-            if (qFuzzyIsNull(p->lat) && qFuzzyIsNull(p->lon))
+            if (!pilots.hasPosition(i))
                 continue;
 
-            VERTEX(p->lat, p->lon);
-            QPair<double, double> pos = p->positionInFuture(Settings::timelineSeconds());
+            VERTEX(pilots.lat[i], pilots.lon[i]);
+            // same as Pilot::positionInFuture()
+            QPair<double, double> pos = NavData::pointDistanceBearing(
+                pilots.lat[i], pilots.lon[i], pilots.groundspeed[i] * hours, pilots.trueHeading[i]
+            );
             VERTEX(pos.first, pos.second);
         }
         glEnd();
@@ -696,14 +701,24 @@ void GLWidget::createStaticLists() {
     if (Settings::coastLineStrength() > 0.0) {
         qglColor(Settings::coastLineColor());
         glLineWidth(Settings::coastLineStrength());
-        LineReader lineReader(Settings::dataDirectory("data/coastline.dat"));
-        QList<QPair<double, double> > line = lineReader.readLine();
-        while (!line.isEmpty()) {
-            glBegin(GL_LINE_STRIP);
-            for (int i = 0; i < line.size(); i++)
-                VERTEX(line[i].first, line[i].second);
-            glEnd();
-            line = lineReader.readLine();
+        DataBundle bundle;
+        if (bundle.open()) {
+            foreach (const DataBundle::Polyline &polyline, bundle.lines(DataBundle::Coastlines)) {
+                glBegin(GL_LINE_STRIP);
+                for (int i = 0; i < polyline.count; i++)
+                    VERTEX(polyline.points[i].lat, polyline.points[i].lon);
+                glEnd();
+            }
+        } else {
+            LineReader lineReader(Settings::dataDirectory("data/coastline.dat"));
+            QList<QPair<double, double> > line = lineReader.readLine();
+            while (!line.isEmpty()) {
+                glBegin(GL_LINE_STRIP);
+                for (int i = 0; i < line.size(); i++)
+                    VERTEX(line[i].first, line[i].second);
+                glEnd();
+                line = lineReader.readLine();
+            }
         }
     }
     glEndList();
@@ -715,17 +730,27 @@ void GLWidget::createStaticLists() {
     if (Settings::countryLineStrength() > 0.0) {
         qglColor(Settings::countryLineColor());
         glLineWidth(Settings::countryLineStrength());
-        LineReader countries = LineReader(Settings::dataDirectory("data/countries.dat"));
-        QList<QPair<double, double> > line = countries.readLine();
-        glBegin(GL_LINE);
-        while (!line.isEmpty()) {
-            glBegin(GL_LINE_STRIP);
-            for (int i = 0; i < line.size(); i++)
-                VERTEX(line[i].first, line[i].second);
+        DataBundle bundle;
+        if (bundle.open()) {
+            foreach (const DataBundle::Polyline &polyline, bundle.lines(DataBundle::CountryLines)) {
+                glBegin(GL_LINE_STRIP);
+                for (int i = 0; i < polyline.count; i++)
+                    VERTEX(polyline.points[i].lat, polyline.points[i].lon);
+                glEnd();
+            }
+        } else {
+            LineReader countries = LineReader(Settings::dataDirectory("data/countries.dat"));
+            QList<QPair<double, double> > line = countries.readLine();
+            glBegin(GL_LINE);
+            while (!line.isEmpty()) {
+                glBegin(GL_LINE_STRIP);
+                for (int i = 0; i < line.size(); i++)
+                    VERTEX(line[i].first, line[i].second);
+                glEnd();
+                line = countries.readLine();
+            }
             glEnd();
-            line = countries.readLine();
         }
-        glEnd();
     }
     glEndList();
 
@@ -739,13 +764,15 @@ void GLWidget::createStaticLists() {
         double sin30 = .5; double cos30 = .8660254037;
         double tri_c = .01; double tri_a = tri_c * cos30; double tri_b = tri_c * sin30;
         glBegin(GL_TRIANGLES);
-        foreach( Waypoint *w, Airac::instance()->allPoints) {
-            if(w->type() == 1) {
-                double circle_distort = qCos(w->lat * Pi180);
+        const NavStore &store = Airac::instance()->store();
+        for (int i = 0; i < store.size(); i++) {
+            const NavStore::Point &w = store.point(i);
+            if(w.type == 1) {
+                double circle_distort = qCos(w.lat * Pi180);
                 double tri_b_c = tri_b * circle_distort;
-                VERTEX(w->lat - tri_b_c, w->lon - tri_a);
-                VERTEX(w->lat - tri_b_c, w->lon + tri_a);
-                VERTEX(w->lat + tri_c * circle_distort, w->lon);
+                VERTEX(w.lat - tri_b_c, w.lon - tri_a);
+                VERTEX(w.lat - tri_b_c, w.lon + tri_a);
+                VERTEX(w.lat + tri_c * circle_distort, w.lon);
             }
         }
         glEnd();
@@ -1197,8 +1224,10 @@ void GLWidget::mouseMoveEvent(QMouseEvent *event) {
     double lat, lon;
     if (mouse2latlon(currentPos.x(), currentPos.y(), lat, lon)) {
         QSet<Controller*> _newHoveredControllers;
-        foreach(Controller *c, Whazzup::instance()->whazzupData().controllers.values()) {
-            if (c->sector != 0 && c->sector->containsPoint(QPointF(lat, lon))) {
+        _sectorsAtCursor.clear();
+        NavData::instance()->sectorIndex.sectorsAt(lat, lon, _sectorsAtCursor);
+        foreach(Controller *c, Whazzup::instance()->whazzupData().controllers) {
+            if (c->sector != 0 && _sectorsAtCursor.contains(c->sector)) {
                 _newHoveredControllers.insert(c);
             } else { // APP, TWR, GND, DEL
                 int maxDist_nm = -1;
@@ -1700,22 +1729,20 @@ QList<MapObject*> GLWidget::objectsAt(int x, int y, double radius) const {
     if(!mouse2latlon(x, y, lat, lon)) // returns false if not on globe
         return result;
 
-    double radiusDegQuad = Nm2Deg((qFuzzyIsNull(radius)? 30. * _zoom: radius));
+    const double radiusNm = qFuzzyIsNull(radius)? 30. * _zoom: radius;
+    double radiusDegQuad = Nm2Deg(radiusNm);
     radiusDegQuad *= radiusDegQuad;
 
-    foreach(Airport* a, NavData::instance()->airports.values()) {
+    foreach(Airport* a, NavData::instance()->airportIndex.within(lat, lon, radiusNm)) {
         if(a->active) {
-            double x = a->lat - lat;
-            double y = a->lon - lon;
-            if(x*x + y*y < radiusDegQuad) {
-                result.removeAll(a);
-                result.append(a);
-            }
+            result.removeAll(a);
+            result.append(a);
         }
     }
 
-    foreach(Controller *c, Whazzup::instance()->whazzupData().controllers.values()) {
-        if (c->sector != 0 && c->sector->containsPoint(QPointF(lat, lon))) { // controllers with sectors
+    const QVector<Sector*> sectorsAt = NavData::instance()->sectorIndex.sectorsAt(lat, lon);
+    foreach(Controller *c, Whazzup::instance()->whazzupData().controllers) {
+        if (c->sector != 0 && sectorsAt.contains(c->sector)) { // controllers with sectors
             result.removeAll(c);
             result.append(c);
         } else { // APP, TWR, GND, DEL
@@ -1738,12 +1765,13 @@ QList<MapObject*> GLWidget::objectsAt(int x, int y, double radius) const {
         }
     }
 
-    foreach(Pilot *p, Whazzup::instance()->whazzupData().pilots.values()) {
-        double x = p->lat - lat;
-        double y = p->lon - lon;
+    const PilotTable pilots = Whazzup::instance()->whazzupData().pilotTable;
+    for (int i = 0; i < pilots.size(); i++) {
+        double x = pilots.lat[i] - lat;
+        double y = pilots.lon[i] - lon;
         if(x*x + y*y < radiusDegQuad) {
-            result.removeAll(p);
-            result.append(p);
+            result.removeAll(pilots.pilot[i]);
+            result.append(pilots.pilot[i]);
         }
     }
 
@@ -1887,15 +1915,23 @@ void GLWidget::drawCoordinateAxii() const {
 void GLWidget::newWhazzupData(bool isNew) {
     qDebug() << "GLWidget::newWhazzupData() isNew =" << isNew;
     if(isNew) {
+        const WhazzupData &data = Whazzup::instance()->whazzupData();
+        // sectors only need to be rebuilt when controllers changed since we last looked
+        const bool controllersChanged = !data.lastDelta().followsGeneration(_whazzupGeneration)
+                || data.lastDelta().hasControllerChanges();
+
         // update airports
-        NavData::instance()->updateData(Whazzup::instance()->whazzupData());
+        NavData::instance()->updateData(data);
 
-        _sectorsToDraw = Whazzup::instance()->whazzupData().controllersWithSectors();
+        if(controllersChanged)
+            _sectorsToDraw = data.controllersWithSectors();
 
         createPilotsList();
         createAirportsList();
-        createControllersLists();
-        _friends = Whazzup::instance()->whazzupData().friendsLatLon();
+        if(controllersChanged)
+            createControllersLists();
+        _friends = data.friendsLatLon();
+        _whazzupGeneration = data.generation();
 
         updateGL();
     }
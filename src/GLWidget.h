@@ -120,12 +120,14 @@ class GLWidget : public QGLWidget {
         _staticSectorPolygonsList, _staticSectorPolygonBorderLinesList,
         _hoveredSectorPolygonsList, _hoveredSectorPolygonBorderLinesList;
         QSet<Controller*> _sectorsToDraw, _hoveredControllers;
+        QVector<Sector*> _sectorsAtCursor; // reused by mouseMoveEvent()
         double _sondeLabelZoomTreshold, _pilotLabelZoomTreshold,
                 _activeAirportLabelZoomTreshold, _inactiveAirportLabelZoomTreshold,
         _controllerLabelZoomTreshold, _allWaypointsLabelZoomTreshold, _usedWaypointsLabelZoomThreshold,
         _xRot, _yRot, _zRot, _zoom, _aspectRatio;
         QTimer *_highlighter;
         QList< QPair<double , double> > _friends;
+        int _whazzupGeneration; // of the WhazzupData the lists were created from
 };
 
 #endif /*GLWIDGET_H_*/
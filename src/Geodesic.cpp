@@ -0,0 +1,227 @@
+/**************************************************************************
+ *  This file is part of QuteScoop. See README for license
+ **************************************************************************/
+
+#include "Geodesic.h"
+
+#include "helpers.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define GEODESIC_SSE2
+#endif
+
+static inline double dot(const Geodesic::Vector &a, const Geodesic::Vector &b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+// length of a x b
+static inline double crossNorm(double ax, double ay, double az, double bx, double by, double bz) {
+    const double cx = ay * bz - az * by, cy = az * bx - ax * bz, cz = ax * by - ay * bx;
+    return qSqrt(cx * cx + cy * cy + cz * cz);
+}
+
+Geodesic::Vector Geodesic::vector(double lat, double lon) {
+    const double la = lat * Pi180, lo = lon * Pi180;
+    const Vector v = { qCos(la) * qCos(lo), qCos(la) * qSin(lo), qSin(la) };
+    return v;
+}
+
+double Geodesic::lat(const Vector &v) {
+    return qAtan2(v.z, qSqrt(v.x * v.x + v.y * v.y)) / Pi180;
+}
+
+double Geodesic::lon(const Vector &v) {
+    return qAtan2(v.y, v.x) / Pi180;
+}
+
+double Geodesic::distance(const Vector &a, const Vector &b) {
+    return qAtan2(crossNorm(a.x, a.y, a.z, b.x, b.y, b.z), dot(a, b)) * nmPerRadian;
+}
+
+double Geodesic::distance(double lat1, double lon1, double lat2, double lon2) {
+    const double sinLat = qSin((lat2 - lat1) * Pi180 / 2.), sinLon = qSin((lon2 - lon1) * Pi180 / 2.);
+    const double h = qMin(1., sinLat * sinLat + qCos(lat1 * Pi180) * qCos(lat2 * Pi180) * sinLon * sinLon);
+    return 2. * qAtan2(qSqrt(h), qSqrt(1. - h)) * nmPerRadian;
+}
+
+void Geodesic::localFrame(const Vector &v, Vector &north, Vector &east) {
+    const double r = qSqrt(v.x * v.x + v.y * v.y);
+    if (r < 1e-15) {
+        const Vector n = { -v.z, 0., 0. }, e = { 0., 1., 0. };
+        north = n;
+        east = e;
+        return;
+    }
+    const Vector n = { -v.z * v.x / r, -v.z * v.y / r, r }, e = { -v.y / r, v.x / r, 0. };
+    north = n;
+    east = e;
+}
+
+double Geodesic::course(const Vector &from, const Vector &to) {
+    Vector north, east;
+    localFrame(from, north, east);
+    const double result = qAtan2(dot(to, east), dot(to, north)) / Pi180;
+    return result < 0.? result + 360.: result;
+}
+
+double Geodesic::course(double lat1, double lon1, double lat2, double lon2) {
+    const double la1 = lat1 * Pi180, la2 = lat2 * Pi180, dLon = (lon2 - lon1) * Pi180;
+    const double result = qAtan2(qSin(dLon) * qCos(la2),
+                                 qCos(la1) * qSin(la2) - qSin(la1) * qCos(la2) * qCos(dLon)) / Pi180;
+    return result < 0.? result + 360.: result;
+}
+
+Geodesic::Vector Geodesic::destination(const Vector &start, double dist, double course) {
+    Vector north, east;
+    localFrame(start, north, east);
+    const double d = dist / nmPerRadian, c = course * Pi180;
+    const double cosD = qCos(d), sinD = qSin(d), n = sinD * qCos(c), e = sinD * qSin(c);
+    const Vector v = {
+        cosD * start.x + n * north.x + e * east.x,
+        cosD * start.y + n * north.y + e * east.y,
+        cosD * start.z + n * north.z + e * east.z
+    };
+    return v;
+}
+
+Geodesic::Vector Geodesic::fraction(const Vector &a, const Vector &b, double f) {
+    const double sinD = crossNorm(a.x, a.y, a.z, b.x, b.y, b.z);
+    if (sinD < 1e-15) {
+        return a;
+    }
+    const double d = qAtan2(sinD, dot(a, b));
+    const double wa = qSin((1. - f) * d) / sinD, wb = qSin(f * d) / sinD;
+    const Vector v = { wa * a.x + wb * b.x, wa * a.y + wb * b.y, wa * a.z + wb * b.z };
+    return v;
+}
+
+void Geodesic::distances(const Vector &from, const Points &to, double *result) {
+    const double *x = to.x.constData(), *y = to.y.constData(), *z = to.z.constData();
+    for (int i = 0; i < to.size(); i++) {
+        result[i] = qAtan2(crossNorm(from.x, from.y, from.z, x[i], y[i], z[i]),
+                           from.x * x[i] + from.y * y[i] + from.z * z[i]) * nmPerRadian;
+    }
+}
+
+void Geodesic::distances(const Points &a, const Points &b, double *result) {
+    Q_ASSERT(a.size() == b.size());
+    const double *ax = a.x.constData(), *ay = a.y.constData(), *az = a.z.constData();
+    const double *bx = b.x.constData(), *by = b.y.constData(), *bz = b.z.constData();
+    for (int i = 0; i < a.size(); i++) {
+        result[i] = qAtan2(crossNorm(ax[i], ay[i], az[i], bx[i], by[i], bz[i]),
+                           ax[i] * bx[i] + ay[i] * by[i] + az[i] * bz[i]) * nmPerRadian;
+    }
+}
+
+/**
+  The closest point has the largest dot product, no angle is needed.
+**/
+int Geodesic::nearest(const Vector &from, const Points &to) {
+    const int n = to.size();
+    const double *x = to.x.constData(), *y = to.y.constData(), *z = to.z.constData();
+    int best = -1;
+    double bestDot = -2.;
+    int i = 0;
+#ifdef GEODESIC_SSE2
+    const __m128d fx = _mm_set1_pd(from.x), fy = _mm_set1_pd(from.y), fz = _mm_set1_pd(from.z);
+    __m128d bestDots = _mm_set1_pd(-2.);
+    for (; i + 1 < n; i += 2) {
+        const __m128d d = _mm_add_pd(_mm_add_pd(_mm_mul_pd(fx, _mm_loadu_pd(x + i)),
+                                                _mm_mul_pd(fy, _mm_loadu_pd(y + i))),
+                                     _mm_mul_pd(fz, _mm_loadu_pd(z + i)));
+        // only look at the lanes when one of them is better
+        if (_mm_movemask_pd(_mm_cmpgt_pd(d, bestDots)) != 0) {
+            double lanes[2];
+            _mm_storeu_pd(lanes, d);
+            for (int lane = 0; lane < 2; lane++) {
+                if (lanes[lane] > bestDot) {
+                    bestDot = lanes[lane];
+                    best = i + lane;
+                }
+            }
+            bestDots = _mm_set1_pd(bestDot);
+        }
+    }
+#endif
+    for (; i < n; i++) {
+        const double d = from.x * x[i] + from.y * y[i] + from.z * z[i];
+        if (d > bestDot) {
+            bestDot = d;
+            best = i;
+        }
+    }
+    return best;
+}
+
+int Geodesic::countWithin(const Vector &from, const Points &to, double nm) {
+    const int n = to.size();
+    const double *x = to.x.constData(), *y = to.y.constData(), *z = to.z.constData();
+    const double limit = cosDistance(nm);
+    int count = 0;
+    int i = 0;
+#ifdef GEODESIC_SSE2
+    const __m128d fx = _mm_set1_pd(from.x), fy = _mm_set1_pd(from.y), fz = _mm_set1_pd(from.z);
+    const __m128d limits = _mm_set1_pd(limit);
+    for (; i + 1 < n; i += 2) {
+        const __m128d d = _mm_add_pd(_mm_add_pd(_mm_mul_pd(fx, _mm_loadu_pd(x + i)),
+                                                _mm_mul_pd(fy, _mm_loadu_pd(y + i))),
+                                     _mm_mul_pd(fz, _mm_loadu_pd(z + i)));
+        const int mask = _mm_movemask_pd(_mm_cmpgt_pd(d, limits));
+        count += (mask & 1) + (mask >> 1);
+    }
+#endif
+    for (; i < n; i++) {
+        count += from.x * x[i] + from.y * y[i] + from.z * z[i] > limit;
+    }
+    return count;
+}
+
+/**
+  The points are cos(t) a + sin(t) w with w the unit vector perpendicular
+  to a towards b, so the angle t only needs one sin/cos per call; the
+  rotation by one step is applied by multiplication.
+**/
+void Geodesic::interpolate(const Vector &a, const Vector &b, double step, int count, Points &result) {
+    result.reserve(result.size() + count);
+    const double sinD = crossNorm(a.x, a.y, a.z, b.x, b.y, b.z);
+    if (sinD < 1e-15) {
+        for (int k = 0; k < count; k++) {
+            result.append(a);
+        }
+        return;
+    }
+    const double cosD = dot(a, b);
+    const Vector w = { (b.x - cosD * a.x) / sinD, (b.y - cosD * a.y) / sinD, (b.z - cosD * a.z) / sinD };
+    const double delta = step * qAtan2(sinD, cosD), cosDelta = qCos(delta), sinDelta = qSin(delta);
+    double c = 1., s = 0.;
+    for (int k = 0; k < count; k++) {
+        const Vector v = { c * a.x + s * w.x, c * a.y + s * w.y, c * a.z + s * w.z };
+        result.append(v);
+        const double next = c * cosDelta - s * sinDelta;
+        s = s * cosDelta + c * sinDelta;
+        c = next;
+    }
+}
+
+void Geodesic::circle(const Vector &center, double dist, double firstCourse, double courseStep, int count,
+                      Points &result) {
+    result.reserve(result.size() + count);
+    Vector north, east;
+    localFrame(center, north, east);
+    const double d = dist / nmPerRadian, cosR = qCos(d), sinR = qSin(d);
+    const double step = courseStep * Pi180, cosStep = qCos(step), sinStep = qSin(step);
+    double c = qCos(firstCourse * Pi180), s = qSin(firstCourse * Pi180);
+    for (int k = 0; k < count; k++) {
+        const double n = sinR * c, e = sinR * s;
+        const Vector v = {
+            cosR * center.x + n * north.x + e * east.x,
+            cosR * center.y + n * north.y + e * east.y,
+            cosR * center.z + n * north.z + e * east.z
+        };
+        result.append(v);
+        const double next = c * cosStep - s * sinStep;
+        s = s * cosStep + c * sinStep;
+        c = next;
+    }
+}
@@ -0,0 +1,92 @@
+/**************************************************************************
+ *  This file is part of QuteScoop. See README for license
+ **************************************************************************/
+
+#ifndef GEODESIC_H_
+#define GEODESIC_H_
+
+#include <QtCore>
+
+/**
+  Great circle math on unit vectors (x towards 0/0, y towards 0/90E,
+  z towards the north pole). A position is converted once; distances,
+  courses and interpolation are then dot and cross products, with one
+  atan2 where an angle is needed instead of acos of a trig sum. For a
+  single pair the lat/lon forms of distance() and course() are cheaper
+  than converting both points.
+  The batch functions work on Points, parallel x/y/z arrays. nearest() and
+  countWithin() only compare dot products and use SSE2 where the compiler
+  has it; the loops of the others are plain enough to be vectorized.
+
+  Agreement with the trigonometric formulas that NavData used before,
+  over random pairs (Benchmark::geodesic() measures it again):
+  - distance: within 1e-6 nm
+  - course: within 1e-3 degrees, the old acos form was that coarse for
+    short legs. Due north is 0 instead of 360, coincident points give 0
+    instead of NaN.
+  - fraction and interpolate: within 1e-9 nm
+  - destination: the old formula had sin(start lat)^2 where
+    sin(start lat) * sin(end lat) belongs in the longitude term. It was
+    off by ~0.4% of the distance near the equator and ~1.3% at 60 degrees
+    for legs up to 50 nm, growing with the distance and towards the poles.
+    This one is exact: distance and course back agree within 1e-9.
+    Longitudes are in [-180, 180], the old one could return below -180.
+**/
+class Geodesic {
+    public:
+        struct Vector {
+            double x, y, z;
+        };
+        struct Points {
+            void append(double lat, double lon) { append(vector(lat, lon)); }
+            void append(const Vector &v) { x.append(v.x); y.append(v.y); z.append(v.z); }
+            void reserve(int n) { x.reserve(n); y.reserve(n); z.reserve(n); }
+            void clear() { x.clear(); y.clear(); z.clear(); }
+            int size() const { return x.size(); }
+            Vector at(int i) const { const Vector v = { x[i], y[i], z[i] }; return v; }
+            double lat(int i) const { return Geodesic::lat(at(i)); }
+            double lon(int i) const { return Geodesic::lon(at(i)); }
+
+            QVector<double> x, y, z;
+        };
+
+        static Vector vector(double lat, double lon);
+        static double lat(const Vector &v);
+        static double lon(const Vector &v);
+
+        // nm
+        static double distance(const Vector &a, const Vector &b);
+        // the same for a single pair in degrees, without converting both points (haversine)
+        static double distance(double lat1, double lon1, double lat2, double lon2);
+        // initial true course from a to b in [0, 360)
+        static double course(const Vector &from, const Vector &to);
+        static double course(double lat1, double lon1, double lat2, double lon2);
+        // the point dist nm from start on the initial true course
+        static Vector destination(const Vector &start, double dist, double course);
+        // f = 0 is a, 1 is b, outside of that extrapolated along the great circle
+        static Vector fraction(const Vector &a, const Vector &b, double f);
+        // the cosine of a distance in nm, to compare with dot products
+        static double cosDistance(double nm) { return qCos(nm / nmPerRadian); }
+
+        // batches. result has room for all points.
+        // distances from one point to each of to
+        static void distances(const Vector &from, const Points &to, double *result);
+        // distances of a[i] to b[i]
+        static void distances(const Points &a, const Points &b, double *result);
+        // the index of the point of to closest to from, -1 if to is empty
+        static int nearest(const Vector &from, const Points &to);
+        // how many points of to are within nm of from
+        static int countWithin(const Vector &from, const Points &to, double nm);
+        // count points from a towards b in steps of fraction step, starting with a itself
+        static void interpolate(const Vector &a, const Vector &b, double step, int count, Points &result);
+        // count points dist nm from center, on courses firstCourse, firstCourse + courseStep, ...
+        static void circle(const Vector &center, double dist, double firstCourse, double courseStep, int count,
+                           Points &result);
+
+        static constexpr double nmPerRadian = 60. * 180. / M_PI;
+    private:
+        // unit vectors towards north and east at v, at the poles as seen from longitude 0
+        static void localFrame(const Vector &v, Vector &north, Vector &east);
+};
+
+#endif /* GEODESIC_H_ */
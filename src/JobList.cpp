@@ -4,48 +4,107 @@
 
 #include "JobList.h"
 #include <QDebug>
+#include <QMetaObject>
 
 JobList::JobList(QObject *parent) :
     QObject(parent) {
 }
 
-void JobList::append(JobList::Job job) {
-    jobs.append(job);
+int JobList::append(JobList::Job job) {
+    QList<int> dependencies;
+    if (!jobs.isEmpty())
+        dependencies << jobs.size() - 1;
+    return append(job, dependencies);
+}
+
+int JobList::append(JobList::Job job, const QList<int> &dependencies) {
+    Node node = { job, dependencies, Waiting, -1, -1 };
+    foreach (int id, dependencies)
+        Q_ASSERT(id >= 0 && id < jobs.size()); // only earlier jobs, so there are no cycles
+    jobs.append(node);
+    return jobs.size() - 1;
 }
 
 void JobList::start() {
-    // qDebug() << "JobList::start()";
-    for (int i = 0; i < jobs.size(); i++) {
-        if (i + 1 < jobs.size()) {
-            // qDebug() << "JobList::start() connecting" << jobs[i].obj << jobs[i].finishSignal
-            //         << ">>" << jobs[i + 1].obj << jobs[i + 1].start;
-            jobs[i + 1].obj->connect(
-                    jobs[i].obj, jobs[i].finishSignal,
-                    jobs[i + 1].start
-            );
-        } else {
-            // qDebug() << "JobList::start() connecting" << jobs[i].obj << jobs[i].finishSignal
-            //         << ">>" << this << SLOT(finish());
-            connect(jobs[i].obj, jobs[i].finishSignal,
-                    SLOT(finish()));
-        }
-    }
+    _clock.start();
+    emit started();
     if (jobs.isEmpty()) {
-        connect(this, &JobList::started, this, &JobList::finish);
+        emit finished();
+        return;
     }
-    else {
-        jobs[0].obj->connect(this, SIGNAL(started()), jobs[0].start);
-        //jobs[0].obj->metaObject()->invokeMethod(jobs[0].obj, jobs[0].start);
+    startReady();
+}
+
+void JobList::startReady() {
+    for (int id = 0; id < jobs.size(); id++) {
+        Node &node = jobs[id];
+        if (node.state != Waiting)
+            continue;
+        bool ready = true;
+        foreach (int dependency, node.dependencies)
+            ready = ready && jobs[dependency].state == Done;
+        if (!ready)
+            continue;
+
+        node.state = Running;
+        node.startedMs = _clock.elapsed();
+        qDebug() << "JobList::startReady()" << node.startedMs << "ms: starting" << name(id);
+        connect(node.job.obj, node.job.finishSignal, SLOT(jobFinished()));
+        // queued, so the event loop gets a turn between jobs (e.g. for network replies)
+        const QByteArray signature = QMetaObject::normalizedSignature(node.job.start + 1);
+        QMetaObject::invokeMethod(node.job.obj, signature.left(signature.indexOf('(')).constData(),
+                                  Qt::QueuedConnection);
     }
-    // qDebug() << "JobList::start() -- finished. Jobs are started.";
-    emit started();
 }
 
-void JobList::finish() {
-    // qDebug() << "JobList::finish() emitting finished()";
+void JobList::jobFinished() {
+    for (int id = 0; id < jobs.size(); id++) {
+        Node &node = jobs[id];
+        if (node.state != Running || node.job.obj != sender())
+            continue;
+        const int signalIndex = sender()->metaObject()->indexOfSignal(
+                    QMetaObject::normalizedSignature(node.job.finishSignal + 1));
+        if (signalIndex != senderSignalIndex())
+            continue;
+
+        disconnect(node.job.obj, node.job.finishSignal, this, SLOT(jobFinished()));
+        node.state = Done;
+        node.finishedMs = _clock.elapsed();
+        qDebug() << "JobList::jobFinished()" << node.finishedMs << "ms: finished" << name(id);
+        break;
+    }
+
+    foreach (const Node &node, jobs)
+        if (node.state != Done) {
+            startReady();
+            return;
+        }
+    logTimeline();
     emit finished();
 }
 
+QString JobList::name(int id) const {
+    const Job &job = jobs[id].job;
+    QString name = QString("%1::%2").arg(job.obj->metaObject()->className(), job.start + 1);
+    if (!job.obj->objectName().isEmpty())
+        name += QString(" (%1)").arg(job.obj->objectName());
+    return name;
+}
+
+void JobList::logTimeline() const {
+    const int width = 40;
+    const qint64 total = qMax(_clock.elapsed(), (qint64) 1);
+    qDebug() << "JobList::logTimeline() all jobs finished after" << total << "ms";
+    for (int id = 0; id < jobs.size(); id++) {
+        const Node &node = jobs[id];
+        const int from = node.startedMs * width / total,
+                to = qMax((int) (node.finishedMs * width / total), from + 1);
+        const QString bar = QString(from, ' ') + QString(to - from, '#') + QString(qMax(width - to, 0), ' ');
+        qDebug().noquote() << QString("%1 - %2 ms |%3| %4")
+                              .arg(node.startedMs, 6).arg(node.finishedMs, 6).arg(bar, name(id));
+    }
+}
+
 JobList::Job::Job(QObject *obj, const char *start, const char *finishSignal) :
     obj(obj), start(start), finishSignal(finishSignal) {
 }
@@ -6,10 +6,14 @@
 #define JOBLIST_H
 
 #include <QObject>
+#include <QElapsedTimer>
 
 /**
-  A list of jobs, connected through SIGNALs and SLOTs. Will emit finished()
-  when all jobs were executed
+  A set of jobs, connected through SIGNALs and SLOTs. Each job declares the
+  jobs it depends on and is started as soon as all of them have emitted
+  their finish signal, so independent jobs (e.g. downloads and file
+  parsing) overlap. Will emit finished() and log a timeline of the run
+  when all jobs were executed.
 **/
 class JobList : public QObject {
         Q_OBJECT
@@ -21,16 +25,31 @@ class JobList : public QObject {
                 QObject *obj;
                 const char *start, *finishSignal;
         };
-        void append(Job job);
+        // depends on the job appended before, returns the id of the job
+        int append(Job job);
+        // depends on the given ids of jobs appended before, none to start right away
+        int append(Job job, const QList<int> &dependencies);
     signals:
         void started();
         void finished();
     public slots:
         void start();
     private slots:
-        void finish();
+        void jobFinished();
     private:
-        QList<Job> jobs;
+        enum State { Waiting, Running, Done };
+        struct Node {
+            Job job;
+            QList<int> dependencies;
+            State state;
+            qint64 startedMs, finishedMs;
+        };
+        QString name(int id) const;
+        void startReady();
+        void logTimeline() const;
+
+        QList<Node> jobs;
+        QElapsedTimer _clock;
 };
 
 #endif // JOBLIST_H
@@ -0,0 +1,315 @@
+/**************************************************************************
+ *  This file is part of QuteScoop. See README for license
+ **************************************************************************/
+
+#include "JsonStreamReader.h"
+
+JsonStreamReader::JsonStreamReader(const QByteArray& data) :
+    _data(data),
+    _state(ExpectValue),
+    _type(NoToken),
+    _number(0.),
+    _integer(0),
+    _isInteger(false),
+    _bool(false)
+{
+    _begin = _p = _data.constData();
+    _end = _begin + _data.size();
+
+    // skip UTF-8 byte order mark
+    if (_end - _p >= 3 && qstrncmp(_p, "\xEF\xBB\xBF", 3) == 0)
+        _p += 3;
+}
+
+JsonStreamReader::TokenType JsonStreamReader::readNext() {
+    if (_type == Invalid || _type == EndDocument)
+        return _type;
+
+    skipWhitespace();
+
+    if (_state == ExpectEndOfDocument) {
+        if (_p != _end)
+            return raiseError("Garbage after end of document");
+        _type = EndDocument;
+        return _type;
+    }
+
+    if (_p == _end)
+        return raiseError("Unexpected end of data");
+
+    if (_state == ExpectCommaOrEnd) {
+        const char container = _stack.last();
+        if (*_p == ',') {
+            ++_p;
+            skipWhitespace();
+            if (_p == _end)
+                return raiseError("Unexpected end of data");
+            _state = (container == '{'? ExpectKey: ExpectValue);
+        } else if (*_p == '}' && container == '{') {
+            ++_p;
+            _stack.removeLast();
+            return valueFinished(EndObject);
+        } else if (*_p == ']' && container == '[') {
+            ++_p;
+            _stack.removeLast();
+            return valueFinished(EndArray);
+        } else {
+            return raiseError("Expected ',' or end of container");
+        }
+    }
+
+    switch (_state) {
+        case ExpectKeyOrEndObject:
+            if (*_p == '}') {
+                ++_p;
+                _stack.removeLast();
+                return valueFinished(EndObject);
+            }
+            Q_FALLTHROUGH();
+        case ExpectKey:
+            if (*_p != '"')
+                return raiseError("Expected object key");
+            ++_p;
+            if (!readString(_text))
+                return _type;
+            skipWhitespace();
+            if (_p == _end || *_p != ':')
+                return raiseError("Expected ':' after object key");
+            ++_p;
+            _state = ExpectValue;
+            _type = Key;
+            return _type;
+        case ExpectValueOrEndArray:
+            if (*_p == ']') {
+                ++_p;
+                _stack.removeLast();
+                return valueFinished(EndArray);
+            }
+            Q_FALLTHROUGH();
+        case ExpectValue:
+            return readScalarOrStart();
+        default:
+            return raiseError("Unexpected parser state");
+    }
+}
+
+QJsonValue JsonStreamReader::readValue() {
+    readNext();
+    return currentValue();
+}
+
+QJsonValue JsonStreamReader::currentValue() {
+    switch (_type) {
+        case String:
+            return QJsonValue(_text);
+        case Number:
+            if (_isInteger)
+                return QJsonValue(_integer);
+            return QJsonValue(_number);
+        case Bool:
+            return QJsonValue(_bool);
+        case Null:
+            return QJsonValue(QJsonValue::Null);
+        case StartObject: {
+            QJsonObject object;
+            while (readNext() == Key) {
+                const QString key = _text;
+                object.insert(key, readValue());
+            }
+            return object;
+        }
+        case StartArray: {
+            QJsonArray array;
+            while (readNext() != EndArray && !hasError())
+                array.append(currentValue());
+            return array;
+        }
+        default:
+            return QJsonValue(QJsonValue::Undefined);
+    }
+}
+
+void JsonStreamReader::skipCurrentValue() {
+    if (_type != StartObject && _type != StartArray)
+        return;
+
+    int depth = 1;
+    while (depth > 0) {
+        switch (readNext()) {
+            case StartObject:
+            case StartArray:
+                depth++;
+                break;
+            case EndObject:
+            case EndArray:
+                depth--;
+                break;
+            case Invalid:
+                return;
+            default:
+                break;
+        }
+    }
+}
+
+JsonStreamReader::TokenType JsonStreamReader::raiseError(const QString& error) {
+    _error = error;
+    _type = Invalid;
+    return _type;
+}
+
+JsonStreamReader::TokenType JsonStreamReader::valueFinished(TokenType type) {
+    _state = _stack.isEmpty()? ExpectEndOfDocument: ExpectCommaOrEnd;
+    _type = type;
+    return _type;
+}
+
+JsonStreamReader::TokenType JsonStreamReader::readScalarOrStart() {
+    switch (*_p) {
+        case '{':
+            ++_p;
+            _stack.append('{');
+            _state = ExpectKeyOrEndObject;
+            _type = StartObject;
+            return _type;
+        case '[':
+            ++_p;
+            _stack.append('[');
+            _state = ExpectValueOrEndArray;
+            _type = StartArray;
+            return _type;
+        case '"':
+            ++_p;
+            if (!readString(_text))
+                return _type;
+            return valueFinished(String);
+        case 't':
+            if (!readLiteral("true", 4))
+                return _type;
+            _bool = true;
+            return valueFinished(Bool);
+        case 'f':
+            if (!readLiteral("false", 5))
+                return _type;
+            _bool = false;
+            return valueFinished(Bool);
+        case 'n':
+            if (!readLiteral("null", 4))
+                return _type;
+            return valueFinished(Null);
+        default:
+            if (*_p == '-' || (*_p >= '0' && *_p <= '9')) {
+                if (!readNumber())
+                    return _type;
+                return valueFinished(Number);
+            }
+            return raiseError("Unexpected character");
+    }
+}
+
+/**
+  reads a string literal, _p pointing behind the opening quote.
+  Unescaped runs are decoded in one go; escapes are appended as UTF-16 code
+  units, so surrogate pairs from \u escapes combine by themselves.
+**/
+bool JsonStreamReader::readString(QString& out) {
+    out.clear();
+    const char *segment = _p;
+    while (_p != _end) {
+        const char c = *_p;
+        if (c == '"') {
+            out.append(QString::fromUtf8(segment, int(_p - segment)));
+            ++_p;
+            return true;
+        }
+        if (c == '\\') {
+            out.append(QString::fromUtf8(segment, int(_p - segment)));
+            ++_p;
+            if (_p == _end)
+                break;
+            switch (*_p) {
+                case '"': out.append(QLatin1Char('"')); break;
+                case '\\': out.append(QLatin1Char('\\')); break;
+                case '/': out.append(QLatin1Char('/')); break;
+                case 'b': out.append(QLatin1Char('\b')); break;
+                case 'f': out.append(QLatin1Char('\f')); break;
+                case 'n': out.append(QLatin1Char('\n')); break;
+                case 'r': out.append(QLatin1Char('\r')); break;
+                case 't': out.append(QLatin1Char('\t')); break;
+                case 'u': {
+                    if (_end - _p < 5) {
+                        raiseError("Truncated unicode escape sequence");
+                        return false;
+                    }
+                    bool ok;
+                    const ushort code = QByteArray::fromRawData(_p + 1, 4).toUShort(&ok, 16);
+                    if (!ok) {
+                        raiseError("Invalid unicode escape sequence");
+                        return false;
+                    }
+                    out.append(QChar(code));
+                    _p += 4;
+                    break;
+                }
+                default:
+                    raiseError("Invalid escape sequence");
+                    return false;
+            }
+            ++_p;
+            segment = _p;
+            continue;
+        }
+        if ((uchar) c < 0x20) {
+            raiseError("Control character in string");
+            return false;
+        }
+        ++_p;
+    }
+    raiseError("Unterminated string");
+    return false;
+}
+
+bool JsonStreamReader::readNumber() {
+    const char *start = _p;
+    _isInteger = true;
+    if (*_p == '-')
+        ++_p;
+    while (_p != _end) {
+        const char c = *_p;
+        if (c >= '0' && c <= '9') {
+            ++_p;
+        } else if (c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-') {
+            _isInteger = false;
+            ++_p;
+        } else {
+            break;
+        }
+    }
+
+    const QByteArray raw = QByteArray::fromRawData(start, int(_p - start));
+    bool ok = false;
+    if (_isInteger) {
+        _integer = raw.toLongLong(&ok);
+        _isInteger = ok; // too large: fall back to double
+    }
+    _number = raw.toDouble(&ok);
+    if (!ok) {
+        raiseError("Invalid number");
+        return false;
+    }
+    return true;
+}
+
+bool JsonStreamReader::readLiteral(const char* literal, int length) {
+    if (_end - _p < length || qstrncmp(_p, literal, length) != 0) {
+        raiseError("Invalid literal");
+        return false;
+    }
+    _p += length;
+    return true;
+}
+
+inline void JsonStreamReader::skipWhitespace() {
+    while (_p != _end && (*_p == ' ' || *_p == '\n' || *_p == '\r' || *_p == '\t'))
+        ++_p;
+}
@@ -0,0 +1,75 @@
+/**************************************************************************
+ *  This file is part of QuteScoop. See README for license
+ **************************************************************************/
+
+#ifndef JSONSTREAMREADER_H_
+#define JSONSTREAMREADER_H_
+
+#include <QtCore>
+
+/**
+  A pull parser for JSON documents, similar in spirit to QXmlStreamReader.
+  Walks the raw UTF-8 buffer token by token without building a document tree,
+  so callers can pick out the values they need and skip the rest.
+  Values that are needed as a whole (e.g. a single client record) can be
+  materialized with readValue().
+**/
+class JsonStreamReader {
+    public:
+        enum TokenType {
+            NoToken, Invalid,
+            StartObject, EndObject, StartArray, EndArray,
+            Key, String, Number, Bool, Null,
+            EndDocument
+        };
+
+        JsonStreamReader(const QByteArray& data);
+
+        TokenType readNext();
+        TokenType tokenType() const { return _type; }
+
+        bool atEnd() const { return _type == EndDocument || _type == Invalid; }
+        bool hasError() const { return _type == Invalid; }
+        QString errorString() const { return _error; }
+        qint64 offset() const { return _p - _begin; }
+
+        // valid for Key and String tokens
+        const QString& text() const { return _text; }
+        // valid for Number tokens
+        double number() const { return _number; }
+        bool isInteger() const { return _isInteger; }
+        // valid for Bool tokens
+        bool boolean() const { return _bool; }
+
+        // reads the next value (including nested containers) as a QJsonValue
+        QJsonValue readValue();
+        // the value starting at the current token as a QJsonValue
+        QJsonValue currentValue();
+        // skips the value starting at the current token (no-op for scalars)
+        void skipCurrentValue();
+    private:
+        enum State {
+            ExpectValue, ExpectValueOrEndArray, ExpectKey, ExpectKeyOrEndObject,
+            ExpectCommaOrEnd, ExpectEndOfDocument
+        };
+
+        TokenType raiseError(const QString& error);
+        TokenType valueFinished(TokenType type);
+        TokenType readScalarOrStart();
+        bool readString(QString& out);
+        bool readNumber();
+        bool readLiteral(const char* literal, int length);
+        inline void skipWhitespace();
+
+        QByteArray _data;
+        const char *_begin, *_p, *_end;
+        QVector<char> _stack;
+        State _state;
+        TokenType _type;
+        QString _text, _error;
+        double _number;
+        qint64 _integer;
+        bool _isInteger, _bool;
+};
+
+#endif /*JSONSTREAMREADER_H_*/
@@ -7,6 +7,7 @@
 #include "JobList.h"
 #include "Net.h"
 #include "Airac.h"
+#include "DataBundle.h"
 #include "GuiMessage.h"
 #include "Window.h"
 #include "Whazzup.h"
@@ -96,48 +97,53 @@ void Launcher::fireUp() {
     qDebug() << "Launcher::fireUp()";
     show();
 
-    JobList *jobs = new JobList(this);
+    // outlives the launcher, which is gone before the downloads might be
+    JobList *jobs = new JobList(qApp);
+    connect(jobs, &JobList::finished, jobs, &QObject::deleteLater);
 
     // fade in launcher
     QPropertyAnimation *fadeInLauncher =
             new QPropertyAnimation(this, "windowOpacity", this);
+    fadeInLauncher->setObjectName("fadeInLauncher");
     fadeInLauncher->setDuration(1000);
     fadeInLauncher->setEndValue(1.);
     fadeInLauncher->setEasingCurve(QEasingCurve::InOutExpo);
 
-    jobs->append(JobList::Job(
+    const int fadedIn = jobs->append(JobList::Job(
             fadeInLauncher,
             SLOT(start()), SIGNAL(finished())
-    ));
+    ), {});
 
     // check for datafile updates
+    int dataReady = fadedIn;
     if (Settings::checkForUpdates()) {
-        jobs->append(JobList::Job(
+        dataReady = jobs->append(JobList::Job(
                 Launcher::instance(),
                 SLOT(checkData()), SIGNAL(dataChecked())
-        ));
+        ), { fadedIn });
     }
 
     // load airports
-    jobs->append(JobList::Job(
+    const int navDataLoaded = jobs->append(JobList::Job(
             NavData::instance(),
             SLOT(load()), SIGNAL(loaded())
-    ));
+    ), { dataReady });
 
     // load Airac
+    QList<int> windowDependencies({ navDataLoaded });
     if (Settings::useNavdata()) {
-        jobs->append(JobList::Job(
+        windowDependencies << jobs->append(JobList::Job(
             Airac::instance(),
             SLOT(load()), SIGNAL(loaded())
-        ));
+        ), { dataReady });
     }
 
     // set up main window
-    jobs->append(JobList::Job(
+    const int windowRestored = jobs->append(JobList::Job(
             Window::instance(),
             SLOT(restore()),
             SIGNAL(restored())
-    ));
+    ), windowDependencies);
 
     QPropertyAnimation *fadeOut = new QPropertyAnimation(this, "windowOpacity");
     fadeOut->setDuration(1000);
@@ -150,27 +156,36 @@ void Launcher::fireUp() {
     fadeIn->setEasingCurve(QEasingCurve::InOutExpo);
 
     QParallelAnimationGroup *animParallel = new QParallelAnimationGroup();
+    animParallel->setObjectName("crossFade");
     animParallel->addAnimation(fadeOut);
     animParallel->addAnimation(fadeIn);
     jobs->append(JobList::Job(
             animParallel,
             SLOT(start()), SIGNAL(finished())
-    ));
+    ), { windowRestored });
 
+    // the downloads do not need anything from above, they run while the files are parsed.
+    // A Whazzup that arrives early is decoded when airports, Airac and window are there.
+    Whazzup::instance()->holdProcessing();
     if (Settings::downloadOnStartup()) {
         jobs->append(JobList::Job(
                 Whazzup::instance(),
                 SLOT(downloadJson3()),
                 SIGNAL(whazzupDownloaded())
-        ));
+        ), {});
     }
+    jobs->append(JobList::Job(
+            Whazzup::instance(),
+            SLOT(releaseProcessing()),
+            SIGNAL(processingReleased())
+    ), { windowRestored });
 
     if (Settings::showSonde()) {
         jobs->append(JobList::Job(
                 SondeData::instance(),
                 SLOT(load()),
                 SIGNAL(loaded())
-        ));
+        ), {});
     }
 
     if (Settings::downloadClouds()) {
@@ -178,7 +193,7 @@ void Launcher::fireUp() {
                 Window::instance(),
                 SLOT(downloadCloud()),
                 SIGNAL(cloudDownloaded())
-        ));
+        ), {});
     }
 
     jobs->start();
@@ -311,6 +326,7 @@ void Launcher::dataFileDownloaded() {
         connect(_replyDataVersionsAndFiles, &QNetworkReply::finished, this, &Launcher::dataFileDownloaded);
     } else {
         // we are finished
+        DataBundle::compile();
         GuiMessages::infoUserAttention(
                     "These changes will take effect on the next start of QuteScoop.",
                     "New datafiles");
@@ -29,7 +29,8 @@ void ListClientsDialog::destroyInstance() {
 }
 
 ListClientsDialog::ListClientsDialog(QWidget *parent) :
-        QDialog(parent) {
+        QDialog(parent),
+        _whazzupGeneration(-1) {
     setupUi(this);
     setWindowFlags(windowFlags() ^= Qt::WindowContextHelpButtonHint);
 
@@ -92,7 +93,13 @@ void ListClientsDialog::refresh() {
             serversConnected[c->server] = serversConnected.value(c->server, 0) + 1; // count clients
         }
     }
-    _clientsModel->setClients(clients);
+    const WhazzupData::Delta &delta = data.lastDelta();
+    if (delta.followsGeneration(_whazzupGeneration) && !delta.hasPilotListChanges()
+            && delta.addedControllers.isEmpty() && delta.removedControllers.isEmpty())
+        _clientsModel->refreshClients(); // same rows: keep selection and scroll position
+    else
+        _clientsModel->setClients(clients);
+    _whazzupGeneration = data.generation();
 
     // Servers
     serversTable->clearContents();
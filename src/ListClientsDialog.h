@@ -39,6 +39,7 @@ class ListClientsDialog : public QDialog, private Ui::ListClientsDialog {
         void pingNextFromStack();
 
         QTimer _editFilterTimer;
+        int _whazzupGeneration;
 };
 
 #endif // LISTCLIENTSDIALOG_H
@@ -15,6 +15,11 @@ void ListClientsDialogModel::setClients(const QList<Client*>& clients) {
     qDebug() << "ListClientsDialogModel::setClients() -- finished";
 }
 
+void ListClientsDialogModel::refreshClients() {
+    if (!_clients.isEmpty())
+        emit dataChanged(index(0, 0), index(_clients.size() - 1, columnCount() - 1));
+}
+
 QVariant ListClientsDialogModel::headerData(int section, enum Qt::Orientation orientation, int role) const {
     if (role != Qt::DisplayRole)
         return QVariant();
@@ -90,11 +95,7 @@ QVariant ListClientsDialogModel::data(const QModelIndex &index, int role) const
             case 9: return p != 0? p->planFlighttypeString(): QString();
             case 10:
                 if (p != 0 && p->depAirport() != 0 && p->destAirport() != 0)
-                    return QString("%1").arg(
-                            NavData::distance(p->depAirport()->lat, p->depAirport()->lon,
-                                              p->destAirport()->lat, p->destAirport()->lon),
-                            5, 'f', 0, ' '
-                    );
+                    return QString("%1").arg(p->plannedDistance(), 5, 'f', 0, ' ');
                 return QString();
             case 11: return p != 0? p->planAircraft: QString();
             case 12: return p != 0? p->planRemarks: QString();
@@ -22,6 +22,7 @@ class ListClientsDialogModel : public QAbstractTableModel {
 
     public slots:
         void setClients(const QList<Client*>& clients);
+        void refreshClients(); // the clients changed their values, but not the list
         void modelSelected(const QModelIndex& index);
 
     private:
@@ -43,6 +43,15 @@ NavAid::NavAid(const QStringList&stringList) {
         _name += stringList[i] + (i > 9? " ": "");
 }
 
+NavAid::NavAid(const QString& id, double lat, double lon, const QString& regionCode,
+               int type, int freq, float hdg, const QString& name) :
+    _type((Type) type), _freq(freq), _hdg(hdg), _name(name) {
+    this->label = id;
+    this->lat = lat;
+    this->lon = lon;
+    this->regionCode = regionCode;
+}
+
 QString NavAid::typeStr(Type type) {
     QHash<Type, QString> hash;
     hash.reserve(10);
@@ -10,6 +10,8 @@
 class NavAid: public Waypoint {
     public:
         NavAid(const QStringList& stringList);
+        NavAid(const QString& id, double lat, double lon, const QString& regionCode,
+               int type, int freq, float hdg, const QString& name);
 
         enum Type {
             NDB = 2,
@@ -28,7 +30,10 @@ class NavAid: public Waypoint {
         };
         static QString typeStr(Type _type);
         virtual QString toolTip() const;
-        int type() { return _type; }
+        int type() const { return _type; }
+        int freq() const { return _freq; }
+        float hdg() const { return _hdg; }
+        QString name() const { return _name; }
 
     private:
         Type _type;
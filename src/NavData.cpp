@@ -7,7 +7,9 @@
 #include <QRegExp>
 
 #include "Airport.h"
+#include "DataBundle.h"
 #include "FileReader.h"
+#include "Geodesic.h"
 #include "SectorReader.h"
 #include "helpers.h"
 #include "Settings.h"
@@ -20,7 +22,9 @@ NavData *NavData::instance(bool createIfNoInstance) {
     return navDataInstance;
 }
 
-NavData::NavData() {
+NavData::NavData() :
+    _whazzupGeneration(-1)
+{
 }
 
 NavData::~NavData() {
@@ -31,14 +35,56 @@ NavData::~NavData() {
 }
 
 void NavData::load() {
-    loadCountryCodes(Settings::dataDirectory("data/countrycodes.dat"));
-    loadAirports(Settings::dataDirectory("data/airports.dat"));
-    loadControllerAirportsMapping(Settings::dataDirectory("data/controllerAirportsMapping.dat"));
-    loadSectors();
-    loadAirlineCodes(Settings::dataDirectory("data/airlines.dat"));
+    QElapsedTimer timer;
+    timer.start();
+    DataBundle bundle;
+    if (bundle.open()) {
+        const QVector<Airport*> bundleAirports = loadBundle(bundle);
+        loadControllerAirportsMapping(Settings::dataDirectory("data/controllerAirportsMapping.dat"),
+                                      &bundle, bundleAirports);
+        qDebug() << "NavData::load() loaded" << bundle.fileName() << "in" << timer.elapsed() << "ms";
+    } else {
+        loadCountryCodes(Settings::dataDirectory("data/countrycodes.dat"));
+        loadAirports(Settings::dataDirectory("data/airports.dat"));
+        loadControllerAirportsMapping(Settings::dataDirectory("data/controllerAirportsMapping.dat"));
+        loadSectors();
+        loadAirlineCodes(Settings::dataDirectory("data/airlines.dat"));
+        qDebug() << "NavData::load() parsed the data files in" << timer.elapsed() << "ms";
+        DataBundle::compile(); // for the next start
+    }
+    airportIndex.build(airports.values());
+    sectorIndex.build(sectors.values());
+    searchIndex.build(airports.values(), airlines.values());
+    _lookups.airports = airports;
+    _lookups.sectors = sectors;
+    _lookups.airlines = airlines;
+    _lookups.controllerAirportsMapping = m_controllerAirportsMapping;
     emit loaded();
 }
 
+QVector<Airport*> NavData::loadBundle(const DataBundle &bundle) {
+    countryCodes = bundle.countryCodes();
+
+    airports.clear();
+    activeAirports.clear();
+    const QVector<Airport*> bundleAirports = bundle.airports();
+    airports.reserve(bundleAirports.size());
+    foreach (Airport *airport, bundleAirports)
+        airports.insert(airport->label, airport);
+
+    sectors.clear();
+    foreach (Sector *sector, bundle.sectors())
+        sectors[sector->icao] = sector;
+
+    foreach(const auto _a, airlines) {
+        delete _a;
+    }
+    airlines.clear();
+    foreach (Airline *airline, bundle.airlines())
+        airlines[airline->code] = airline;
+    return bundleAirports;
+}
+
 void NavData::loadAirports(const QString& filename) {
     airports.clear();
     activeAirports.clear();
@@ -74,7 +120,8 @@ void NavData::loadAirports(const QString& filename) {
     }
 }
 
-void NavData::loadControllerAirportsMapping(const QString &filePath)
+void NavData::loadControllerAirportsMapping(const QString &filePath, const DataBundle *bundle,
+                                            const QVector<Airport*> &bundleAirports)
 {
     m_controllerAirportsMapping.clear();
     FileReader fr(filePath);
@@ -98,8 +145,15 @@ void NavData::loadControllerAirportsMapping(const QString &filePath)
         _cam.prefix = _fields[0];
         _cam.suffixes = _fields[1].split(" ", Qt::SkipEmptyParts);
         foreach(const auto _airportIcao, _fields[2].split(" ", Qt::SkipEmptyParts)) {
-            if (airports.contains(_airportIcao)) {
-                _cam.airports.append(airports.value(_airportIcao));
+            Airport *_airport = 0;
+            if (bundle != 0) {
+                const int _index = bundle->airportIndex(_airportIcao);
+                if (_index >= 0)
+                    _airport = bundleAirports[_index];
+            } else
+                _airport = airports.value(_airportIcao, 0);
+            if (_airport != 0) {
+                _cam.airports.append(_airport);
             } else {
                 auto msg = QString("While processing line '%1' from %2: Airport '%3' not found.")
                                .arg(_line, filePath, _airportIcao);
@@ -109,7 +163,7 @@ void NavData::loadControllerAirportsMapping(const QString &filePath)
             }
         }
 
-        m_controllerAirportsMapping.append(_cam);
+        m_controllerAirportsMapping[_cam.prefix].append(_cam);
     }
 }
 
@@ -171,43 +225,28 @@ void NavData::loadAirlineCodes(const QString &filePath) {
 }
 
 double NavData::distance(double lat1, double lon1, double lat2, double lon2) {
-    lat1 *= Pi180;
-    lon1 *= Pi180;
-    lat2 *= Pi180;
-    lon2 *= Pi180;
-    double result = qAcos(qSin(lat1) * qSin(lat2) + qCos(lat1) * qCos(lat2) * qCos(lon1-lon2));
-    if(qIsNaN(result))
-        return 0;
-    return result * 60.0 / Pi180;
+    return Geodesic::distance(lat1, lon1, lat2, lon2);
 }
 
 QPair<double, double> NavData::pointDistanceBearing(double lat, double lon, double dist, double heading) {
-    lat *= Pi180;
-    lon *= Pi180;
-    heading = (360 - heading) * Pi180;
-    dist = dist / 60.0 * Pi180;
-    double rlat = qAsin(qSin(lat) * qCos(dist) + qCos(lat) * qSin(dist) * qCos(heading));
-    double dlon = qAtan2(qSin(heading) * qSin(dist) * qCos(lat), qCos(dist) - qSin(lat) * qSin(lat));
-    double rlon = fmod(lon - dlon + M_PI, 2 * M_PI) - M_PI;
-
-    return QPair<double, double> (rlat / Pi180, rlon / Pi180);
+    const Geodesic::Vector v = Geodesic::destination(Geodesic::vector(lat, lon), dist, heading);
+    return QPair<double, double>(Geodesic::lat(v), Geodesic::lon(v));
 }
 
 Airport* NavData::airportAt(double lat, double lon, double maxDist) const {
-    foreach(Airport *a, airports.values())
-        if(distance(a->lat, a->lon, lat, lon) <= maxDist)
-            return a;
-    return 0;
+    return airportIndex.nearest(lat, lon, maxDist);
 }
 
-QList<Airport*> NavData::additionalMatchedAirportsForController(QString prefix, QString suffix) const
+QList<Airport*> NavLookups::additionalMatchedAirportsForController(const QString &prefix, const QString &suffix) const
 {
     QList<Airport*> ret;
-    foreach(auto _cam, m_controllerAirportsMapping) {
-        if (
-            _cam.prefix == prefix
-            && (_cam.suffixes.isEmpty() || _cam.suffixes.contains(suffix))
-        ) {
+    const QHash<QString, QList<ControllerAirportsMapping> >::const_iterator it
+            = controllerAirportsMapping.constFind(prefix);
+    if (it == controllerAirportsMapping.constEnd()) {
+        return ret;
+    }
+    foreach(const ControllerAirportsMapping &_cam, it.value()) {
+        if (_cam.suffixes.isEmpty() || _cam.suffixes.contains(suffix)) {
             ret.append(_cam.airports);
         }
     }
@@ -218,72 +257,153 @@ QList<Airport*> NavData::additionalMatchedAirportsForController(QString prefix,
 void NavData::updateData(const WhazzupData& whazzupData) {
     qApp->setOverrideCursor(QCursor(Qt::WaitCursor));
     qDebug() << "NavData::updateData() on" << airports.size() << "airports";
-    foreach(Airport *a, activeAirports.values())
-        a->resetWhazzupStatus();
-
-    QSet<Airport*> newActiveAirportsSet;
-    QList<Pilot*> allpilots = whazzupData.allPilots();
-    for(int i = 0; i < allpilots.size(); i++) {
-        Pilot *p = allpilots[i];
-        if(p == 0) continue;
-        Airport *dep = airports.value(p->planDep, 0);
-        if(dep != 0) {
-            dep->addDeparture(p);
-            newActiveAirportsSet.insert(dep);
-            if(Settings::filterTraffic()) { // Airport traffic filtered
-                if(p->distanceFromDeparture() < Settings::filterDistance())
-                    dep->numFilteredDepartures++;
+    const WhazzupData::Delta &delta = whazzupData.lastDelta();
+    _touchedAirports.clear();
+
+    if(delta.followsGeneration(_whazzupGeneration)) {
+        // only touch what changed since our last update
+        foreach(const QString &callsign, delta.removedPilots)
+            removePilot(callsign, _pilotAirports);
+        foreach(const QString &callsign, delta.flightplanChangedPilots + delta.movedPilots) {
+            Pilot *p = whazzupData.pilots.value(callsign, 0);
+            const PilotAirports attached = _pilotAirports.value(callsign);
+            // bush pilots are attached by position, so a move might change their airport
+            if(delta.flightplanChangedPilots.contains(callsign)
+                || attached.dep == 0 || attached.dep->label != p->planDep) {
+                removePilot(callsign, _pilotAirports);
+                addPilot(p, _pilotAirports);
             }
         }
-        else if(p->flightStatus() == Pilot::BUSH) { // no flightplan yet?
-            Airport *a = airportAt(p->lat, p->lon, 3.);
-            if(a != 0) {
-                a->addDeparture(p);
+        foreach(const QString &callsign, delta.addedPilots)
+            addPilot(whazzupData.pilots.value(callsign, 0), _pilotAirports);
+
+        foreach(const QString &callsign, delta.removedBookedPilots + delta.changedBookedPilots)
+            removePilot(callsign, _bookedPilotAirports);
+        foreach(const QString &callsign, delta.addedBookedPilots + delta.changedBookedPilots)
+            addPilot(whazzupData.bookedPilots.value(callsign, 0), _bookedPilotAirports);
+
+        foreach(const QString &callsign, delta.removedControllers + delta.changedControllers)
+            removeController(callsign);
+        foreach(const QString &callsign, delta.addedControllers + delta.changedControllers)
+            addController(whazzupData.controllers.value(callsign, 0));
+    } else {
+        foreach(Airport *a, activeAirports.values())
+            a->resetWhazzupStatus();
+        _pilotAirports.clear();
+        _bookedPilotAirports.clear();
+        _controllerAirports.clear();
+
+        foreach(Pilot *p, whazzupData.pilots)
+            addPilot(p, _pilotAirports);
+        foreach(Pilot *p, whazzupData.bookedPilots)
+            addPilot(p, _bookedPilotAirports);
+        foreach(Controller *c, whazzupData.controllers)
+            addController(c);
+    }
+
+    QSet<Airport*> candidates = _touchedAirports;
+    foreach(Airport *a, activeAirports)
+        candidates.insert(a);
+    updateActiveAirports(candidates);
+    searchIndex.updateClients(whazzupData);
+    _whazzupGeneration = whazzupData.generation();
+
+    qDebug() << "NavData::updateData() -- finished";
+    qApp->restoreOverrideCursor();
+}
+
+void NavData::addPilot(Pilot *p, QHash<QString, PilotAirports> &attached) {
+    if(p == 0)
+        return;
+    PilotAirports pilotAirports;
+    pilotAirports.pilot = p;
+    pilotAirports.dep = airports.value(p->planDep, 0);
+    if(pilotAirports.dep == 0 && p->flightStatus() == Pilot::BUSH) // no flightplan yet?
+        pilotAirports.dep = airportAt(p->lat, p->lon, 3.);
+    if(pilotAirports.dep != 0) {
+        pilotAirports.dep->addDeparture(p);
+        _touchedAirports.insert(pilotAirports.dep);
+    }
+    pilotAirports.dest = airports.value(p->planDest, 0);
+    if(pilotAirports.dest != 0) {
+        pilotAirports.dest->addArrival(p);
+        _touchedAirports.insert(pilotAirports.dest);
+    }
+    attached.insert(p->label, pilotAirports);
+}
+
+void NavData::removePilot(const QString &callsign, QHash<QString, PilotAirports> &attached) {
+    // the pilot might already be deleted, only use the pointer as a key
+    const PilotAirports pilotAirports = attached.take(callsign);
+    if(pilotAirports.dep != 0)
+        pilotAirports.dep->departures.remove(pilotAirports.pilot);
+    if(pilotAirports.dest != 0)
+        pilotAirports.dest->arrivals.remove(pilotAirports.pilot);
+}
+
+void NavData::addController(Controller *c) {
+    if(c == 0)
+        return;
+    const QList<Airport*> controllerAirports = c->airports();
+    foreach(Airport *a, controllerAirports) {
+        if(c->isAppDep())
+            a->addApproach(c);
+        if(c->isTwr())
+            a->addTower(c);
+        if(c->isGnd())
+            a->addGround(c);
+        if(c->isDel())
+            a->addDelivery(c);
+        if(c->isAtis())
+            a->addAtis(c);
+        _touchedAirports.insert(a);
+    }
+    _controllerAirports.insert(c->label, qMakePair(c, controllerAirports));
+}
+
+void NavData::removeController(const QString &callsign) {
+    // the controller might already be deleted, only use the pointer as a key
+    const QPair<Controller*, QList<Airport*> > attached = _controllerAirports.take(callsign);
+    foreach(Airport *a, attached.second) {
+        a->approaches.remove(attached.first);
+        a->towers.remove(attached.first);
+        a->grounds.remove(attached.first);
+        a->deliveries.remove(attached.first);
+        a->atises.remove(attached.first);
+    }
+}
+
+// recalculates activity and filtered traffic - positions change with every update
+void NavData::updateActiveAirports(const QSet<Airport*> &candidates) {
+    const bool filterTraffic = Settings::filterTraffic();
+    const int filterDistance = Settings::filterDistance();
+    const double filterArriving = Settings::filterArriving();
+
+    activeAirports.clear();
+    foreach(Airport *a, candidates) {
+        a->numFilteredDepartures = 0;
+        a->numFilteredArrivals = 0;
+        foreach(Pilot *p, a->departures) {
+            if(p->planDep != a->label) // attached by position
+                a->numFilteredDepartures++;
+            else if(filterTraffic && p->distanceFromDeparture() < filterDistance)
                 a->numFilteredDepartures++;
-                newActiveAirportsSet.insert(a);
-            }
         }
-        Airport *dest = airports.value(p->planDest, 0);
-        if(dest != 0) {
-            dest->addArrival(p);
-            newActiveAirportsSet.insert(dest);
-            if(Settings::filterTraffic()) { // Airport traffic filtered
-                if((p->distanceToDestination() < Settings::filterDistance())
-                    || (p->distanceToDestination() / p->groundspeed < Settings::filterArriving()))
-                    dest->numFilteredArrivals++;
+        if(filterTraffic) {
+            foreach(Pilot *p, a->arrivals) {
+                if((p->distanceToDestination() < filterDistance)
+                    || (p->distanceToDestination() / p->groundspeed < filterArriving))
+                    a->numFilteredArrivals++;
             }
         }
-    }
 
-    foreach(Controller *c, whazzupData.controllers) {
-        foreach(auto _airport, c->airports()) {
-            if(c->isAppDep()) {
-                _airport->addApproach(c);
-            }
-            if(c->isTwr()) {
-                _airport->addTower(c);
-            }
-            if(c->isGnd()) {
-                _airport->addGround(c);
-            }
-            if(c->isDel()) {
-                _airport->addDelivery(c);
-            }
-            if(c->isAtis()) {
-                _airport->addAtis(c);
-            }
-            newActiveAirportsSet.insert(_airport);
+        a->active = !a->departures.isEmpty() || !a->arrivals.isEmpty()
+                || !a->allControllers().isEmpty();
+        if(a->active) {
+            int congestion = a->numFilteredArrivals + a->numFilteredDepartures;
+            activeAirports.insert(congestion, a);
         }
     }
-
-    activeAirports.clear();
-    foreach(Airport *a, newActiveAirportsSet) {
-        int congestion = a->numFilteredArrivals + a->numFilteredDepartures;
-        activeAirports.insert(congestion, a);
-    }
-
-    qDebug() << "NavData::updateData() -- finished";
-    qApp->restoreOverrideCursor();
 }
 
 void NavData::accept(SearchVisitor* visitor) {
@@ -294,19 +414,7 @@ void NavData::accept(SearchVisitor* visitor) {
 }
 
 double NavData::courseTo(double lat1, double lon1, double lat2, double lon2) {
-    lat1 *= Pi180;
-    lon1 *= Pi180;
-    lat2 *= Pi180;
-    lon2 *= Pi180;
-
-    double d = qAcos(qSin(lat1) * qSin(lat2) + qCos(lat1) * qCos(lat2) * qCos(lon1-lon2));
-
-    double tc1;
-    if(qSin(lon2 - lon1) < 0.)
-        tc1 = qAcos((qSin(lat2) - qSin(lat1) * qCos(d)) / (qSin(d) * qCos(lat1)));
-    else
-        tc1 = 2 * M_PI - qAcos((qSin(lat2) - qSin(lat1) * qCos(d)) / (qSin(d) * qCos(lat1)));
-    return 360. - (tc1 / Pi180);
+    return Geodesic::course(lat1, lon1, lat2, lon2);
 }
 
 QPair<double, double> NavData::greatCircleFraction(double lat1, double lon1, double lat2, double lon2,
@@ -314,22 +422,8 @@ QPair<double, double> NavData::greatCircleFraction(double lat1, double lon1, dou
     if (qFuzzyCompare(lat1, lat2) && qFuzzyCompare(lon1, lon2))
         return QPair<double, double>(lat1, lon1);
 
-    lat1 *= Pi180;
-    lon1 *= Pi180;
-    lat2 *= Pi180;
-    lon2 *= Pi180;
-
-    double d = qAcos(qSin(lat1) * qSin(lat2) + qCos(lat1) * qCos(lat2) * qCos(lon1-lon2));
-
-    double A = qSin((1. - f) * d) / qSin(d);
-    double B = qSin(f*d) / qSin(d);
-    double x = A * qCos(lat1) * qCos(lon1) + B * qCos(lat2) * qCos(lon2);
-    double y = A * qCos(lat1) * qSin(lon1) + B * qCos(lat2) * qSin(lon2);
-    double z = A * qSin(lat1)             + B * qSin(lat2);
-    double rLat = qAtan2(z, sqrt(x*x + y*y));
-    double rLon = qAtan2(y, x);
-
-    return QPair<double, double>(rLat / Pi180, rLon / Pi180);
+    const Geodesic::Vector v = Geodesic::fraction(Geodesic::vector(lat1, lon1), Geodesic::vector(lat2, lon2), f);
+    return QPair<double, double>(Geodesic::lat(v), Geodesic::lon(v));
 }
 
 QList<QPair<double, double> > NavData::greatCirclePoints(double lat1, double lon1, double lat2, double lon2,
@@ -337,9 +431,16 @@ QList<QPair<double, double> > NavData::greatCirclePoints(double lat1, double lon
     QList<QPair<double, double> > result;
     if (qFuzzyCompare(lat1, lat2) && qFuzzyCompare(lon1, lon2))
         return (result << QPair<double, double>(lat1, lon1));
-    double fractionIncrement = qMin(1., intervalNm / NavData::distance(lat1, lon1, lat2, lon2));
+    const Geodesic::Vector a = Geodesic::vector(lat1, lon1), b = Geodesic::vector(lat2, lon2);
+    double fractionIncrement = qMin(1., intervalNm / Geodesic::distance(a, b));
+    int count = 0;
     for (double currentFraction = 0.; currentFraction < 1.; currentFraction += fractionIncrement)
-        result.append(greatCircleFraction(lat1, lon1, lat2, lon2, currentFraction));
+        count++;
+    Geodesic::Points points;
+    Geodesic::interpolate(a, b, fractionIncrement, count, points);
+    result.reserve(count);
+    for (int i = 0; i < count; i++)
+        result.append(QPair<double, double>(points.lat(i), points.lon(i)));
     return result;
 }
 
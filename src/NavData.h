@@ -8,6 +8,11 @@
 #include "Sector.h"
 #include "SearchVisitor.h"
 #include "Airline.h"
+#include "SpatialIndex.h"
+#include "SectorIndex.h"
+#include "SearchIndex.h"
+
+class DataBundle;
 
 struct ControllerAirportsMapping {
     QString prefix;
@@ -15,6 +20,24 @@ struct ControllerAirportsMapping {
     QList<Airport*> airports;
 };
 
+/**
+  What clients are resolved with when they are built: copies of the NavData
+  hashes, taken on the GUI thread. The copies are implicitly shared, so
+  taking them is cheap, and a later NavData::load() does not change them.
+  This lets WhazzupDecoder build clients on its pool threads while load()
+  refills NavData on the GUI thread. load() deletes the airlines, so only
+  keep the pointers: WhazzupDecoder drops what it decoded before a load().
+**/
+class NavLookups {
+    public:
+        QHash<QString, Airport*> airports;
+        QHash<QString, Sector*> sectors;
+        QHash<QString, Airline*> airlines;
+        QHash<QString, QList<ControllerAirportsMapping> > controllerAirportsMapping; // by prefix
+
+        QList<Airport*> additionalMatchedAirportsForController(const QString &prefix, const QString &suffix) const;
+};
+
 class NavData: public QObject {
         Q_OBJECT
     public:
@@ -36,15 +59,20 @@ class NavData: public QObject {
         virtual ~NavData();
 
         QHash<QString, Airport*> airports;
+        SpatialIndex<Airport> airportIndex; // rebuilt by load()
         QMultiMap<int, Airport*> activeAirports; // holds activeAirports sorted by congestion ascending
         QHash<QString, Sector*> sectors;
+        SectorIndex sectorIndex; // rebuilt by load()
         QHash<QString, QString> countryCodes;
         QString airline(const QString &airlineCode);
         QHash<QString, Airline*> airlines;
+        SearchIndex searchIndex; // airports and airlines rebuilt by load(), clients updated by updateData()
 
+        // the nearest airport within maxDist (nm)
         Airport* airportAt(double lat, double lon, double maxDist) const;
 
-        QList<Airport*> additionalMatchedAirportsForController(QString prefix, QString suffix) const;
+        // copies of the hashes above as of the last load(), see NavLookups
+        const NavLookups &lookups() const { return _lookups; }
 
         void updateData(const WhazzupData& whazzupData);
         void accept(SearchVisitor* visitor);
@@ -55,11 +83,30 @@ class NavData: public QObject {
     private:
         NavData();
         void loadAirports(const QString& filename);
-        void loadControllerAirportsMapping(const QString& filename);
-        QList<ControllerAirportsMapping> m_controllerAirportsMapping;
+        // ICAO codes are looked up in the bundle's index if there is one
+        void loadControllerAirportsMapping(const QString& filename, const DataBundle *bundle = 0,
+                                           const QVector<Airport*> &bundleAirports = QVector<Airport*>());
+        QHash<QString, QList<ControllerAirportsMapping> > m_controllerAirportsMapping; // by prefix
+        NavLookups _lookups;
         void loadSectors();
         void loadCountryCodes(const QString& filename);
         void loadAirlineCodes(const QString& filename);
+        QVector<Airport*> loadBundle(const DataBundle &bundle);
+
+        // what updateData() has attached to airports, to be able to detach it again
+        struct PilotAirports {
+            Pilot *pilot;
+            Airport *dep, *dest;
+        };
+        void addPilot(Pilot *p, QHash<QString, PilotAirports> &attached);
+        void removePilot(const QString &callsign, QHash<QString, PilotAirports> &attached);
+        void addController(Controller *c);
+        void removeController(const QString &callsign);
+        void updateActiveAirports(const QSet<Airport*> &candidates);
+        QHash<QString, PilotAirports> _pilotAirports, _bookedPilotAirports;
+        QHash<QString, QPair<Controller*, QList<Airport*> > > _controllerAirports;
+        QSet<Airport*> _touchedAirports;
+        int _whazzupGeneration;
 };
 
 #endif /*NAVDATA_H_*/
@@ -0,0 +1,158 @@
+/**************************************************************************
+ *  This file is part of QuteScoop. See README for license
+ **************************************************************************/
+
+#include "NavStore.h"
+
+#include <algorithm>
+#include <cstring>
+
+NavStore::NavStore() {
+    clear();
+}
+
+void NavStore::clear() {
+    _points.clear();
+    _navaids.clear();
+    _identChars.clear();
+    _identOffsets = QVector<quint32>() << 0;
+    _identBegin = QVector<quint32>() << 0;
+    _regionCodes.clear();
+    _names = QStringList() << QString();
+    _regionCodeIndices.clear();
+    _nameIndices.clear();
+    _pending.clear();
+}
+
+quint16 NavStore::internRegionCode(const QString &regionCode) {
+    const QHash<QString, quint16>::const_iterator it = _regionCodeIndices.constFind(regionCode);
+    if (it != _regionCodeIndices.constEnd()) {
+        return it.value();
+    }
+    const quint16 index = _regionCodes.size();
+    _regionCodes.append(regionCode);
+    _regionCodeIndices.insert(regionCode, index);
+    return index;
+}
+
+void NavStore::appendFix(const QString &ident, double lat, double lon, const QString &regionCode) {
+    Pending pending;
+    pending.ident = ident;
+    const Point point = { lat, lon, 0, internRegionCode(regionCode), fixType, -1, 0 };
+    pending.point = point;
+    _pending.append(pending);
+}
+
+void NavStore::appendNavaid(const QString &ident, double lat, double lon, const QString &regionCode,
+                            int type, int freq, float hdg, const QString &name) {
+    quint32 nameIndex = 0;
+    if (!name.isEmpty()) {
+        const QHash<QString, quint32>::const_iterator it = _nameIndices.constFind(name);
+        if (it != _nameIndices.constEnd()) {
+            nameIndex = it.value();
+        } else {
+            nameIndex = _names.size();
+            _names.append(name);
+            _nameIndices.insert(name, nameIndex);
+        }
+    }
+    const NavaidData navaid = { freq, hdg, nameIndex };
+    Pending pending;
+    pending.ident = ident;
+    const Point point = { lat, lon, 0, internRegionCode(regionCode), (qint16) type, _navaids.size(), 0 };
+    pending.point = point;
+    _navaids.append(navaid);
+    _pending.append(pending);
+}
+
+void NavStore::finish() {
+    Q_ASSERT(_points.isEmpty());
+    // idents are plain ASCII, so the UTF-16 order is the Latin-1 order of identRange()
+    std::stable_sort(_pending.begin(), _pending.end(),
+                     [](const Pending &a, const Pending &b) { return a.ident < b.ident; });
+    _points.reserve(_pending.size());
+    for (int i = 0; i < _pending.size(); i++) {
+        if (i == 0 || _pending[i].ident != _pending[i - 1].ident) {
+            if (i > 0) {
+                _identBegin.append(i);
+            }
+            _identChars.append(_pending[i].ident.toLatin1());
+            _identOffsets.append(_identChars.size());
+        }
+        Point point = _pending[i].point;
+        point.ident = _identOffsets.size() - 2;
+        _points.append(point);
+    }
+    if (!_points.isEmpty()) {
+        _identBegin.append(_points.size());
+    }
+    _pending.clear();
+    _pending.squeeze();
+    _nameIndices.clear();
+    _points.squeeze();
+    _navaids.squeeze();
+}
+
+QString NavStore::identString(quint32 ident) const {
+    return QString::fromLatin1(_identChars.constData() + _identOffsets[ident],
+                               _identOffsets[ident + 1] - _identOffsets[ident]);
+}
+
+QPair<int, int> NavStore::identRange(const QString &ident) const {
+    const QByteArray key = ident.toLatin1();
+    int low = 0, high = identCount();
+    while (low < high) {
+        const int middle = (low + high) / 2;
+        const int length = _identOffsets[middle + 1] - _identOffsets[middle];
+        int compare = memcmp(_identChars.constData() + _identOffsets[middle], key.constData(),
+                             qMin(length, key.size()));
+        if (compare == 0) {
+            compare = length - key.size();
+        }
+        if (compare == 0) {
+            return qMakePair((int) _identBegin[middle], (int) _identBegin[middle + 1]);
+        }
+        if (compare < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return qMakePair(0, 0);
+}
+
+int NavStore::find(const QString &ident, const QString &regionCode, int type) const {
+    const QHash<QString, quint16>::const_iterator region = _regionCodeIndices.constFind(regionCode);
+    if (region == _regionCodeIndices.constEnd()) {
+        return -1;
+    }
+    const QPair<int, int> range = identRange(ident);
+    for (int i = range.first; i < range.second; i++) {
+        // fixes by fix type, navaids by any navaid type as before
+        if (_points[i].regionCode == region.value() && ((type == fixType) == (_points[i].type == fixType))) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int NavStore::freq(int index) const {
+    return isNavaid(index)? _navaids[_points[index].navaid].freq: 0;
+}
+
+float NavStore::hdg(int index) const {
+    return isNavaid(index)? _navaids[_points[index].navaid].hdg: 0.f;
+}
+
+QString NavStore::name(int index) const {
+    return isNavaid(index)? _names[_navaids[_points[index].navaid].name]: QString();
+}
+
+qint64 NavStore::memoryUsage() const {
+    qint64 bytes = _points.capacity() * sizeof(Point) + _navaids.capacity() * sizeof(NavaidData)
+            + _identChars.capacity() + (_identOffsets.capacity() + _identBegin.capacity()) * sizeof(quint32);
+    foreach (const QString &s, _regionCodes + _names) {
+        bytes += sizeof(QString) + s.capacity() * sizeof(QChar);
+    }
+    return bytes;
+}
@@ -0,0 +1,90 @@
+/**************************************************************************
+ *  This file is part of QuteScoop. See README for license
+ **************************************************************************/
+
+#ifndef NAVSTORE_H_
+#define NAVSTORE_H_
+
+#include <QtCore>
+
+/**
+  All fixes and navaids of the AIRAC as plain records in one array, sorted
+  by ident so that the points sharing an ident are one range. Idents are
+  stored once as Latin-1 in a sorted table, region codes and navaid names
+  are small integer indices. Frequency, heading and name only exist for
+  navaids, in a second array.
+  Points are addressed by their index, Airac::point() makes a Waypoint or
+  NavAid of one when a MapObject is needed.
+  Fill with appendFix()/appendNavaid(), then finish() sorts and makes the
+  indices valid; they stay valid until the next clear().
+**/
+class NavStore {
+    public:
+        static const int fixType = 11; // like in earth_awy.dat, NavAid::Type for navaids
+
+        struct Point {
+            double lat, lon; // first, for SpatialIndex
+            quint32 ident; // index into the ident table
+            quint16 regionCode;
+            qint16 type;
+            qint32 navaid; // index into the navaid array, -1 for fixes
+            quint32 reserved;
+        };
+
+        NavStore();
+
+        void appendFix(const QString &ident, double lat, double lon, const QString &regionCode);
+        void appendNavaid(const QString &ident, double lat, double lon, const QString &regionCode,
+                          int type, int freq, float hdg, const QString &name);
+        void finish();
+        void clear();
+
+        int size() const { return _points.size(); }
+        const Point &point(int index) const { return _points[index]; }
+        int indexOf(const Point *point) const { return point - _points.constData(); }
+
+        QString ident(int index) const { return identString(_points[index].ident); }
+        QString regionCode(int index) const { return _regionCodes[_points[index].regionCode]; }
+        int type(int index) const { return _points[index].type; }
+        bool isNavaid(int index) const { return _points[index].navaid >= 0; }
+        int freq(int index) const;
+        float hdg(int index) const;
+        QString name(int index) const;
+
+        // the points with that ident are [first, second), an empty range if there are none
+        QPair<int, int> identRange(const QString &ident) const;
+        int identCount() const { return _identOffsets.size() - 1; }
+        // index of the point, -1 if there is none
+        int find(const QString &ident, const QString &regionCode, int type) const;
+
+        // bytes of all arrays and strings
+        qint64 memoryUsage() const;
+    private:
+        friend class AiracCache;
+
+        struct NavaidData {
+            qint32 freq;
+            float hdg;
+            quint32 name;
+        };
+        // a point before finish(), the ident not interned yet
+        struct Pending {
+            QString ident;
+            Point point;
+        };
+
+        QString identString(quint32 ident) const;
+        quint16 internRegionCode(const QString &regionCode);
+
+        QVector<Point> _points;
+        QVector<NavaidData> _navaids;
+        QByteArray _identChars;
+        QVector<quint32> _identOffsets; // per ident into _identChars, one more for the end
+        QVector<quint32> _identBegin; // per ident its first point, one more for the end
+        QStringList _regionCodes, _names;
+        QHash<QString, quint16> _regionCodeIndices;
+        QHash<QString, quint32> _nameIndices;
+        QVector<Pending> _pending;
+};
+
+#endif /* NAVSTORE_H_ */
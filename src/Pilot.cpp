@@ -9,7 +9,9 @@
 #include "NavData.h"
 #include "Settings.h"
 #include "Airac.h"
+#include "Geodesic.h"
 #include "helpers.h"
+#include "StringPool.h"
 
 #include <QJsonObject>
 
@@ -26,8 +28,8 @@ int Pilot::altToFl(int alt_ft, int qnh_mb)
     return qRound(fl_ft / 100.);
 }
 
-Pilot::Pilot(const QJsonObject& json, const WhazzupData* whazzup):
-        Client(json, whazzup),
+Pilot::Pilot(const QJsonObject& json, const WhazzupData* whazzup, const Derived *previous, bool samePosition):
+        Client(json, whazzup, previous),
         showDepDestLine(false),
         airline(0) {
     whazzupTime = QDateTime(whazzup->whazzupTime); // need some local reference to that
@@ -43,28 +45,32 @@ Pilot::Pilot(const QJsonObject& json, const WhazzupData* whazzup):
     // 1: The full ICAO Data, this is too long to display
     // 2: The FAA Data, this is what was displayed previously
     // 3: The short Data, consisting only of the aircraft code
-    planAircraftFull = flightPlan["aircraft"].toString();
-    planAircraft = flightPlan["aircraft_short"].toString();
-    planAircraftFaa = flightPlan["aircraft_faa"].toString();
-
-    planTAS = flightPlan["cruise_tas"].toString();
-    planDep = flightPlan["departure"].toString();
-    planAlt = flightPlan["altitude"].toString();
-    planDest = flightPlan["arrival"].toString();
-
-    QRegExp _airlineRegEx("([A-Z]{3})[0-9].*");
-    if (_airlineRegEx.exactMatch(label)) {
-        auto _capturedTexts = _airlineRegEx.capturedTexts();
-        airline = NavData::instance()->airlines.value(_capturedTexts[1], 0);
+    planAircraftFull = StringPool::intern(flightPlan["aircraft"].toString());
+    planAircraft = StringPool::intern(flightPlan["aircraft_short"].toString());
+    planAircraftFaa = StringPool::intern(flightPlan["aircraft_faa"].toString());
+
+    planTAS = StringPool::intern(flightPlan["cruise_tas"].toString());
+    planDep = StringPool::intern(flightPlan["departure"].toString());
+    planAlt = StringPool::intern(flightPlan["altitude"].toString());
+    planDest = StringPool::intern(flightPlan["arrival"].toString());
+
+    if (previous != 0) {
+        airline = previous->airline;
+    } else {
+        QRegExp _airlineRegEx("([A-Z]{3})[0-9].*");
+        if (_airlineRegEx.exactMatch(label)) {
+            auto _capturedTexts = _airlineRegEx.capturedTexts();
+            airline = whazzup->navLookups().airlines.value(_capturedTexts[1], 0);
+        }
     }
 
-    transponder = json["transponder"].toString();
-    transponderAssigned = flightPlan["assigned_transponder"].toString();
+    transponder = StringPool::intern(json["transponder"].toString());
+    transponderAssigned = StringPool::intern(flightPlan["assigned_transponder"].toString());
 
-    planRevision = QString::number(flightPlan["revision_id"].toInt());
-    planFlighttype = flightPlan["flight_rules"].toString();
-    planDeptime = flightPlan["deptime"].toString();
-    planActtime = flightPlan["deptime"].toString(); // The new data doesn't provide the actual departure
+    planRevision = StringPool::intern(QString::number(flightPlan["revision_id"].toInt()));
+    planFlighttype = StringPool::intern(flightPlan["flight_rules"].toString());
+    planDeptime = StringPool::intern(flightPlan["deptime"].toString());
+    planActtime = planDeptime; // The new data doesn't provide the actual departure
 
     QString timeEnroute = flightPlan["enroute_time"].toString();
     QString timeFuel = flightPlan["fuel_time"].toString();
@@ -77,7 +83,7 @@ Pilot::Pilot(const QJsonObject& json, const WhazzupData* whazzup):
     planEnroute_mins = timeEnroute.rightRef(2).toInt();
     planFuel_hrs = timeFuel.leftRef(2).toInt();
     planFuel_mins = timeFuel.rightRef(2).toInt();
-    planAltAirport = flightPlan["alternate"].toString();
+    planAltAirport = StringPool::intern(flightPlan["alternate"].toString());
     planRemarks = flightPlan["remarks"].toString();
     planRoute = flightPlan["route"].toString();
 
@@ -92,8 +98,7 @@ Pilot::Pilot(const QJsonObject& json, const WhazzupData* whazzup):
     else
         dayOfFlight = whazzupTime.date().addDays(-1); // started the day before
 
-
-    checkStatus();
+    derive(whazzup->navLookups().airports, previous, samePosition);
 
     // anti-idiot hack: some guys like routes like KORLI/MARPI/UA551/FOF/FUN...
     // let's keep him... waypoints() takes care of it in places where we need it.
@@ -111,23 +116,73 @@ void Pilot::showDetailsDialog() {
     infoDialog->activateWindow();
 }
 
-Pilot::FlightStatus Pilot::flightStatus() const {
-    Airport *dep = depAirport();
-    Airport *dst = destAirport();
+void Pilot::derive() {
+    derive(NavData::instance()->airports, 0, false);
+}
+
+// the times depend on whazzupTime, they are computed again in any case
+void Pilot::derive(const QHash<QString, Airport*> &airports, const Derived *previous, bool samePosition) {
+    if (previous != 0) {
+        _depAirport = previous->depAirport;
+        _destAirport = previous->destAirport;
+        _altAirport = previous->altAirport;
+        _plannedDistance = previous->plannedDistance;
+    } else {
+        _depAirport = airports.value(planDep, 0);
+        _destAirport = airports.value(planDest, 0);
+        _altAirport = airports.value(planAltAirport, 0);
+        _plannedDistance = _depAirport == 0 || _destAirport == 0? 0.:
+                NavData::distance(_depAirport->lat, _depAirport->lon, _destAirport->lat, _destAirport->lon);
+    }
+
+    if (previous != 0 && samePosition) {
+        _distanceFromDeparture = previous->distanceFromDeparture;
+        _distanceToDestination = previous->distanceToDestination;
+        _flightStatus = previous->flightStatus;
+    } else {
+        _distanceFromDeparture = _depAirport == 0? 0.: NavData::distance(lat, lon, _depAirport->lat, _depAirport->lon);
+        _distanceToDestination = _destAirport == 0? 0.: NavData::distance(lat, lon, _destAirport->lat, _destAirport->lon);
+        _flightStatus = deriveFlightStatus();
+    }
+
+    QString planDeptimeFixed = planDeptime;
+    if(planDeptime.length() == 3)
+        planDeptimeFixed.prepend("0"); // fromString("Hmm") does not handle "145" correctly -> "14:05"
+    _etd = QDateTime(dayOfFlight, QTime::fromString(planDeptimeFixed, "HHmm"), Qt::UTC);
+    _etaPlan = planEnroute_hrs < 0? QDateTime(): _etd.addSecs(planEnroute_hrs * 3600 + planEnroute_mins * 60);
+    _eta = deriveEta();
+
+    checkStatus();
+}
+
+Pilot::Derived Pilot::derived() const {
+    Derived result;
+    result.name = m_name;
+    result.homeBase = homeBase;
+    result.airline = airline;
+    result.depAirport = _depAirport;
+    result.destAirport = _destAirport;
+    result.altAirport = _altAirport;
+    result.distanceFromDeparture = _distanceFromDeparture;
+    result.distanceToDestination = _distanceToDestination;
+    result.plannedDistance = _plannedDistance;
+    result.flightStatus = _flightStatus;
+    return result;
+}
 
+Pilot::FlightStatus Pilot::deriveFlightStatus() const {
     // flying?
     const bool flying = groundspeed > 50 || altitude > 9000;
 
-    if (dep == 0 || dst == 0) {
+    if (_depAirport == 0 || _destAirport == 0) {
         if(flying)
             return EN_ROUTE;
         else
             return BUSH;
     }
 
-    const double totalDist = NavData::distance(dep->lat, dep->lon, dst->lat, dst->lon);
-    const double distDone = NavData::distance(lat, lon, dep->lat, dep->lon);
-    const double distRemaining = totalDist - distDone;
+    const double distDone = _distanceFromDeparture;
+    const double distRemaining = _plannedDistance - distDone;
 
     // arriving?
     const bool arriving = distRemaining < 50;
@@ -193,15 +248,13 @@ QString Pilot::flightStatusString() const {
         case BUSH: return QString();
         case EN_ROUTE: {
             result = QString();
-            Airport *dep = depAirport();
-            Airport *dst = destAirport();
-            if(dst == 0)
+            if(_destAirport == 0)
                 return result;
-            if(dep != 0) {
+            if(_depAirport != 0) {
                 // calculate %done
-                int total_dist = (int)NavData::distance(dep->lat, dep->lon, dst->lat, dst->lon);
+                int total_dist = (int)_plannedDistance;
                 if(total_dist > 0) {
-                    int dist_done = (int)NavData::distance(lat, lon, dep->lat, dep->lon);
+                    int dist_done = (int)_distanceFromDeparture;
                     result += QString("%1%").arg(dist_done * 100 / total_dist);
                 }
             }
@@ -284,40 +337,6 @@ QString Pilot::aircraftType() const {
     return planAircraft;
 }
 
-Airport *Pilot::depAirport() const {
-    if(NavData::instance()->airports.contains(planDep))
-        return NavData::instance()->airports[planDep];
-    else return 0;
-}
-
-Airport *Pilot::destAirport() const {
-    if(NavData::instance()->airports.contains(planDest))
-        return NavData::instance()->airports[planDest];
-    else return 0;
-}
-
-Airport *Pilot::altAirport() const {
-    if(NavData::instance()->airports.contains(planAltAirport))
-        return NavData::instance()->airports[planAltAirport];
-    else return 0;
-}
-
-double Pilot::distanceFromDeparture() const {
-    Airport *dep = depAirport();
-    if(dep == 0)
-        return 0;
-
-    return NavData::distance(lat, lon, dep->lat, dep->lon);
-}
-
-double Pilot::distanceToDestination() const {
-    Airport *dest = destAirport();
-    if(dest == 0)
-        return 0;
-
-    return NavData::distance(lat, lon, dest->lat, dest->lon);
-}
-
 int Pilot::planTasInt() const { // defuck flightplanned TAS
     if(planTAS.startsWith("M")) { // approximate Mach -> TAS conversion
         if(planTAS.contains("."))
@@ -328,29 +347,18 @@ int Pilot::planTasInt() const { // defuck flightplanned TAS
     return planTAS.toInt();
 }
 
-QDateTime Pilot::etd() const { // Estimated Time of Departure
-    QString planDeptimeFixed = planDeptime;
-
-    if(planDeptime.length() == 3)
-        planDeptimeFixed.prepend("0"); // fromString("Hmm") does not handle "145" correctly -> "14:05"
-
-    QTime time = QTime::fromString(planDeptimeFixed, "HHmm");
-
-    return QDateTime(dayOfFlight, time, Qt::UTC);
-}
-
-QDateTime Pilot::eta() const { // Estimated Time of Arrival
-    FlightStatus status = flightStatus();
+QDateTime Pilot::deriveEta() const { // Estimated Time of Arrival
+    const FlightStatus status = _flightStatus;
     if(status == PREFILED || status == BOARDING)
-        return etaPlan();
+        return _etaPlan;
     else if(status == DEPARTING || status == GROUND_DEP) { // try to calculate with flightplanned speed
         int enrouteSecs;
         if(planTasInt() == 0) {
             if(groundspeed == 0)
                 return QDateTime(); // abort
-            enrouteSecs = (int) (distanceToDestination() * 3600) / groundspeed;
+            enrouteSecs = (int) (_distanceToDestination * 3600) / groundspeed;
         } else
-            enrouteSecs = (int) (distanceToDestination() * 3600) / planTasInt();
+            enrouteSecs = (int) (_distanceToDestination * 3600) / planTasInt();
         if(status == GROUND_DEP) enrouteSecs += 240; // taxi time outbound
         return whazzupTime.addSecs(enrouteSecs);
     } else if(status == EN_ROUTE || status == ARRIVING) { // try groundspeed
@@ -358,9 +366,9 @@ QDateTime Pilot::eta() const { // Estimated Time of Arrival
         if(groundspeed == 0) {
             if(planTasInt() == 0)
                 return QDateTime(); // abort
-            enrouteSecs = (int) (distanceToDestination() * 3600) / planTasInt();
+            enrouteSecs = (int) (_distanceToDestination * 3600) / planTasInt();
         } else
-            enrouteSecs = (int) (distanceToDestination() * 3600) / groundspeed;
+            enrouteSecs = (int) (_distanceToDestination * 3600) / groundspeed;
         return whazzupTime.addSecs(enrouteSecs);
     } else if(status == GROUND_ARR || status == BLOCKED)
         return whazzupTime;
@@ -368,22 +376,16 @@ QDateTime Pilot::eta() const { // Estimated Time of Arrival
 }
 
 QTime Pilot::eet() const { // Estimated Enroute Time remaining
-    int secs = whazzupTime.secsTo(eta());
+    int secs = whazzupTime.secsTo(_eta);
     QTime ret = QTime((secs / 3600) % 24, (secs / 60) % 60);
     return ret;
 }
 
-QDateTime Pilot::etaPlan() const { // Estimated Time of Arrival as flightplanned
-    if(planEnroute_hrs < 0)
-        return QDateTime();
-    return etd().addSecs(planEnroute_hrs * 3600 + planEnroute_mins * 60);
-}
-
 QString Pilot::delayStr() const { // delay
-    if(!etaPlan().isValid())
+    if(!_etaPlan.isValid())
         return QString();
     int secs, calcSecs;
-    secs = etaPlan().secsTo(eta());
+    secs = _etaPlan.secsTo(_eta);
     if (secs == 0)
         return QString("n/a");
     calcSecs = (secs < 0? -secs: secs);
@@ -442,15 +444,12 @@ int Pilot::nextPointOnRoute(const QList<Waypoint *> &waypoints) const { // next
         return 0; // prefiled flight or no known position
     int nextPoint;
     // find the point that is nearest to the plane
-    double minDist = NavData::distance(lat, lon, waypoints[0]->lat,
-                                       waypoints[0]->lon);
-    int minPoint = 0; // next to departure as default
-    for(int i = 1; i < waypoints.size(); i++) {
-        if(NavData::distance(lat, lon, waypoints[i]->lat, waypoints[i]->lon) < minDist) {
-            minDist = NavData::distance(lat, lon, waypoints[i]->lat, waypoints[i]->lon);
-            minPoint = i;
-        }
-    }
+    const Geodesic::Vector plane = Geodesic::vector(lat, lon);
+    Geodesic::Points points;
+    points.reserve(waypoints.size());
+    foreach(const Waypoint *w, waypoints)
+        points.append(w->lat, w->lon);
+    int minPoint = Geodesic::nearest(plane, points); // the first one, next to departure, on a tie
     // with the nearest point, look which one is the next point ahead - saves from trouble with zig-zag routes
     if(minPoint == 0) {
         nextPoint = 1;
@@ -461,10 +460,8 @@ int Pilot::nextPointOnRoute(const QList<Waypoint *> &waypoints) const { // next
         // look for the first route segment where the planned course deviates > 90° from the bearing to the plane
         int courseRoute, courseToPlane, courseDeviation;
         for(int i = minPoint - 1; i <= minPoint; i++) {
-            courseRoute = (int) NavData::courseTo(waypoints[i]->lat, waypoints[i]->lon,
-                                                  waypoints[i + 1]->lat, waypoints[i + 1]->lon);
-            courseToPlane = (int) NavData::courseTo(waypoints[i]->lat, waypoints[i]->lon,
-                                                    lat, lon);
+            courseRoute = (int) Geodesic::course(points.at(i), points.at(i + 1));
+            courseToPlane = (int) Geodesic::course(points.at(i), plane);
             courseDeviation = (qAbs(courseRoute - courseToPlane)) % 360;
             if (courseDeviation > 90) {
                 nextPoint = i;
@@ -519,12 +516,17 @@ QList<Waypoint*> Pilot::routeWaypoints() {
     routeWaypointsPlanDestCache = planDest;
     routeWaypointsPlanRouteCache = planRoute;
 
-    if (depAirport() != 0)
-        routeWaypointsCache = Airac::instance()->resolveFlightplan(
-                    waypoints(), depAirport()->lat, depAirport()->lon);
-    else if (!qFuzzyIsNull(lat) || !qFuzzyIsNull(lon))
-        routeWaypointsCache = Airac::instance()->resolveFlightplan(
-                    waypoints(), lat, lon);
+    Airac *airac = Airac::instance();
+    if (depAirport() != 0) {
+        // pilots with the same departure and route share the result, also across sessions
+        const quint64 key = RouteCache::key(planDep, planRoute, depAirport()->lat, depAirport()->lon,
+                                            airac->dataVersion());
+        if (!airac->cachedFlightplan(key, routeWaypointsCache)) {
+            routeWaypointsCache = airac->resolveFlightplan(waypoints(), depAirport()->lat, depAirport()->lon);
+            airac->cacheFlightplan(key, routeWaypointsCache);
+        }
+    } else if (!qFuzzyIsNull(lat) || !qFuzzyIsNull(lon))
+        routeWaypointsCache = airac->resolveFlightplan(waypoints(), lat, lon);
     else
         routeWaypointsCache = QList<Waypoint*>();
 
@@ -542,19 +544,17 @@ QString Pilot::routeWaypointsStr() {
 QList<Waypoint*> Pilot::routeWaypointsWithDepDest() {
     QList<Waypoint*> waypoints = routeWaypoints();
     if(depAirport() != 0)
-        waypoints.prepend(new Waypoint(depAirport()->label, depAirport()->lat,
-                                       depAirport()->lon));
+        waypoints.prepend(Airac::instance()->airportPoint(depAirport()));
     if(destAirport() != 0)
-        waypoints.append(new Waypoint(destAirport()->label, destAirport()->lat,
-                                      destAirport()->lon));
+        waypoints.append(Airac::instance()->airportPoint(destAirport()));
     return waypoints;
 }
 
 void Pilot::checkStatus() {
-    drawLabel = flightStatus() == Pilot::DEPARTING
-            || flightStatus() == Pilot::EN_ROUTE
-            || flightStatus() == Pilot::ARRIVING
-            || flightStatus() == Pilot::CRASHED
-            || flightStatus() == Pilot::BUSH
-            || flightStatus() == Pilot::PREFILED;
+    drawLabel = _flightStatus == Pilot::DEPARTING
+            || _flightStatus == Pilot::EN_ROUTE
+            || _flightStatus == Pilot::ARRIVING
+            || _flightStatus == Pilot::CRASHED
+            || _flightStatus == Pilot::BUSH
+            || _flightStatus == Pilot::PREFILED;
 }
@@ -22,29 +22,45 @@ class Pilot: public Client {
             GROUND_ARR, BLOCKED, CRASHED, BUSH, PREFILED
         };
 
-        Pilot(const QJsonObject& json, const WhazzupData* whazzup);
+        // what the constructor and derive() look up in NavData, see ClientRecords
+        struct Derived : Client::Derived {
+            Airline *airline;
+            Airport *depAirport, *destAirport, *altAirport;
+            double distanceFromDeparture, distanceToDestination, plannedDistance;
+            FlightStatus flightStatus;
+        };
+
+        // previous: derived from a record with the same callsign, name and flightplan,
+        // and with the same position, altitude and speed if samePosition
+        Pilot(const QJsonObject& json, const WhazzupData* whazzup,
+              const Derived *previous = 0, bool samePosition = false);
 
         virtual QString toolTip() const;
         virtual QString rank() const;
         virtual void showDetailsDialog();
         virtual QString mapLabel() const { return QString("%1 %2").arg(label, shortAlt()); }
 
-        FlightStatus flightStatus() const;
+        // computes the values below from position, speed, altitude, flightplan and whazzupTime.
+        // Done on construction, call it again after changing one of those.
+        void derive();
+        Derived derived() const;
+        FlightStatus flightStatus() const { return _flightStatus; }
         QString flightStatusString() const;
         QString flightStatusShortString() const;
         QString planFlighttypeString() const;
         QString aircraftType() const;
-        Airport *depAirport() const;
-        Airport *destAirport() const;
-        Airport *altAirport() const;
+        Airport *depAirport() const { return _depAirport; }
+        Airport *destAirport() const { return _destAirport; }
+        Airport *altAirport() const { return _altAirport; }
         QStringList waypoints() const;
-        double distanceToDestination() const;
-        double distanceFromDeparture() const;
-        QDateTime etd() const; // Estimated Time of Departure
-        QDateTime eta() const; // Estimated Time of Arrival
+        double distanceToDestination() const { return _distanceToDestination; }
+        double distanceFromDeparture() const { return _distanceFromDeparture; }
+        double plannedDistance() const { return _plannedDistance; } // departure to destination, 0 if unknown
+        QDateTime etd() const { return _etd; } // Estimated Time of Departure
+        QDateTime eta() const { return _eta; } // Estimated Time of Arrival
         //QDateTime fixedEta; // ETA, written after creation as a workaround for Prediction (Warp) Mode
         QTime eet() const; // Estimated Enroute Time as remaining time to destination
-        QDateTime etaPlan() const; // Estimated Time of Arrival as flightplanned
+        QDateTime etaPlan() const { return _etaPlan; } // Estimated Time of Arrival as flightplanned
         QString delayStr() const;
         int planTasInt() const; // defuck TAS for Mach numbers
         int defuckPlanAlt(QString alt) const; // returns an altitude from various flightplan strings
@@ -75,6 +91,15 @@ class Pilot: public Client {
         QList<Waypoint*> routeWaypointsCache; // caching calculated routeWaypoints
         Airline* airline;
     private:
+        void derive(const QHash<QString, Airport*> &airports, const Derived *previous, bool samePosition);
+        FlightStatus deriveFlightStatus() const;
+        QDateTime deriveEta() const;
+
+        // by derive()
+        Airport *_depAirport, *_destAirport, *_altAirport;
+        double _distanceFromDeparture, _distanceToDestination, _plannedDistance;
+        FlightStatus _flightStatus;
+        QDateTime _etd, _eta, _etaPlan;
 };
 
 #endif /*PILOT_H_*/
@@ -0,0 +1,35 @@
+/**************************************************************************
+ *  This file is part of QuteScoop. See README for license
+ **************************************************************************/
+
+#include "PilotTable.h"
+
+#include "Pilot.h"
+
+void PilotTable::rebuild(const QHash<QString, Pilot*> &pilots) {
+    clear();
+    const int n = pilots.size();
+    lat.reserve(n);
+    lon.reserve(n);
+    trueHeading.reserve(n);
+    altitude.reserve(n);
+    groundspeed.reserve(n);
+    pilot.reserve(n);
+    foreach (Pilot *p, pilots) {
+        lat.append(p->lat);
+        lon.append(p->lon);
+        trueHeading.append(p->trueHeading);
+        altitude.append(p->altitude);
+        groundspeed.append(p->groundspeed);
+        pilot.append(p);
+    }
+}
+
+void PilotTable::clear() {
+    lat.clear();
+    lon.clear();
+    trueHeading.clear();
+    altitude.clear();
+    groundspeed.clear();
+    pilot.clear();
+}
@@ -0,0 +1,33 @@
+/**************************************************************************
+ *  This file is part of QuteScoop. See README for license
+ **************************************************************************/
+
+#ifndef PILOTTABLE_H_
+#define PILOTTABLE_H_
+
+#include <QtCore>
+
+class Pilot;
+
+/**
+  Position and kinematics of all pilots of a WhazzupData as parallel arrays
+  (struct of arrays). Row i belongs to pilot[i]. Loops that only need
+  positions scan these linearly instead of chasing Pilot* through a QHash.
+  The vectors are implicitly shared, so copying a table is O(1).
+  Rebuilt by WhazzupData whenever its pilots change; do not keep row
+  indexes across updates.
+**/
+class PilotTable {
+    public:
+        void rebuild(const QHash<QString, Pilot*> &pilots);
+        void clear();
+        int size() const { return pilot.size(); }
+        // no known position (prefiled or not yet reported)
+        bool hasPosition(int i) const { return !(qFuzzyIsNull(lat[i]) && qFuzzyIsNull(lon[i])); }
+
+        QVector<double> lat, lon, trueHeading;
+        QVector<int> altitude, groundspeed;
+        QVector<Pilot*> pilot;
+};
+
+#endif /*PILOTTABLE_H_*/
@@ -9,6 +9,9 @@
 #include "Route.h"
 #include "Window.h"
 #include "NavData.h"
+#include "Airac.h"
+#include "Airport.h"
+#include "RouteFinder.h"
 #include "Net.h"
 #include "helpers.h"
 
@@ -56,12 +59,14 @@ void PlanFlightDialog::on_buttonRequest_clicked() { // get routes from selected
                          .arg(edDest->text())
                          .arg(_routes.size()));
     lblGeneratedStatus->setText(QString());
+    lblAirwaysStatus->setText(QString());
     lblVrouteStatus->setText(QString());
 
     edDep->setText(edDep->text().toUpper());
     edDest->setText(edDest->text().toUpper());
 
     if (cbGenerated->isChecked()) requestGenerated();
+    if (cbAirways->isChecked()) requestAirways();
     if (cbVroute->isChecked()) requestVroute();
 }
 
@@ -93,6 +98,48 @@ void PlanFlightDialog::requestGenerated() {
                          .arg(_routes.size()));
 }
 
+void PlanFlightDialog::requestAirways() {
+    Airport *dep = NavData::instance()->airports.value(edDep->text(), 0);
+    Airport *dest = NavData::instance()->airports.value(edDest->text(), 0);
+    if (dep == 0 || dest == 0) {
+        lblAirwaysStatus->setText(QString("bad request"));
+        return;
+    }
+    RouteFinder *finder = Airac::instance()->routeFinder();
+    if (finder->nodeCount() == 0) {
+        lblAirwaysStatus->setText(QString("needs navdata"));
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    const QList<RouteFinder::Route> found = finder->find(dep->lat, dep->lon, dest->lat, dest->lon, 5);
+    const qint64 elapsed = timer.elapsed();
+    foreach (const RouteFinder::Route &route, found) {
+        Route *r = new Route();
+        r->provider = QString("airways");
+        r->dep = edDep->text();
+        r->dest = edDest->text();
+        r->route = route.route(Airac::instance()->store());
+        r->comments = QString("generated");
+        r->lastChange = QString();
+
+        r->calculateWaypointsAndDistance();
+        _routes.append(r);
+    }
+    lblAirwaysStatus->setText(QString("%1 route%2 in %3 ms")
+                              .arg(found.size())
+                              .arg(found.size() == 1 ? "": "s")
+                              .arg(elapsed));
+    _routesModel.setClients(_routes);
+    _routesSortModel->invalidate();
+    treeRoutes->header()->resizeSections(QHeaderView::ResizeToContents);
+    gbResults->setTitle(QString("Results [%1-%2] (%3)")
+                         .arg(edDep->text())
+                         .arg(edDest->text())
+                         .arg(_routes.size()));
+}
+
 void PlanFlightDialog::requestVroute() {
     // We need to find some way to manage that this code is not abused
     // 'cause if it is - we are all blocked from vroute access!
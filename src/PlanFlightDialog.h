@@ -41,6 +41,7 @@ class PlanFlightDialog : public QDialog, public Ui::PlanFlightDialog {
         PlanFlightDialog(QWidget *parent);
 
         void requestGenerated();
+        void requestAirways();
         void requestVroute();
 
         QNetworkReply *_replyVroute;
@@ -43,7 +43,7 @@ QVariant PlanFlightRoutesModel::data(const QModelIndex &index, int role) const {
         switch(index.column()) {
             case 0:
                 return QPixmap(
-                            r->provider == "user"
+                            r->provider == "user" || r->provider == "airways"
                             ? ":/icons/qutescoop.png"
                             : ":/routeproviders/images/vroute.png"
                         )
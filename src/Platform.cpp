@@ -4,6 +4,19 @@
 
 #include "Platform.h"
 
+#ifdef Q_OS_WIN
+#   define PSAPI_VERSION 2 // GetProcessMemoryInfo() from kernel32
+#   include <windows.h>
+#   include <psapi.h>
+#else
+#   include <sys/resource.h>
+#   include <unistd.h>
+#endif
+#ifdef Q_OS_MACOS
+#   include <mach/mach.h>
+#endif
+#include <QFile>
+
 QString Platform::platformOS() {
     return QString("%1:%2:%3").arg(QSysInfo::prettyProductName(), QSysInfo::kernelType(), QSysInfo::kernelVersion());
 }
@@ -41,3 +54,45 @@ QString Platform::version()
     return QString(GIT_DESCRIBE);
 }
 
+
+qint64 Platform::peakRss() {
+#ifdef Q_OS_WIN
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return counters.PeakWorkingSetSize;
+    return -1;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return -1;
+#   ifdef Q_OS_MACOS
+    return usage.ru_maxrss; // bytes
+#   else
+    return usage.ru_maxrss * 1024; // kilobytes
+#   endif
+#endif
+}
+
+qint64 Platform::currentRss() {
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return counters.WorkingSetSize;
+    return -1;
+#elif defined(Q_OS_MACOS)
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t) &info, &count) != KERN_SUCCESS)
+        return -1;
+    return info.resident_size;
+#else
+    // second field of statm: resident pages
+    QFile statm("/proc/self/statm");
+    if (!statm.open(QIODevice::ReadOnly))
+        return -1;
+    const QList<QByteArray> fields = statm.readAll().split(' ');
+    bool ok = false;
+    const qint64 pages = fields.value(1).toLongLong(&ok);
+    return ok? pages * sysconf(_SC_PAGESIZE): -1;
+#endif
+}
@@ -13,6 +13,8 @@ class Platform {
         static QString compiler();
         static QString compileMode();
         static QString version();
+        static qint64 peakRss(); // peak resident set size of the process in bytes, -1 if unknown
+        static qint64 currentRss(); // resident set size of the process in bytes, -1 if unknown
 };
 
 #endif // PLATFORM_H
@@ -5,6 +5,7 @@
 #include "Platform.h"
 #include "Settings.h"
 #include "Launcher.h"
+#include "Benchmark.h"
 
 #include <QtCore>
 #include <QApplication>
@@ -15,6 +16,9 @@ QScopedPointer<QFile>   m_logFile;
 
 void messageHandler(QtMsgType type, const QMessageLogContext& context, const QString& msg) {
     Q_UNUSED(context);
+    // Whazzup decoding logs from worker threads
+    static QMutex mutex;
+    QMutexLocker locker(&mutex);
     QTextStream out(m_logFile.data());
     out << QDateTime::currentDateTimeUtc().toString(Qt::ISODateWithMs);
     switch (type)
@@ -32,6 +36,15 @@ void messageHandler(QtMsgType type, const QMessageLogContext& context, const QSt
 
 /* main */
 int main(int argc, char *argv[]) {
+    // benchmarks and checks do not show any window: run them without a display (CI)
+    for (int i = 1; i < argc; i++) {
+        const QByteArray arg(argv[i]);
+        if ((arg == "--bench" || arg.startsWith("--bench=")) && qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+            break;
+        }
+    }
+
     QApplication app(argc, argv); // before QT_REQUIRE_VERSION to prevent creating duplicate..
     QT_REQUIRE_VERSION(argc, argv, "5.15.0"); // ..application objects
 
@@ -69,6 +82,23 @@ int main(int argc, char *argv[]) {
     qDebug() << "Library paths:" << app.libraryPaths();
     qDebug() << "Supported image formats:" << QImageReader::supportedImageFormats();
 
+    // headless benchmarks and checks. Unknown arguments are ignored (e.g. -psn_* on macOS).
+    QCommandLineParser parser;
+    QCommandLineOption benchOption("bench",
+        "Run the benchmark or check <name> without a GUI and quit. \"--bench list\" describes them.", "name");
+    QCommandLineOption inputOption("input", "The file or directory --bench reads.", "path");
+    QCommandLineOption flagOption("flag", "A switch of the --bench benchmark, see \"--bench list\".", "flag");
+    QCommandLineOption cyclesOption("cycles", "Number of benchmark cycles.", "n", "50");
+    parser.addOptions({ benchOption, inputOption, flagOption, cyclesOption });
+    parser.parse(app.arguments());
+    if (parser.isSet(benchOption)) {
+        Benchmark::Options options;
+        options.input = parser.value(inputOption);
+        options.cycles = parser.value(cyclesOption).toInt();
+        options.flags = parser.values(flagOption);
+        return Benchmark::run(parser.value(benchOption), options);
+    }
+
     // show Launcher
     Launcher::instance()->fireUp();
 
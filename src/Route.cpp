@@ -15,13 +15,13 @@ Route::~Route() {
 void Route::calculateWaypointsAndDistance() {
     Airport* depAirport;
     if(NavData::instance()->airports.contains(dep))
-        depAirport = NavData::instance()->airports[dep];
+        depAirport = NavData::instance()->airports.value(dep);
     else
         return;
 
     Airport* destAirport;
     if(NavData::instance()->airports.contains(dest))
-        destAirport = NavData::instance()->airports[dest];
+        destAirport = NavData::instance()->airports.value(dest);
     else
         return;
 
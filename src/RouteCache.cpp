@@ -0,0 +1,165 @@
+/**************************************************************************
+ *  This file is part of QuteScoop. See README for license
+ **************************************************************************/
+
+#include "RouteCache.h"
+
+#include "Settings.h"
+
+#include <algorithm>
+
+static const quint32 fileMagic = 0x51535243; // "QSRC"
+static const quint8 formatVersion = 1;
+
+// FNV-1a over the UTF-16 of the strings and the bytes of the numbers
+static void mix(quint64 &hash, const void *data, size_t size) {
+    const uchar *bytes = static_cast<const uchar*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 1099511628211ULL;
+    }
+}
+
+static void mix(quint64 &hash, const QString &s) {
+    const int size = s.size();
+    mix(hash, &size, sizeof(size));
+    mix(hash, s.constData(), size * sizeof(QChar));
+}
+
+// every extra a point refers to is there
+static bool isComplete(const RouteCache::Route &route) {
+    foreach (const qint32 index, route.points) {
+        if (index < 0 && -1 - index >= route.extras.size()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+RouteCache::RouteCache(int capacity) :
+    _routes(capacity),
+    _clock(0)
+{
+}
+
+QString RouteCache::defaultFileName() {
+    return Settings::dataDirectory("cache/routes.routecache");
+}
+
+/**
+  Airac::resolveFlightplan() only looks at the route and the position it
+  starts from, the departure airport for pilots: the destination is not part
+  of the key.
+**/
+quint64 RouteCache::key(const QString &dep, const QString &route, double lat, double lon,
+                        const QString &dataVersion) {
+    quint64 hash = 14695981039346656037ULL;
+    mix(hash, dep);
+    mix(hash, route);
+    mix(hash, &lat, sizeof(lat));
+    mix(hash, &lon, sizeof(lon));
+    mix(hash, dataVersion);
+    return hash;
+}
+
+bool RouteCache::find(quint64 key, Route &route) {
+    Entry *entry = _routes.object(key);
+    if (entry == 0) {
+        _stats.misses++;
+        return false;
+    }
+    _stats.hits++;
+    entry->lastUse = ++_clock;
+    route = entry->route;
+    return true;
+}
+
+void RouteCache::insert(quint64 key, const Route &route) {
+    store(key, route);
+    _stats.inserts++;
+}
+
+void RouteCache::store(quint64 key, const Route &route) {
+    Entry *entry = new Entry;
+    entry->route = route;
+    entry->lastUse = ++_clock;
+    _routes.insert(key, entry, route.points.size());
+}
+
+void RouteCache::clear() {
+    _routes.clear();
+}
+
+bool RouteCache::read(const QString &fileName, const QString &dataVersion) {
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_12);
+    quint32 magic;
+    quint8 version;
+    QString fileDataVersion;
+    qint32 count;
+    in >> magic >> version >> fileDataVersion >> count;
+    if (in.status() != QDataStream::Ok || magic != fileMagic || version != formatVersion
+            || fileDataVersion != dataVersion || count < 0) {
+        qDebug() << "RouteCache::read()" << fileName << "is outdated or not a route cache";
+        return false;
+    }
+
+    QList<QPair<quint64, Route> > routes;
+    for (int i = 0; i < count && in.status() == QDataStream::Ok; i++) {
+        QPair<quint64, Route> entry;
+        qint32 extraCount;
+        in >> entry.first >> entry.second.points >> extraCount;
+        for (int e = 0; e < extraCount && in.status() == QDataStream::Ok; e++) {
+            Extra extra;
+            in >> extra.ident >> extra.lat >> extra.lon;
+            entry.second.extras.append(extra);
+        }
+        if (!isComplete(entry.second)) {
+            in.setStatus(QDataStream::ReadCorruptData);
+        }
+        routes.append(entry);
+    }
+    if (in.status() != QDataStream::Ok) {
+        qDebug() << "RouteCache::read()" << fileName << "is broken";
+        return false;
+    }
+    // least recently used first, as written
+    for (int i = 0; i < routes.size(); i++) {
+        store(routes[i].first, routes[i].second);
+    }
+    qDebug() << "RouteCache::read()" << routes.size() << "routes from" << fileName;
+    return true;
+}
+
+bool RouteCache::write(const QString &fileName, const QString &dataVersion) const {
+    QDir().mkpath(QFileInfo(fileName).absolutePath());
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "RouteCache::write() could not open" << fileName;
+        return false;
+    }
+    QList<quint64> keys = _routes.keys();
+    std::sort(keys.begin(), keys.end(), [this](quint64 a, quint64 b) {
+        return _routes.object(a)->lastUse < _routes.object(b)->lastUse;
+    });
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_12);
+    out << fileMagic << formatVersion << dataVersion << (qint32) keys.size();
+    foreach (const quint64 key, keys) {
+        const Route &route = _routes.object(key)->route;
+        out << key << route.points << (qint32) route.extras.size();
+        foreach (const Extra &extra, route.extras) {
+            out << extra.ident << extra.lat << extra.lon;
+        }
+    }
+    if (out.status() != QDataStream::Ok || !file.commit()) {
+        qDebug() << "RouteCache::write() could not write" << fileName;
+        return false;
+    }
+    qDebug() << "RouteCache::write()" << keys.size() << "routes to" << fileName << "- hit rate this session"
+             << QString::number(100. * _stats.hitRate(), 'f', 1) << "%";
+    return true;
+}
@@ -0,0 +1,66 @@
+/**************************************************************************
+ *  This file is part of QuteScoop. See README for license
+ **************************************************************************/
+
+#ifndef ROUTECACHE_H_
+#define ROUTECACHE_H_
+
+#include <QtCore>
+
+/**
+  Resolved flightplan routes by a 64 bit hash of what resolving them
+  depends on (see key()), shared by all pilots and kept between sessions.
+  A route is stored as NavStore point indices, so it is only valid for the
+  navdata it was resolved with; the points that are not in the NavStore
+  (airports, coordinates like 5530N) are stored with their position.
+  Least recently used routes are dropped when the points of all routes
+  exceed the capacity. The file is written for one navdata version, read()
+  ignores it for another one.
+**/
+class RouteCache {
+    public:
+        struct Extra {
+            QString ident;
+            double lat, lon;
+        };
+        struct Route {
+            QVector<qint32> points; // NavStore indices, -1 - i for extras[i]
+            QVector<Extra> extras;
+        };
+        struct Stats {
+            Stats() : hits(0), misses(0), inserts(0) {}
+            int hits, misses, inserts;
+            double hitRate() const { return hits + misses == 0? 0.: (double) hits / (hits + misses); }
+        };
+
+        explicit RouteCache(int capacity = defaultCapacity);
+        static QString defaultFileName();
+        static quint64 key(const QString &dep, const QString &route, double lat, double lon,
+                           const QString &dataVersion);
+
+        // counts a hit or a miss. A hit is the most recently used route then.
+        bool find(quint64 key, Route &route);
+        void insert(quint64 key, const Route &route);
+        void clear();
+
+        int size() const { return _routes.size(); }
+        int points() const { return _routes.totalCost(); }
+        const Stats &stats() const { return _stats; }
+
+        // false if the file is missing, broken or of another dataVersion. The cache is unchanged then.
+        bool read(const QString &fileName, const QString &dataVersion);
+        bool write(const QString &fileName, const QString &dataVersion) const;
+
+        static const int defaultCapacity = 1 << 21; // points, ~8 MB
+    private:
+        struct Entry {
+            Route route;
+            quint64 lastUse; // of _clock, to write the routes in the order they were used
+        };
+        void store(quint64 key, const Route &route);
+        QCache<quint64, Entry> _routes; // cost: points of the route
+        quint64 _clock;
+        Stats _stats;
+};
+
+#endif /* ROUTECACHE_H_ */
@@ -0,0 +1,222 @@
+/**************************************************************************
+ *  This file is part of QuteScoop. See README for license
+ **************************************************************************/
+
+#include "RouteFinder.h"
+
+#include "NavData.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <vector>
+
+static void toVector(double lat, double lon, double *v) {
+    const double la = lat * M_PI / 180., lo = lon * M_PI / 180.;
+    v[0] = qCos(la) * qCos(lo);
+    v[1] = qCos(la) * qSin(lo);
+    v[2] = qSin(la);
+}
+
+RouteFinder::RouteFinder(const NavStore &store, const AirwayGraph &graph) :
+    _store(store),
+    _graph(graph),
+    _generation(0)
+{
+    QElapsedTimer timer;
+    timer.start();
+    // only the points on airways become nodes
+    QHash<int, int> nodeOfPoint;
+    for (int p = 0; p < graph.pointCount(); p++) {
+        const QPair<int, int> range = graph.edgeRange(p);
+        if (range.first == range.second) {
+            continue;
+        }
+        nodeOfPoint.insert(p, _nodes.size());
+        Node node;
+        node.lat = store.point(p).lat;
+        node.lon = store.point(p).lon;
+        toVector(node.lat, node.lon, node.v);
+        node.point = p;
+        _nodes.append(node);
+    }
+    _edgeBegin.reserve(_nodes.size() + 1);
+    _edgeBegin.append(0);
+    _edges.reserve(graph.edgeCount());
+    for (int n = 0; n < _nodes.size(); n++) {
+        const QPair<int, int> range = graph.edgeRange(_nodes[n].point);
+        for (int i = range.first; i < range.second; i++) {
+            const AirwayGraph::Edge &e = graph.edge(i);
+            const Node &to = _nodes[nodeOfPoint.value(e.to)];
+            const Edge edge = { nodeOfPoint.value(e.to), e.airway,
+                                (float) NavData::distance(_nodes[n].lat, _nodes[n].lon, to.lat, to.lon) };
+            _edges.append(edge);
+        }
+        _edgeBegin.append(_edges.size());
+    }
+
+    QList<const Node*> nodes;
+    nodes.reserve(_nodes.size());
+    for (int n = 0; n < _nodes.size(); n++) {
+        nodes.append(&_nodes[n]);
+    }
+    _index.build(nodes);
+
+    _visited.fill(0, _nodes.size());
+    _closed.fill(0, _nodes.size());
+    _g.resize(_nodes.size());
+    _parent.resize(_nodes.size());
+    _parentEdge.resize(_nodes.size());
+    qDebug() << "RouteFinder::RouteFinder()" << _nodes.size() << "nodes," << _edges.size() << "edges in"
+             << timer.elapsed() << "ms";
+}
+
+double RouteFinder::heuristic(int node, const double *dest) const {
+    const double *v = _nodes[node].v;
+    const double dot = v[0] * dest[0] + v[1] * dest[1] + v[2] * dest[2];
+    return qAcos(qBound(-1., dot, 1.)) * 60. * 180. / M_PI;
+}
+
+int RouteFinder::reverseEdge(int from, int edge) const {
+    const Edge &e = _edges[edge];
+    for (quint32 i = _edgeBegin[e.to]; i < _edgeBegin[e.to + 1]; i++) {
+        if (_edges[i].to == from && _edges[i].airway == e.airway) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool RouteFinder::search(const QList<const Node*> &entries, double depLat, double depLon,
+                         const QHash<int, double> &exitCosts, const double *dest, Route &route,
+                         QVector<int> &edges, QVector<int> &sources) {
+    if (++_generation == 0) { // wrapped around
+        _visited.fill(0);
+        _closed.fill(0);
+        _generation = 1;
+    }
+    typedef QPair<double, int> Item; // f, node
+    std::priority_queue<Item, std::vector<Item>, std::greater<Item> > open;
+    auto visit = [&](int node, double g, int parent, int edge) {
+        if (_visited[node] == _generation && _g[node] <= g) {
+            return;
+        }
+        _visited[node] = _generation;
+        _g[node] = g;
+        _parent[node] = parent;
+        _parentEdge[node] = edge;
+        open.push(Item(g + heuristic(node, dest), node));
+    };
+
+    foreach (const Node *entry, entries) {
+        visit(entry - _nodes.constData(), NavData::distance(depLat, depLon, entry->lat, entry->lon), -1, -1);
+    }
+    // the destination as one more node, reached from the exit points
+    const int goal = _nodes.size();
+    double goalCost = std::numeric_limits<double>::max();
+    int goalParent = -1;
+    while (!open.empty()) {
+        const Item item = open.top();
+        open.pop();
+        const int node = item.second;
+        if (node == goal) {
+            break;
+        }
+        if (_closed[node] == _generation) {
+            continue;
+        }
+        _closed[node] = _generation;
+
+        const QHash<int, double>::const_iterator exit = exitCosts.constFind(node);
+        if (exit != exitCosts.constEnd() && _g[node] + exit.value() < goalCost) {
+            goalCost = _g[node] + exit.value();
+            goalParent = node;
+            open.push(Item(goalCost, goal));
+        }
+        for (quint32 i = _edgeBegin[node]; i < _edgeBegin[node + 1]; i++) {
+            const Edge &e = _edges[i];
+            if (_closed[e.to] != _generation) {
+                visit(e.to, _g[node] + e.length * _penalty[i], node, i);
+            }
+        }
+    }
+    if (goalParent < 0) {
+        return false;
+    }
+
+    route.points.clear();
+    route.airways.clear();
+    edges.clear();
+    sources.clear();
+    route.distance = exitCosts.value(goalParent);
+    for (int node = goalParent; node >= 0; node = _parent[node]) {
+        route.points.prepend(_nodes[node].point);
+        const int edge = _parentEdge[node];
+        if (edge >= 0) {
+            edges.append(edge);
+            sources.append(_parent[node]);
+            route.airways.prepend(_graph.airwayName(_edges[edge].airway));
+            route.distance += _edges[edge].length;
+        } else {
+            route.distance += NavData::distance(depLat, depLon, _nodes[node].lat, _nodes[node].lon);
+        }
+    }
+    return true;
+}
+
+QList<RouteFinder::Route> RouteFinder::find(double depLat, double depLon, double destLat, double destLon, int k) {
+    QList<Route> result;
+    const QList<const Node*> entries = _index.kNearest(depLat, depLon, entryCount, maxDirectDistance);
+    const QList<const Node*> exits = _index.kNearest(destLat, destLon, entryCount, maxDirectDistance);
+    if (entries.isEmpty() || exits.isEmpty()) {
+        return result;
+    }
+    QHash<int, double> exitCosts;
+    foreach (const Node *exit, exits) {
+        exitCosts.insert(exit - _nodes.constData(), NavData::distance(exit->lat, exit->lon, destLat, destLon));
+    }
+    double dest[3];
+    toVector(destLat, destLon, dest);
+
+    _penalty.fill(1.f, _edges.size());
+    QSet<QString> found;
+    for (int attempt = 0; attempt < 3 * k && result.size() < k; attempt++) {
+        Route route;
+        QVector<int> edges, sources;
+        if (!search(entries, depLat, depLon, exitCosts, dest, route, edges, sources)) {
+            break;
+        }
+        // make this route longer for the next search, in both directions
+        for (int i = 0; i < edges.size(); i++) {
+            const int edge = edges[i];
+            _penalty[edge] *= alternativePenalty;
+            const int reverse = reverseEdge(sources[i], edge);
+            if (reverse >= 0) {
+                _penalty[reverse] *= alternativePenalty;
+            }
+        }
+        const QString key = route.route(_store);
+        if (!found.contains(key)) {
+            found.insert(key);
+            result.append(route);
+        }
+    }
+    std::sort(result.begin(), result.end(), [](const Route &a, const Route &b) { return a.distance < b.distance; });
+    return result;
+}
+
+QString RouteFinder::Route::route(const NavStore &store) const {
+    QStringList tokens;
+    if (points.isEmpty()) {
+        return QString();
+    }
+    tokens << store.ident(points.first());
+    for (int i = 0; i < airways.size(); i++) {
+        // one token pair per airway, not per fix on it
+        if (i + 1 == airways.size() || airways[i + 1] != airways[i]) {
+            tokens << airways[i] << store.ident(points[i + 1]);
+        }
+    }
+    return tokens.join(' ');
+}
@@ -0,0 +1,76 @@
+/**************************************************************************
+ *  This file is part of QuteScoop. See README for license
+ **************************************************************************/
+
+#ifndef ROUTEFINDER_H_
+#define ROUTEFINDER_H_
+
+#include "AirwayGraph.h"
+#include "NavStore.h"
+#include "SpatialIndex.h"
+
+/**
+  Offline route generator: A* over the airway graph, from the airway points
+  near the departure to the ones near the destination (both joined
+  direct), with the great circle distance to the destination as the
+  heuristic.
+  The graph is prepared once: only the points on airways, with their unit
+  vectors, and the edge lengths in nm. Per query only the search state is
+  reset.
+  Alternatives come from searching again with the edges of the routes
+  found so far made longer, so that they differ by more than one fix.
+**/
+class RouteFinder {
+    public:
+        struct Route {
+            QVector<int> points; // NavStore indices from the entry to the exit point
+            QStringList airways; // the airway between points[i] and points[i + 1]
+            double distance; // nm, including the direct legs from the departure and to the destination
+            // flightplan notation: ENTRY AIRWAY FIX AIRWAY ... EXIT
+            QString route(const NavStore &store) const;
+        };
+
+        RouteFinder(const NavStore &store, const AirwayGraph &graph);
+        int nodeCount() const { return _nodes.size(); }
+
+        // up to k routes, shortest first
+        QList<Route> find(double depLat, double depLon, double destLat, double destLon, int k);
+    private:
+        struct Node {
+            double lat, lon; // for SpatialIndex
+            double v[3];
+            qint32 point;
+        };
+        struct Edge {
+            qint32 to; // node
+            quint32 airway;
+            float length;
+        };
+
+        bool search(const QList<const Node*> &entries, double depLat, double depLon,
+                    const QHash<int, double> &exitCosts, const double *dest, Route &route,
+                    QVector<int> &edges, QVector<int> &sources); // sources: the node each of the edges starts at
+        double heuristic(int node, const double *dest) const;
+        // the edge back from the end of edge to from, its start; -1 if there is none
+        int reverseEdge(int from, int edge) const;
+
+        const NavStore &_store;
+        const AirwayGraph &_graph;
+        QVector<Node> _nodes;
+        QVector<quint32> _edgeBegin; // per node into _edges, one more for the end
+        QVector<Edge> _edges;
+        SpatialIndex<const Node> _index;
+
+        // search state, valid where _visited is the current generation
+        quint32 _generation;
+        QVector<quint32> _visited, _closed;
+        QVector<double> _g;
+        QVector<qint32> _parent, _parentEdge; // -1 for entry points
+        QVector<float> _penalty;
+
+        static const int entryCount = 6;
+        static const int maxDirectDistance = 200; // nm from the airport to the entry/exit point
+        static constexpr float alternativePenalty = 1.3f;
+};
+
+#endif /* ROUTEFINDER_H_ */
@@ -0,0 +1,227 @@
+/**************************************************************************
+ *  This file is part of QuteScoop. See README for license
+ **************************************************************************/
+
+#include "SearchIndex.h"
+
+#include "Airline.h"
+#include "Airport.h"
+#include "Controller.h"
+#include "Pilot.h"
+#include "SearchVisitor.h"
+#include "WhazzupData.h"
+
+#include <algorithm>
+
+SearchIndex::SearchIndex() :
+    _generation(-1) {
+}
+
+SearchIndex::~SearchIndex() {
+    qDeleteAll(_airlines);
+}
+
+void SearchIndex::build(const QList<Airport*> &airports, const QList<Airline*> &airlines) {
+    QElapsedTimer timer;
+    timer.start();
+    _entries.clear();
+    qDeleteAll(_airlines);
+    _airlines.clear();
+
+    _entries.reserve(airports.size() * 4 + airlines.size() * 3);
+    foreach (Airport *a, airports) {
+        foreach (const QString &field, QStringList() << a->label << a->name << a->city << a->countryCode) {
+            if (!field.isEmpty()) {
+                const Entry entry = { field.toLower(), a };
+                _entries.append(entry);
+            }
+        }
+    }
+    foreach (const Airline *airline, airlines) {
+        // we make it into a MapObject, because that fits the results here well
+        MapObject *object = new MapObject(airline->label(), airline->toolTip());
+        _airlines.append(object);
+        foreach (const QString &field, QStringList() << airline->code << airline->name << airline->callsign) {
+            if (!field.isEmpty()) {
+                const Entry entry = { field.toLower(), object };
+                _entries.append(entry);
+            }
+        }
+    }
+    std::sort(_entries.begin(), _entries.end());
+    qDebug() << "SearchIndex::build()" << _entries.size() << "entries in" << timer.elapsed() << "ms";
+}
+
+QStringList SearchIndex::fields(const Pilot *p) {
+    return QStringList() << p->label << p->name() << p->userId;
+}
+
+QStringList SearchIndex::fields(const Controller *c) {
+    QStringList result;
+    result << c->label << c->frequency << c->atisMessage << c->realName();
+    if (c->sector != 0) {
+        result << c->sector->name;
+    }
+    return result;
+}
+
+void SearchIndex::setClient(const ClientKey &key, const QStringList &fields) {
+    QHash<ClientKey, QStringList>::iterator indexed = _clientFields.find(key);
+    if (indexed != _clientFields.end()) {
+        if (*indexed == fields) {
+            return;
+        }
+        foreach (const QString &field, *indexed) {
+            _clients.remove(field.toLower(), key);
+        }
+    }
+    foreach (const QString &field, fields) {
+        if (!field.isEmpty()) {
+            _clients.insert(field.toLower(), key);
+        }
+    }
+    _clientFields.insert(key, fields);
+}
+
+void SearchIndex::removeClient(const ClientKey &key) {
+    foreach (const QString &field, _clientFields.take(key)) {
+        _clients.remove(field.toLower(), key);
+    }
+}
+
+void SearchIndex::updateClients(const WhazzupData &data) {
+    if (data.generation() == _generation) {
+        return;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    const WhazzupData::Delta &delta = data.lastDelta();
+    const bool incremental = delta.followsGeneration(_generation);
+    if (incremental) {
+        foreach (const QString &callsign, delta.removedPilots) {
+            removeClient(ClientKey(PilotClient, callsign));
+        }
+        foreach (const QString &callsign, delta.addedPilots + delta.movedPilots + delta.flightplanChangedPilots) {
+            const Pilot *p = data.pilots.value(callsign, 0);
+            if (p != 0) {
+                setClient(ClientKey(PilotClient, callsign), fields(p));
+            }
+        }
+        foreach (const QString &callsign, delta.removedBookedPilots) {
+            removeClient(ClientKey(BookedPilotClient, callsign));
+        }
+        foreach (const QString &callsign, delta.addedBookedPilots + delta.changedBookedPilots) {
+            const Pilot *p = data.bookedPilots.value(callsign, 0);
+            if (p != 0) {
+                setClient(ClientKey(BookedPilotClient, callsign), fields(p));
+            }
+        }
+        foreach (const QString &callsign, delta.removedControllers) {
+            removeClient(ClientKey(ControllerClient, callsign));
+        }
+        foreach (const QString &callsign, delta.addedControllers + delta.changedControllers) {
+            const Controller *c = data.controllers.value(callsign, 0);
+            if (c != 0) {
+                setClient(ClientKey(ControllerClient, callsign), fields(c));
+            }
+        }
+    } else {
+        _clients.clear();
+        _clientFields.clear();
+        for (QHash<QString, Pilot*>::const_iterator it = data.pilots.constBegin(); it != data.pilots.constEnd(); ++it) {
+            setClient(ClientKey(PilotClient, it.key()), fields(it.value()));
+        }
+        for (QHash<QString, Pilot*>::const_iterator it = data.bookedPilots.constBegin();
+             it != data.bookedPilots.constEnd(); ++it) {
+            setClient(ClientKey(BookedPilotClient, it.key()), fields(it.value()));
+        }
+        for (QHash<QString, Controller*>::const_iterator it = data.controllers.constBegin();
+             it != data.controllers.constEnd(); ++it) {
+            setClient(ClientKey(ControllerClient, it.key()), fields(it.value()));
+        }
+    }
+    _generation = data.generation();
+    qDebug() << "SearchIndex::updateClients()" << (incremental? "delta": "full")
+             << _clientFields.size() << "clients in" << timer.elapsed() << "ms";
+}
+
+MapObject *SearchIndex::client(const ClientKey &key, const WhazzupData &data) const {
+    switch (key.first) {
+        case PilotClient:
+            return data.pilots.value(key.second, 0);
+        case BookedPilotClient:
+            return data.bookedPilots.value(key.second, 0);
+        case ControllerClient:
+            return data.controllers.value(key.second, 0);
+    }
+    return 0;
+}
+
+QString SearchIndex::literalPrefix(const QString &token, bool &plain) {
+    static const QString syntax("\\^$.[]|()?*+{}");
+    if (token.contains(QRegExp("[|()]"))) { // alternatives do not share a start
+        plain = false;
+        return QString();
+    }
+    int n = 0;
+    while (n < token.size() && !syntax.contains(token[n])) {
+        n++;
+    }
+    plain = n == token.size();
+    if (!plain && n > 0 && (token[n] == '*' || token[n] == '?' || token[n] == '{')) {
+        n--; // the character before a quantifier might be missing
+    }
+    return token.left(n).toLower();
+}
+
+QList<MapObject*> SearchIndex::find(const QString &search, const WhazzupData &data) const {
+    const QStringList tokens = SearchVisitor::tokens(search);
+    if (tokens.isEmpty()) {
+        return QList<MapObject*>();
+    }
+    const QRegExp regex = SearchVisitor::regExp(tokens);
+
+    QList<MapObject*> result;
+    QSet<MapObject*> found;
+    foreach (const QString &token, tokens) {
+        bool plain;
+        const QString prefix = literalPrefix(token, plain);
+
+        const Entry first = { prefix, 0 };
+        for (QVector<Entry>::const_iterator it = std::lower_bound(_entries.constBegin(), _entries.constEnd(), first);
+             it != _entries.constEnd() && it->text.startsWith(prefix); ++it) {
+            if ((plain || it->text.contains(regex)) && !found.contains(it->object)) {
+                found.insert(it->object);
+                result.append(it->object);
+            }
+        }
+        for (QMultiMap<QString, ClientKey>::const_iterator it = _clients.lowerBound(prefix);
+             it != _clients.constEnd() && it.key().startsWith(prefix); ++it) {
+            if (plain || it.key().contains(regex)) {
+                MapObject *object = client(it.value(), data);
+                if (object != 0 && !found.contains(object)) {
+                    found.insert(object);
+                    result.append(object);
+                }
+            }
+        }
+    }
+
+    // the order of SearchVisitor::result(), without building the strings for every comparison
+    QVector<QString> toolTips(result.size()), mapLabels(result.size());
+    QVector<int> order(result.size());
+    for (int i = 0; i < result.size(); i++) {
+        toolTips[i] = result[i]->toolTip();
+        mapLabels[i] = result[i]->mapLabel();
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&toolTips, &mapLabels](int a, int b) {
+        return toolTips[a] < mapLabels[b];
+    });
+    QList<MapObject*> sorted;
+    sorted.reserve(result.size());
+    foreach (int i, order) {
+        sorted.append(result[i]);
+    }
+    return sorted;
+}
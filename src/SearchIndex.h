@@ -0,0 +1,66 @@
+/**************************************************************************
+ *  This file is part of QuteScoop. See README for license
+ **************************************************************************/
+
+#ifndef SEARCHINDEX_H_
+#define SEARCHINDEX_H_
+
+#include <QtCore>
+
+class Airline;
+class Airport;
+class Controller;
+class MapObject;
+class Pilot;
+class WhazzupData;
+
+/**
+  Prefix index over the fields the search dock matches (see
+  SearchVisitor and the matches() of Airport, Client and Controller).
+  SearchVisitor anchors every alternative at the start of a field, so a
+  token is a range in the sorted, lower-cased field values. Tokens with
+  wildcards or other regular expression syntax narrow the range by their
+  literal start and check the candidates with the expression.
+  Airports and airlines are sorted once by build(); the clients are kept
+  by callsign in a QMultiMap that updateClients() patches with the delta
+  of the WhazzupData, so find() resolves them in the current data.
+**/
+class SearchIndex {
+    public:
+        SearchIndex();
+        ~SearchIndex();
+
+        void build(const QList<Airport*> &airports, const QList<Airline*> &airlines);
+        // applies the last delta of data if it follows what was indexed, otherwise reindexes all clients
+        void updateClients(const WhazzupData &data);
+        // the next updateClients() reindexes all clients, e.g. after an alias changed
+        void invalidateClients() { _generation = -1; }
+
+        // what SearchVisitor finds in NavData and data, in the same order
+        QList<MapObject*> find(const QString &search, const WhazzupData &data) const;
+        int size() const { return _entries.size() + _clients.size(); }
+    private:
+        enum ClientKind { PilotClient, BookedPilotClient, ControllerClient };
+        typedef QPair<int, QString> ClientKey; // ClientKind, callsign
+        struct Entry {
+            QString text;
+            MapObject *object;
+            bool operator<(const Entry &other) const { return text < other.text; }
+        };
+
+        static QStringList fields(const Pilot *p);
+        static QStringList fields(const Controller *c);
+        // the lower-cased start of token every match starts with, plain if that is the whole token
+        static QString literalPrefix(const QString &token, bool &plain);
+        void setClient(const ClientKey &key, const QStringList &fields);
+        void removeClient(const ClientKey &key);
+        MapObject *client(const ClientKey &key, const WhazzupData &data) const;
+
+        QVector<Entry> _entries; // airports and airlines, sorted
+        QList<MapObject*> _airlines; // what the search shows for an airline
+        QMultiMap<QString, ClientKey> _clients;
+        QHash<ClientKey, QStringList> _clientFields; // as indexed, to skip clients that kept them
+        int _generation; // of the WhazzupData the clients are from
+};
+
+#endif /* SEARCHINDEX_H_ */
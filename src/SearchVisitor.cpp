@@ -4,22 +4,28 @@
 
 #include "SearchVisitor.h"
 
-SearchVisitor::SearchVisitor(const QString& searchStr) {
+SearchVisitor::SearchVisitor(const QString& searchStr) :
+    _regex(regExp(tokens(searchStr))) {
+}
+
+QStringList SearchVisitor::tokens(const QString& search) {
     // @todo this tries to cater for both ways (wildcards and regexp) but it does a bad job at that.
-    QStringList tokens = QString(searchStr)
+    return QString(search)
             .replace(QRegExp("\\*"), ".*")
             .split(QRegExp("[ \\,]+"), Qt::SkipEmptyParts);
+}
 
-    if(tokens.size() == 1) {
-        _regex = QRegExp("^" + tokens.first() + ".*", Qt::CaseInsensitive);
-        return;
-    }
+QRegExp SearchVisitor::regExp(const QStringList& tokens) {
+    if(tokens.isEmpty())
+        return QRegExp();
+    if(tokens.size() == 1)
+        return QRegExp("^" + tokens.first() + ".*", Qt::CaseInsensitive);
 
     QString regExpStr = "^(" + tokens.first();
     for(int i = 1; i < tokens.size(); i++)
         regExpStr += "|" + tokens[i];
     regExpStr += ".*)";
-    _regex = QRegExp(regExpStr, Qt::CaseInsensitive);
+    return QRegExp(regExpStr, Qt::CaseInsensitive);
 }
 
 void SearchVisitor::visit(MapObject* object) {
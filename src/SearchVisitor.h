@@ -16,6 +16,10 @@
 class SearchVisitor : public MapObjectVisitor {
     public:
         SearchVisitor(const QString& search);
+        // the search split into alternatives, wildcards as regular expressions
+        static QStringList tokens(const QString& search);
+        // matches a string starting with one of tokens
+        static QRegExp regExp(const QStringList& tokens);
         virtual void visit(MapObject *object);
         virtual QList<MapObject*> result() const;
         QHash<QString, Airline*> airlines;
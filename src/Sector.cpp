@@ -20,6 +20,17 @@ Sector::Sector(QStringList strings) :
     id = strings[5];
 }
 
+Sector::Sector(const QString &icao, const QString &name, const QString &id) :
+  icao(icao),
+  name(name),
+  id(id),
+  _polygon(0),
+  _borderline(0),
+  _polygonHighlighted(0),
+  _borderlineHighlighted(0)
+{
+}
+
 Sector::~Sector() {
     if(_polygon != 0)
         glDeleteLists(_polygon, 1);
@@ -58,8 +69,14 @@ const QList<QPolygonF> &Sector::nonWrappedPolygons() const
 }
 
 void Sector::setPoints(const QList<QPair<double, double> > &points)
+{
+    setPoints(points, Helpers::polygonCenter(points));
+}
+
+void Sector::setPoints(const QList<QPair<double, double> > &points, const QPair<double, double> &center)
 {
     m_points = points;
+    m_center = center;
 
     // Populate m_nonWrappedPolygons:
     m_nonWrappedPolygons = {QPolygonF(), QPolygonF()};
@@ -173,5 +190,5 @@ GLuint Sector::glBorderLineHighlighted() {
 }
 
 QPair<double, double> Sector::getCenter() const {
-    return Helpers::polygonCenter(m_points);
+    return m_center;
 }
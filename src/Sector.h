@@ -14,6 +14,7 @@ class Sector {
             icao(), name(), id(), _polygon(0), _borderline(0)
         {}
         Sector(QStringList strings);
+        Sector(const QString &icao, const QString &name, const QString &id);
         ~Sector();
 
         bool isNull() const { return icao.isNull(); }
@@ -23,6 +24,8 @@ class Sector {
         const QList<QPolygonF> &nonWrappedPolygons() const;
         const QList<QPair<double, double> > &points() const;
         void setPoints(const QList<QPair<double, double> >&);
+        // with an already computed center, see DataBundle
+        void setPoints(const QList<QPair<double, double> >&, const QPair<double, double> &center);
         QString icao, name, id;
 
         GLuint glPolygon();
@@ -34,6 +37,7 @@ class Sector {
     private:
         QList<QPolygonF> m_nonWrappedPolygons;
         QList<QPair<double, double> > m_points;
+        QPair<double, double> m_center;
         GLuint _polygon, _borderline, _polygonHighlighted, _borderlineHighlighted;
 };
 
@@ -0,0 +1,209 @@
+/**************************************************************************
+ *  This file is part of QuteScoop. See README for license
+ **************************************************************************/
+
+#include "SectorIndex.h"
+
+#include "Sector.h"
+
+#include <algorithm>
+
+void SectorIndex::clear() {
+    _polygons.clear();
+    _bandBegin.clear();
+    _bandEdges.clear();
+    _edges.clear();
+    _nodes.clear();
+    _leafCount = 0;
+}
+
+void SectorIndex::build(const QList<Sector*> &sectors) {
+    QElapsedTimer timer;
+    timer.start();
+    clear();
+    foreach (Sector *sector, sectors) {
+        foreach (const QPolygonF &polygon, sector->nonWrappedPolygons()) {
+            if (polygon.size() >= 3) {
+                addPolygon(sector, polygon);
+            }
+        }
+    }
+    if (_polygons.isEmpty()) {
+        return;
+    }
+
+    // the leaf level: the polygons reordered so that every leaf has a contiguous range
+    QVector<int> order;
+    _nodes = pack(order, _polygons.size(), [this](int i) { return _polygons[i].box; });
+    QVector<Polygon> sorted;
+    sorted.reserve(_polygons.size());
+    foreach (int i, order) {
+        sorted.append(_polygons[i]);
+    }
+    _polygons = sorted;
+    _leafCount = _nodes.size();
+
+    // the levels above, until there is only the root
+    int levelBegin = 0, levelEnd = _nodes.size();
+    while (levelEnd - levelBegin > 1) {
+        QVector<Node> parents = pack(order, levelEnd - levelBegin,
+                                     [this, levelBegin](int i) { return _nodes[levelBegin + i].box; });
+        const QVector<Node> level = _nodes.mid(levelBegin, levelEnd - levelBegin);
+        for (int i = 0; i < order.size(); i++) {
+            _nodes[levelBegin + i] = level[order[i]];
+        }
+        for (int i = 0; i < parents.size(); i++) {
+            parents[i].first += levelBegin;
+        }
+        _nodes += parents;
+        levelBegin = levelEnd;
+        levelEnd = _nodes.size();
+    }
+    qDebug() << "SectorIndex::build()" << sectors.size() << "sectors," << _polygons.size() << "polygons,"
+             << _edges.size() << "edges in" << timer.elapsed() << "ms";
+}
+
+void SectorIndex::addPolygon(Sector *sector, const QPolygonF &polygon) {
+    // the points are lat/lon as x/y, see Sector::setPoints()
+    Polygon p;
+    p.sector = sector;
+    p.box.minLat = p.box.maxLat = polygon[0].x();
+    p.box.minLon = p.box.maxLon = polygon[0].y();
+    const int edgeBegin = _edges.size();
+    for (int i = 0; i < polygon.size(); i++) {
+        const QPointF &from = polygon[i], &to = polygon[(i + 1) % polygon.size()];
+        p.box.minLat = qMin(p.box.minLat, from.x());
+        p.box.maxLat = qMax(p.box.maxLat, from.x());
+        p.box.minLon = qMin(p.box.minLon, from.y());
+        p.box.maxLon = qMax(p.box.maxLon, from.y());
+        if (from.x() != to.x()) { // edges along a parallel never cross the test ray
+            const Edge edge = { from.x(), from.y(), to.x(), to.y() };
+            _edges.append(edge);
+        }
+    }
+    const int edgeCount = _edges.size() - edgeBegin;
+
+    p.bandCount = qMax(1, edgeCount / edgesPerBand);
+    p.bandHeight = qMax((p.box.maxLat - p.box.minLat) / p.bandCount, 1e-9);
+    p.bandBegin = _bandBegin.size();
+    auto band = [&p](double lat) {
+        return qBound(0, (int) ((lat - p.box.minLat) / p.bandHeight), (int) p.bandCount - 1);
+    };
+    // counting sort of the edges into every band they overlap
+    QVector<quint32> counts(p.bandCount + 1, 0);
+    for (int e = edgeBegin; e < _edges.size(); e++) {
+        const int last = band(qMax(_edges[e].lat0, _edges[e].lat1));
+        for (int b = band(qMin(_edges[e].lat0, _edges[e].lat1)); b <= last; b++) {
+            counts[b + 1]++;
+        }
+    }
+    counts[0] = _bandEdges.size();
+    for (quint32 b = 0; b < p.bandCount; b++) {
+        counts[b + 1] += counts[b];
+    }
+    _bandBegin += counts;
+    _bandEdges.resize(counts[p.bandCount]);
+    for (int e = edgeBegin; e < _edges.size(); e++) {
+        const int last = band(qMax(_edges[e].lat0, _edges[e].lat1));
+        for (int b = band(qMin(_edges[e].lat0, _edges[e].lat1)); b <= last; b++) {
+            _bandEdges[counts[b]++] = e;
+        }
+    }
+    _polygons.append(p);
+}
+
+/**
+  Sort-tile-recursive packing: the items are sorted by the longitude of
+  their centers into vertical slices, each slice by latitude, and then
+  taken nodeCapacity at a time.
+**/
+template<typename GetBox>
+QVector<SectorIndex::Node> SectorIndex::pack(QVector<int> &order, int count, GetBox box) const {
+    order.resize(count);
+    for (int i = 0; i < count; i++) {
+        order[i] = i;
+    }
+    const int parentCount = (count + nodeCapacity - 1) / nodeCapacity;
+    const int slices = qCeil(qSqrt(parentCount));
+    const int sliceSize = slices * nodeCapacity;
+    std::sort(order.begin(), order.end(), [&box](int a, int b) {
+        return box(a).minLon + box(a).maxLon < box(b).minLon + box(b).maxLon;
+    });
+    for (int s = 0; s < count; s += sliceSize) {
+        std::sort(order.begin() + s, order.begin() + qMin(count, s + sliceSize), [&box](int a, int b) {
+            return box(a).minLat + box(a).maxLat < box(b).minLat + box(b).maxLat;
+        });
+    }
+
+    QVector<Node> parents;
+    parents.reserve(parentCount);
+    for (int first = 0; first < count; first += nodeCapacity) {
+        Node node;
+        node.first = first;
+        node.count = qMin(nodeCapacity, count - first);
+        node.box = box(order[first]);
+        for (int i = first + 1; i < first + (int) node.count; i++) {
+            const Box b = box(order[i]);
+            node.box.minLat = qMin(node.box.minLat, b.minLat);
+            node.box.maxLat = qMax(node.box.maxLat, b.maxLat);
+            node.box.minLon = qMin(node.box.minLon, b.minLon);
+            node.box.maxLon = qMax(node.box.maxLon, b.maxLon);
+        }
+        parents.append(node);
+    }
+    return parents;
+}
+
+bool SectorIndex::polygonContains(const Polygon &polygon, double lat, double lon) const {
+    const int band = qBound(0, (int) ((lat - polygon.box.minLat) / polygon.bandHeight), (int) polygon.bandCount - 1);
+    bool inside = false;
+    for (quint32 i = _bandBegin[polygon.bandBegin + band]; i < _bandBegin[polygon.bandBegin + band + 1]; i++) {
+        const Edge &e = _edges[_bandEdges[i]];
+        // even-odd crossings of the ray towards growing longitude
+        if ((e.lat0 > lat) != (e.lat1 > lat)
+                && lon < e.lon0 + (lat - e.lat0) * (e.lon1 - e.lon0) / (e.lat1 - e.lat0)) {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+void SectorIndex::sectorsAt(double lat, double lon, QVector<Sector*> &result) const {
+    if (_nodes.isEmpty()) {
+        return;
+    }
+    int stack[64];
+    int top = 0;
+    stack[top++] = _nodes.size() - 1;
+    while (top > 0) {
+        const int index = stack[--top];
+        const Node &node = _nodes[index];
+        if (index < _leafCount) {
+            for (quint32 i = node.first; i < node.first + node.count; i++) {
+                const Polygon &polygon = _polygons[i];
+                if (polygon.box.contains(lat, lon) && polygonContains(polygon, lat, lon)
+                        && !result.contains(polygon.sector)) {
+                    result.append(polygon.sector);
+                }
+            }
+        } else {
+            for (quint32 i = node.first; i < node.first + node.count; i++) {
+                if (_nodes[i].box.contains(lat, lon)) {
+                    Q_ASSERT(top < 64);
+                    stack[top++] = i;
+                }
+            }
+        }
+    }
+}
+
+QVector<Sector*> SectorIndex::sectorsAt(double lat, double lon) const {
+    QVector<Sector*> result;
+    sectorsAt(lat, lon, result);
+    return result;
+}
+
+qint64 SectorIndex::memoryUsage() const {
+    return _polygons.capacity() * sizeof(Polygon) + (_bandBegin.capacity() + _bandEdges.capacity()) * sizeof(quint32)
+            + _edges.capacity() * sizeof(Edge) + _nodes.capacity() * sizeof(Node);
+}
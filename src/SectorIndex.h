@@ -0,0 +1,73 @@
+/**************************************************************************
+ *  This file is part of QuteScoop. See README for license
+ **************************************************************************/
+
+#ifndef SECTORINDEX_H_
+#define SECTORINDEX_H_
+
+#include <QtCore>
+
+class Sector;
+
+/**
+  Answers "which sectors contain lat/lon" without testing every outline.
+  The bounding boxes of the sector polygons (split at the date line, see
+  Sector::nonWrappedPolygons()) are packed into a static R-tree
+  (sort-tile-recursive, nodeCapacity children per node). A polygon whose
+  box contains the point is then tested with its prepared edge table: the
+  edges are bucketed into latitude bands, so the crossing test only looks
+  at the few edges of one band instead of the whole FIR outline.
+  The sectors have to stay alive until the next build() or clear().
+**/
+class SectorIndex {
+    public:
+        SectorIndex() : _leafCount(0) {}
+        void build(const QList<Sector*> &sectors);
+        void clear();
+        int size() const { return _polygons.size(); }
+
+        // appends the sectors containing lat/lon to result; a reused result does not allocate
+        void sectorsAt(double lat, double lon, QVector<Sector*> &result) const;
+        QVector<Sector*> sectorsAt(double lat, double lon) const;
+
+        qint64 memoryUsage() const;
+    private:
+        struct Box {
+            double minLat, minLon, maxLat, maxLon;
+            bool contains(double lat, double lon) const {
+                return lat >= minLat && lat <= maxLat && lon >= minLon && lon <= maxLon;
+            }
+        };
+        struct Edge {
+            double lat0, lon0, lat1, lon1;
+        };
+        struct Polygon {
+            Sector *sector;
+            Box box;
+            double bandHeight;
+            quint32 bandCount;
+            quint32 bandBegin; // into _bandBegin, bandCount + 1 entries
+        };
+        struct Node {
+            Box box;
+            quint32 first, count; // children: polygons on the leaf level, nodes above
+        };
+
+        void addPolygon(Sector *sector, const QPolygonF &polygon);
+        bool polygonContains(const Polygon &polygon, double lat, double lon) const;
+        // packs items [0, count) into parents, returns their boxes in order
+        template<typename GetBox>
+        QVector<Node> pack(QVector<int> &order, int count, GetBox box) const;
+
+        QVector<Polygon> _polygons;
+        QVector<quint32> _bandBegin; // per band of every polygon into _bandEdges, one more for its end
+        QVector<quint32> _bandEdges; // into _edges
+        QVector<Edge> _edges;
+        QVector<Node> _nodes; // the leaf level first, the root last
+        int _leafCount;
+
+        static const int nodeCapacity = 8;
+        static const int edgesPerBand = 4;
+};
+
+#endif /* SECTORINDEX_H_ */
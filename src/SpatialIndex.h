@@ -0,0 +1,233 @@
+/**************************************************************************
+ *  This file is part of QuteScoop. See README for license
+ **************************************************************************/
+
+#ifndef SPATIALINDEX_H_
+#define SPATIALINDEX_H_
+
+#include <QtCore>
+
+#include <algorithm>
+#include <cmath>
+
+/**
+  Static k-d tree over objects with lat/lon members (e.g. Airport), built
+  on their 3-D unit vectors so that there are no seams at the date line
+  or around the poles. Distances are great circle distances in nautical
+  miles like NavData::distance(); inside the tree the straight-line
+  (chord) distance is compared, which grows with the great circle one.
+  The objects have to stay where they are until the next build() or
+  clear().
+  buildGroups() instead builds one tree per key (e.g. all waypoints
+  sharing an ident) in the same node array, which are then searched by
+  nearestInGroup() only.
+**/
+template<typename T>
+class SpatialIndex {
+    public:
+        void build(const QList<T*> &objects) {
+            _nodes.clear();
+            _nodes.reserve(objects.size());
+            foreach (T *object, objects) {
+                Node node;
+                toVector(object->lat, object->lon, node.v);
+                node.object = object;
+                _nodes.append(node);
+            }
+            buildRange(0, _nodes.size(), 0);
+        }
+        void buildGroups(const QHash<QString, QList<T*> > &groups) {
+            _nodes.clear();
+            _groups.clear();
+            for (typename QHash<QString, QList<T*> >::const_iterator it = groups.constBegin();
+                 it != groups.constEnd(); ++it) {
+                const int begin = _nodes.size();
+                foreach (T *object, it.value()) {
+                    Node node;
+                    toVector(object->lat, object->lon, node.v);
+                    node.object = object;
+                    _nodes.append(node);
+                }
+                buildRange(begin, _nodes.size(), 0);
+                _groups.insert(it.key(), qMakePair(begin, _nodes.size()));
+            }
+            _nodes.squeeze();
+        }
+        void clear() {
+            _nodes.clear();
+            _groups.clear();
+        }
+        int size() const {
+            return _nodes.size();
+        }
+
+        // the closest object not farther than maxDist, 0 if there is none
+        T *nearest(double lat, double lon, double maxDist) const {
+            Q_ASSERT(_groups.isEmpty());
+            double q[3];
+            toVector(lat, lon, q);
+            double best = chord2(maxDist);
+            T *result = 0;
+            nearestInRange(0, _nodes.size(), 0, q, best, result);
+            return result;
+        }
+        // all objects not farther than radius, in no particular order
+        QList<T*> within(double lat, double lon, double radius) const {
+            Q_ASSERT(_groups.isEmpty());
+            double q[3];
+            toVector(lat, lon, q);
+            QList<T*> result;
+            withinRange(0, _nodes.size(), 0, q, chord2(radius), result);
+            return result;
+        }
+        // the k closest objects not farther than maxDist, closest first
+        QList<T*> kNearest(double lat, double lon, int k, double maxDist) const {
+            Q_ASSERT(_groups.isEmpty());
+            double q[3];
+            toVector(lat, lon, q);
+            QVector<Candidate> heap;
+            heap.reserve(k + 1);
+            if (k > 0) {
+                kNearestInRange(0, _nodes.size(), 0, q, k, chord2(maxDist), heap);
+            }
+            std::sort_heap(heap.begin(), heap.end());
+            QList<T*> result;
+            result.reserve(heap.size());
+            foreach (const Candidate &c, heap) {
+                result.append(c.object);
+            }
+            return result;
+        }
+
+        bool hasGroup(const QString &key) const {
+            return _groups.contains(key);
+        }
+        // like nearest(), among the objects of one group of buildGroups()
+        T *nearestInGroup(const QString &key, double lat, double lon, double maxDist) const {
+            const QHash<QString, QPair<int, int> >::const_iterator it = _groups.constFind(key);
+            if (it == _groups.constEnd()) {
+                return 0;
+            }
+            double q[3];
+            toVector(lat, lon, q);
+            double best = chord2(maxDist);
+            T *result = 0;
+            nearestInRange(it.value().first, it.value().second, 0, q, best, result);
+            return result;
+        }
+    private:
+        struct Node {
+            double v[3];
+            T *object;
+        };
+        // max-heap entry of kNearest(), the farthest of the k best on top
+        struct Candidate {
+            double d;
+            T *object;
+            bool operator<(const Candidate &other) const { return d < other.d; }
+        };
+
+        static void toVector(double lat, double lon, double *v) {
+            const double la = lat * M_PI / 180., lo = lon * M_PI / 180.;
+            v[0] = std::cos(la) * std::cos(lo);
+            v[1] = std::cos(la) * std::sin(lo);
+            v[2] = std::sin(la);
+        }
+        // squared chord length of a great circle distance in nm (1 nm = 1 arc minute)
+        static double chord2(double distance) {
+            const double angle = qMin(distance / 60. * M_PI / 180., M_PI);
+            const double chord = 2. * std::sin(angle / 2.);
+            return chord * chord;
+        }
+        static double distance2(const double *a, const double *b) {
+            const double dx = a[0] - b[0], dy = a[1] - b[1], dz = a[2] - b[2];
+            return dx * dx + dy * dy + dz * dz;
+        }
+
+        // the median of each range splits it along axis, alternating x, y, z
+        void buildRange(int begin, int end, int axis) {
+            if (end - begin < 2) {
+                return;
+            }
+            const int middle = begin + (end - begin) / 2;
+            std::nth_element(_nodes.begin() + begin, _nodes.begin() + middle, _nodes.begin() + end,
+                             [axis](const Node &a, const Node &b) { return a.v[axis] < b.v[axis]; });
+            buildRange(begin, middle, (axis + 1) % 3);
+            buildRange(middle + 1, end, (axis + 1) % 3);
+        }
+        void nearestInRange(int begin, int end, int axis, const double *q, double &best, T *&result) const {
+            if (begin >= end) {
+                return;
+            }
+            const int middle = begin + (end - begin) / 2;
+            const Node &node = _nodes[middle];
+            const double d = distance2(node.v, q);
+            if (d <= best) {
+                best = d;
+                result = node.object;
+            }
+            const double diff = q[axis] - node.v[axis];
+            const int next = (axis + 1) % 3;
+            if (diff < 0.) {
+                nearestInRange(begin, middle, next, q, best, result);
+                if (diff * diff <= best) {
+                    nearestInRange(middle + 1, end, next, q, best, result);
+                }
+            } else {
+                nearestInRange(middle + 1, end, next, q, best, result);
+                if (diff * diff <= best) {
+                    nearestInRange(begin, middle, next, q, best, result);
+                }
+            }
+        }
+        void kNearestInRange(int begin, int end, int axis, const double *q, int k, double maxDist2,
+                             QVector<Candidate> &heap) const {
+            if (begin >= end) {
+                return;
+            }
+            const int middle = begin + (end - begin) / 2;
+            const Node &node = _nodes[middle];
+            const double d = distance2(node.v, q);
+            if (d <= maxDist2 && (heap.size() < k || d < heap.first().d)) {
+                const Candidate c = { d, node.object };
+                heap.append(c);
+                std::push_heap(heap.begin(), heap.end());
+                if (heap.size() > k) {
+                    std::pop_heap(heap.begin(), heap.end());
+                    heap.removeLast();
+                }
+            }
+            const double diff = q[axis] - node.v[axis];
+            const int next = (axis + 1) % 3;
+            const int nearBegin = diff < 0.? begin: middle + 1, nearEnd = diff < 0.? middle: end;
+            const int farBegin = diff < 0.? middle + 1: begin, farEnd = diff < 0.? end: middle;
+            kNearestInRange(nearBegin, nearEnd, next, q, k, maxDist2, heap);
+            const double bound = heap.size() < k? maxDist2: heap.first().d;
+            if (diff * diff <= bound) {
+                kNearestInRange(farBegin, farEnd, next, q, k, maxDist2, heap);
+            }
+        }
+        void withinRange(int begin, int end, int axis, const double *q, double radius2, QList<T*> &result) const {
+            if (begin >= end) {
+                return;
+            }
+            const int middle = begin + (end - begin) / 2;
+            const Node &node = _nodes[middle];
+            if (distance2(node.v, q) <= radius2) {
+                result.append(node.object);
+            }
+            const double diff = q[axis] - node.v[axis];
+            const int next = (axis + 1) % 3;
+            if (diff < 0. || diff * diff <= radius2) {
+                withinRange(begin, middle, next, q, radius2, result);
+            }
+            if (diff >= 0. || diff * diff <= radius2) {
+                withinRange(middle + 1, end, next, q, radius2, result);
+            }
+        }
+
+        QVector<Node> _nodes;
+        QHash<QString, QPair<int, int> > _groups; // key -> node range of buildGroups()
+};
+
+#endif /* SPATIALINDEX_H_ */
@@ -0,0 +1,45 @@
+/**************************************************************************
+ *  This file is part of QuteScoop. See README for license
+ **************************************************************************/
+
+#include "StringPool.h"
+
+static QMutex poolMutex;
+static QSet<QString> pool;
+
+QString StringPool::intern(const QString &string) {
+    if (string.isEmpty())
+        return string;
+
+    QMutexLocker locker(&poolMutex);
+    QSet<QString>::const_iterator it = pool.constFind(string);
+    if (it != pool.constEnd())
+        return *it;
+    pool.insert(string);
+    return string;
+}
+
+void StringPool::squeeze() {
+    QMutexLocker locker(&poolMutex);
+    const int before = pool.size();
+    QSet<QString>::iterator it = pool.begin();
+    while (it != pool.end()) {
+        // only referenced by the pool. Nobody can get a new reference without the lock.
+        if (it->isDetached())
+            it = pool.erase(it);
+        else
+            ++it;
+    }
+    qDebug() << "StringPool::squeeze()" << before << "->" << pool.size() << "strings";
+}
+
+int StringPool::size() {
+    QMutexLocker locker(&poolMutex);
+    return pool.size();
+}
+
+qint64 StringPool::storageBytes(const QString &string) {
+    if (string.isEmpty())
+        return 0;
+    return sizeof(QArrayData) + (string.size() + 1) * sizeof(QChar);
+}
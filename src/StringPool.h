@@ -0,0 +1,29 @@
+/**************************************************************************
+ *  This file is part of QuteScoop. See README for license
+ **************************************************************************/
+
+#ifndef STRINGPOOL_H_
+#define STRINGPOOL_H_
+
+#include <QtCore>
+
+/**
+  Interning table for the short tokens that repeat across clients and
+  snapshots: callsigns, ICAO codes, aircraft types, flight rules, servers...
+  intern() returns the pooled copy, so equal values share one buffer
+  (QString is implicitly shared) and equal strings compare by pointer in
+  QString's comparison fast path.
+  Thread safe: Whazzup data is decoded on a thread pool.
+**/
+class StringPool {
+    public:
+        static QString intern(const QString &string);
+        // drops strings that are not used outside the pool anymore
+        static void squeeze();
+        static int size();
+
+        // bytes of QString storage: header plus UTF-16 data (0 for shared empty/null strings)
+        static qint64 storageBytes(const QString &string);
+};
+
+#endif /*STRINGPOOL_H_*/
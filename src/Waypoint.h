@@ -17,7 +17,7 @@ class Waypoint: public MapObject {
         virtual QString mapLabel() const { return label; }
         virtual QString toolTip() const;
         virtual void showDetailsDialog() {} // not applicable
-        virtual int type() { return 0;}
+        virtual int type() const { return 0;}
         QString regionCode;
 };
 
@@ -9,6 +9,7 @@
 #include "GuiMessage.h"
 #include "Client.h"
 #include "Window.h"
+#include "StringPool.h"
 
 Whazzup *whazzupInstance = 0;
 
@@ -19,13 +20,19 @@ Whazzup* Whazzup::instance() {
 }
 
 Whazzup::Whazzup():
-        _replyStatus(0), _replyWhazzup(0), _replyBookings(0) {
+        _archive(0), _index(0), _processingHeld(false), _replyStatus(0), _replyWhazzup(0), _replyBookings(0) {
+    _archiveWriter.setMaxThreadCount(1); // frames are encoded against the one before
     _downloadTimer = new QTimer(this);
     _bookingsTimer = new QTimer(this);
     connect(_downloadTimer, &QTimer::timeout, this, &Whazzup::downloadJson3);
     connect(_bookingsTimer, &QTimer::timeout, this, &Whazzup::downloadBookings);
 
     connect(this, &Whazzup::needBookings, this, &Whazzup::downloadBookings);
+
+    _decoder = new WhazzupDecoder(this);
+    connect(_decoder, &WhazzupDecoder::statusDecoded, this, &Whazzup::statusDecoded);
+    connect(_decoder, &WhazzupDecoder::whazzupDecoded, this, &Whazzup::whazzupDecoded);
+    connect(_decoder, &WhazzupDecoder::bookingsDecoded, this, &Whazzup::bookingsDecoded);
 }
 
 Whazzup::~Whazzup() {
@@ -34,6 +41,9 @@ Whazzup::~Whazzup() {
     if(_replyStatus != 0) delete _replyStatus;
     if(_replyWhazzup != 0) delete _replyWhazzup;
     if(_replyBookings != 0) delete _replyBookings;
+    _archiveWriter.waitForDone();
+    delete _archive;
+    delete _index;
 }
 
 void Whazzup::setStatusLocation(const QString& statusLocation) {
@@ -66,43 +76,18 @@ void Whazzup::processStatus() {
     if(_replyStatus->bytesAvailable() == 0)
         GuiMessages::warning("Statusfile is empty");
 
-    _json3Urls.clear();
-    _metar0Url = "";
-    _user0Url = "";
-
-    QJsonDocument data = QJsonDocument::fromJson(_replyStatus->readAll());
+    _decoder->decodeStatus(_replyStatus->readAll());
+}
 
-    if(data.isNull()) {
+void Whazzup::statusDecoded(const WhazzupDecoder::Status &status) {
+    if(!status.isValid) {
         GuiMessages::warning("Couldn't parse status. Does the status URL return the old format?");
-    } else {
-        QJsonObject json = data.object();
-        if(json.contains("data") && json["data"].isObject()) {
-            QJsonObject vatsimDataSources = json["data"].toObject();
-            if(vatsimDataSources.contains("v3") && vatsimDataSources["v3"].isArray()) {
-                QJsonArray v3Urls = vatsimDataSources["v3"].toArray();
-                for(int i = 0; i < v3Urls.size(); ++i) {
-                    if(v3Urls[i].isString()) {
-                        _json3Urls.append(v3Urls[i].toString());
-                    }
-                }
-            }
-        }
-
-        if(json.contains("user") && json["user"].isArray()) {
-            QJsonArray userUrls = json["user"].toArray();
-            if (userUrls.first() != QJsonValue::Undefined) {
-                _user0Url = userUrls.first().toString();
-            }
-        }
-
-        if(json.contains("metar") && json["metar"].isArray()) {
-            QJsonArray metarUrls = json["metar"].toArray();
-            if (metarUrls.first() != QJsonValue::Undefined) {
-                _metar0Url = metarUrls.first().toString();
-            }
-        }
     }
 
+    _json3Urls = status.json3Urls;
+    _metar0Url = status.metar0Url;
+    _user0Url = status.user0Url;
+
     _lastDownloadTime = QTime();
 
     GuiMessages::remove("statusdownload");
@@ -124,6 +109,21 @@ void Whazzup::fromFile(QString filename) {
     connect(_replyWhazzup, &QNetworkReply::finished, this, &Whazzup::processWhazzup);
 }
 
+void Whazzup::fromDownloaded(const QDateTime &time) {
+    qDebug() << "Whazzup::fromDownloaded()" << time;
+    GuiMessages::progress("whazzupProcess", "Loading downloaded Whazzup...");
+
+    WhazzupIndex *index = downloadedIndex();
+    const int i = index->indexAtOrBefore(time);
+    const QByteArray bytes = (i >= 0 && index->time(i) == time)? index->whazzupJson(i): QByteArray();
+    if(bytes.isEmpty()) {
+        GuiMessages::warning(QString("No downloaded Whazzup for %1").arg(time.toString()));
+        GuiMessages::remove("whazzupProcess");
+        return;
+    }
+    _decoder->decodeWhazzup(bytes, WhazzupData::WHAZZUP, Settings::downloadInterval());
+}
+
 void Whazzup::downloadJson3() {
     if(_json3Urls.size() == 0) {
         setStatusLocation(Settings::statusLocation());
@@ -177,33 +177,68 @@ void Whazzup::processWhazzup() {
         _downloadTimer->start(30 * 1000); // try again in 30s
         return;
     }
+    if(_processingHeld) {
+        qDebug() << "Whazzup::processWhazzup() holding Whazzup until processing is released";
+        _heldWhazzup = _replyWhazzup->readAll();
+        return;
+    }
     GuiMessages::progress("whazzupProcess", "Processing Whazzup...");
 
-    QByteArray *bytes = new QByteArray(_replyWhazzup->readAll());
-    WhazzupData newWhazzupData(bytes, WhazzupData::WHAZZUP);
+    _decoder->decodeWhazzup(_replyWhazzup->readAll(), WhazzupData::WHAZZUP, Settings::downloadInterval());
+}
+
+void Whazzup::holdProcessing() {
+    _processingHeld = true;
+}
+
+void Whazzup::releaseProcessing() {
+    _processingHeld = false;
+    emit processingReleased();
+    if(!_heldWhazzup.isEmpty()) {
+        GuiMessages::progress("whazzupProcess", "Processing Whazzup...");
+        _decoder->decodeWhazzup(_heldWhazzup, WhazzupData::WHAZZUP, Settings::downloadInterval());
+        _heldWhazzup.clear();
+    }
+}
 
-    if(!newWhazzupData.isNull()) {
+void Whazzup::whazzupDecoded(QSharedPointer<WhazzupData> newWhazzupData, const QByteArray &bytes) {
+    if(!newWhazzupData->isNull()) {
         if(!predictedTime.isValid() &&
-                newWhazzupData.whazzupTime.secsTo(QDateTime::currentDateTimeUtc()) > 60 * 30)
+                newWhazzupData->whazzupTime.secsTo(QDateTime::currentDateTimeUtc()) > 60 * 30)
             GuiMessages::warning("Whazzup data more than 30 minutes old.");
 
-        if(newWhazzupData.whazzupTime != _data.whazzupTime) {
-            _data.updateFrom(newWhazzupData);
+        if(newWhazzupData->whazzupTime != _data.whazzupTime) {
+            _data.updateFrom(*newWhazzupData);
             qDebug() << "Whazzup::whazzupDownloaded() Whazzup updated from timestamp" << _data.whazzupTime;
+            StringPool::squeeze(); // forget callsigns etc. of clients that are gone
             emit newData(true);
 
             if(Settings::saveWhazzupData()) {
-                // write out Whazzup to a file
-                QFile out(Settings::dataDirectory(
-                          QString("downloaded/%1_%2.whazzup")
+                // append Whazzup to the archive of the day
+                const QString archiveName = Settings::dataDirectory(
+                          QString("downloaded/%1_%2%3")
                           .arg(Settings::downloadNetwork())
-                          .arg(_data.whazzupTime.toString("yyyyMMdd-HHmmss"))));
-                if (!out.exists() && out.open(QIODevice::WriteOnly | QIODevice::Text)) {
-                    qDebug() << "Whazzup::processWhazzup writing Whazzup to" << out.fileName();
-                    out.write(bytes->constData());
-                    out.close();
-                } else
-                    qWarning() << "Whazzup::processWhazzup: Could not write Whazzup to disk" << out.fileName();
+                          .arg(_data.whazzupTime.toUTC().toString("yyyyMMdd"))
+                          .arg(WhazzupArchive::suffix));
+                const QDateTime whazzupTime = _data.whazzupTime;
+                const int network = Settings::downloadNetwork();
+                downloadedIndex(); // before appending, it might need to be built
+                // encoding and compressing a frame takes a while: not on the GUI thread
+                _archiveWriter.start([this, archiveName, network, bytes, whazzupTime]() {
+                    if(_archive == 0 || _archive->fileName() != archiveName) {
+                        delete _archive;
+                        _archive = new WhazzupArchive(archiveName);
+                    }
+                    if(_archive->append(bytes, whazzupTime)) {
+                        const WhazzupArchive::Frame frame = _archive->frames().last();
+                        QMetaObject::invokeMethod(this, [this, archiveName, network, frame]() {
+                            qDebug() << "Whazzup::whazzupDecoded() appended Whazzup to" << archiveName;
+                            archived(network, frame);
+                        }, Qt::QueuedConnection);
+                    } else
+                        qWarning() << "Whazzup::whazzupDecoded() could not append Whazzup to" << archiveName
+                                   << "(already archived?)";
+                });
             }
         } else
             GuiMessages::message(QString("We already have Whazzup with that Timestamp: %1")
@@ -225,6 +260,16 @@ void Whazzup::processWhazzup() {
     GuiMessages::remove("whazzupProcess");
 }
 
+void Whazzup::archived(int network, const WhazzupArchive::Frame &frame) {
+    WhazzupIndex *index = downloadedIndex();
+    if(index->network() != network)
+        return; // the network was switched after the download, its index is built from the files again
+    // an index that was built after the frame was written has it already
+    const int i = index->indexAtOrBefore(frame.time);
+    if(i < 0 || index->time(i) != frame.time)
+        index->addArchived(frame);
+}
+
 void Whazzup::downloadBookings() {
     if (!Settings::downloadBookings())
         return;
@@ -271,17 +316,19 @@ void Whazzup::processBookings() {
 
     GuiMessages::progress("bookingsProcess", "Processing Bookings...");
 
-    QByteArray *bytes = new QByteArray(_replyBookings->readAll());
-    WhazzupData newBookingsData(bytes, WhazzupData::ATCBOOKINGS);
-    if (!newBookingsData.isNull()) {
-        qDebug() << "Whazzup::processBookings() step 2";
-        if (newBookingsData.bookingsTime.secsTo(QDateTime::currentDateTimeUtc()) > 60 * 60 * 3)
+    _decoder->decodeWhazzup(_replyBookings->readAll(), WhazzupData::ATCBOOKINGS, Settings::downloadInterval());
+}
+
+void Whazzup::bookingsDecoded(QSharedPointer<WhazzupData> newBookingsData, const QByteArray &bytes) {
+    if (!newBookingsData->isNull()) {
+        qDebug() << "Whazzup::bookingsDecoded() step 2";
+        if (newBookingsData->bookingsTime.secsTo(QDateTime::currentDateTimeUtc()) > 60 * 60 * 3)
             GuiMessages::warning("Bookings data more than 3 hours old.");
 
-        if (newBookingsData.bookingsTime != _data.bookingsTime) {
-            qDebug() << "Whazzup::processBookings() will call updateFrom()";
-            _data.updateFrom(newBookingsData);
-            qDebug() << "Whazzup::processBookings() Bookings updated from timestamp"
+        if (newBookingsData->bookingsTime != _data.bookingsTime) {
+            qDebug() << "Whazzup::bookingsDecoded() will call updateFrom()";
+            _data.updateFrom(*newBookingsData);
+            qDebug() << "Whazzup::bookingsDecoded() Bookings updated from timestamp"
                      << _data.bookingsTime;
 
             QFile out(Settings::dataDirectory(
@@ -289,11 +336,11 @@ void Whazzup::processBookings() {
                     .arg(Settings::downloadNetwork())
                     .arg(_data.bookingsTime.toString("yyyyMMdd-HHmmss"))));
             if (!out.exists() && out.open(QIODevice::WriteOnly | QIODevice::Text)) {
-                qDebug() << "Whazzup::processBookings writing bookings to" << out.fileName();
-                out.write(bytes->constData());
+                qDebug() << "Whazzup::bookingsDecoded writing bookings to" << out.fileName();
+                out.write(bytes);
                 out.close();
             } else
-                qWarning() << "Whazzup::processBookings: Could not write Bookings to disk"
+                qWarning() << "Whazzup::bookingsDecoded: Could not write Bookings to disk"
                            << out.fileName();
 
             // from now on we want to redownload when the user triggers a network update
@@ -304,7 +351,7 @@ void Whazzup::processBookings() {
                                .arg(_data.bookingsTime.toString("ddd MM/dd HHmm'z'")));
     }
     GuiMessages::remove("bookingsProcess");
-    qDebug() << "Whazzup::processBookings() -- finished";
+    qDebug() << "Whazzup::bookingsDecoded() -- finished";
 }
 
 
@@ -329,10 +376,12 @@ void Whazzup::setPredictedTime(QDateTime predictedTime) {
         if (Settings::downloadBookings() && !_data.bookingsTime.isValid()) {
             emit needBookings();
         }
-        if(predictedTime == _data.whazzupTime) {
+        if(!predictedTime.isValid()) { // warp switched off
+            _predictedData = WhazzupData(); // let go of the clients
+        } else if(predictedTime == _data.whazzupTime) {
             qDebug() << "Whazzup::setPredictedTime() predictedTime == data.whazzupTime"
                      << "(no need to predict, we have it already :) )";
-            _predictedData = _data;
+            _predictedData = _data; // shares the clients, cheap
         } else {
             _predictedData.updateFrom(WhazzupData(predictedTime, _data));
         }
@@ -341,25 +390,12 @@ void Whazzup::setPredictedTime(QDateTime predictedTime) {
     }
 }
 
-QList <QPair <QDateTime, QString> > Whazzup::downloadedWhazzups() const {
-    // Process directory
-    QStringList list = QDir(Settings::dataDirectory("downloaded/")).entryList(
-            QStringList(QString("%1_*.whazzup").arg(Settings::downloadNetwork())),
-            QDir::Files | QDir::Readable); // getting all *.whazzup
-    list.sort();
-
-    QList <QPair <QDateTime, QString> > returnList;
-    foreach(const QString filename, list) {
-        QRegExp dtRe = QRegExp("\\.*_(\\d{8}-\\d{6})"); // dateTime: 20110301-191050
-        if (dtRe.indexIn(filename) > 0) {
-            QDateTime dt = QDateTime::fromString(dtRe.cap(1), "yyyyMMdd-HHmmss");
-            dt.setTimeSpec(Qt::UTC);
-            returnList.append(QPair<QDateTime, QString>(
-                    dt,
-                    Settings::dataDirectory(QString("downloaded/%1").
-                                                       arg(filename))
-            ));
-        }
+WhazzupIndex *Whazzup::downloadedIndex() {
+    if(_index == 0 || _index->network() != Settings::downloadNetwork()) {
+        // the index is built from the files: no frame may be half written then
+        _archiveWriter.waitForDone();
+        delete _index;
+        _index = new WhazzupIndex(Settings::dataDirectory("downloaded/"), Settings::downloadNetwork());
     }
-    return returnList;
+    return _index;
 }
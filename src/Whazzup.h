@@ -6,6 +6,9 @@
 #define WHAZZUP_H_
 
 #include "WhazzupData.h"
+#include "WhazzupDecoder.h"
+#include "WhazzupArchive.h"
+#include "WhazzupIndex.h"
 
 #include <QNetworkReply>
 
@@ -25,28 +28,46 @@ class Whazzup: public QObject {
         void setPredictedTime(QDateTime predictedTime);
         QString userUrl(const QString& id) const,
                 metarUrl(const QString& id) const;
-        QList <QPair <QDateTime, QString> > downloadedWhazzups() const;
+        // saved raw Whazzups and archived snapshots of the current network
+        WhazzupIndex *downloadedIndex();
+        // the snapshot at exactly that time, from downloadedIndex()
+        void fromDownloaded(const QDateTime &time);
         QDateTime predictedTime;
     signals:
         void newData(bool isNew);
         void whazzupDownloaded();
         void needBookings();
+        void processingReleased();
     public slots:
         void downloadJson3();
         void fromFile(QString filename);
         void setStatusLocation(const QString& url);
         void downloadBookings();
+        // keep downloaded Whazzups until releaseProcessing(), e.g. while NavData is loading
+        void holdProcessing();
+        void releaseProcessing();
     private slots:
         void processStatus();
+        void statusDecoded(const WhazzupDecoder::Status &status);
         void whazzupProgress(qint64 prog,qint64 tot);
         void processWhazzup();
+        void whazzupDecoded(QSharedPointer<WhazzupData> newWhazzupData, const QByteArray &bytes);
         void bookingsProgress(qint64 prog,qint64 tot);
         void processBookings();
+        void bookingsDecoded(QSharedPointer<WhazzupData> newBookingsData, const QByteArray &bytes);
     private:
         Whazzup();
         virtual ~Whazzup();
+        // adds a frame that _archiveWriter has appended to downloadedIndex() of that network
+        void archived(int network, const WhazzupArchive::Frame &frame);
 
         WhazzupData _data, _predictedData;
+        WhazzupDecoder *_decoder;
+        WhazzupArchive *_archive; // of the current day, to append to; only used by _archiveWriter
+        QThreadPool _archiveWriter;
+        WhazzupIndex *_index;
+        bool _processingHeld;
+        QByteArray _heldWhazzup; // downloaded while processing was held
         QStringList _json3Urls;
         QString _metar0Url, _user0Url;
         QTime _lastDownloadTime;
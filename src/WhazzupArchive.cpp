@@ -0,0 +1,449 @@
+/**************************************************************************
+ *  This file is part of QuteScoop. See README for license
+ **************************************************************************/
+
+#include "WhazzupArchive.h"
+
+#include <cstring>
+
+const QString WhazzupArchive::suffix = ".whazzuparchive";
+
+static const quint32 frameMagic = 0x51535741; // "QSWA"
+static const quint8 formatVersion = 1;
+
+static const QStringList sectionKeys = { "pilots", "controllers", "atis", "prefiles" };
+// stored as XOR with the value of the same client in the previous frame
+static const QStringList numberKeys = {
+    "latitude", "longitude", "altitude", "groundspeed", "heading", "qnh_i_hg", "qnh_mb",
+    "cid", "rating", "pilot_rating", "facility", "visual_range"
+};
+// stored only if they changed since the previous frame
+static const QStringList valueKeys = { "flight_plan", "last_updated", "transponder", "text_atis" };
+
+enum ValueState : quint8 { Missing = 0, Unchanged = 1, Changed = 2 };
+
+static QByteArray compactJson(const QJsonObject &object) {
+    return QJsonDocument(object).toJson(QJsonDocument::Compact);
+}
+
+// wrapped into an array, so that null and scalars survive
+static QByteArray compactJson(const QJsonValue &value) {
+    return QJsonDocument(QJsonArray({ value })).toJson(QJsonDocument::Compact);
+}
+
+static QJsonValue jsonValue(const QByteArray &bytes) {
+    return QJsonDocument::fromJson(bytes).array().at(0);
+}
+
+static WhazzupArchive::Record splitRecord(QJsonObject object) {
+    WhazzupArchive::Record record;
+    record.present = 0;
+    record.numbers.fill(0, numberKeys.size());
+    record.values.resize(valueKeys.size());
+    for (int k = 0; k < numberKeys.size(); k++) {
+        const QJsonValue value = object.value(numberKeys[k]);
+        if (value.isDouble()) {
+            const double d = value.toDouble();
+            std::memcpy(&record.numbers[k], &d, sizeof(d));
+            record.present |= 1 << k;
+            object.remove(numberKeys[k]);
+        }
+    }
+    for (int k = 0; k < valueKeys.size(); k++) {
+        if (object.contains(valueKeys[k])) {
+            record.values[k] = compactJson(object.value(valueKeys[k]));
+            object.remove(valueKeys[k]);
+        }
+    }
+    record.rest = compactJson(object);
+    return record;
+}
+
+static QJsonObject joinRecord(const WhazzupArchive::Record &record) {
+    QJsonObject object = QJsonDocument::fromJson(record.rest).object();
+    for (int k = 0; k < numberKeys.size(); k++) {
+        if (record.present & (1 << k)) {
+            double d;
+            std::memcpy(&d, &record.numbers[k], sizeof(d));
+            object.insert(numberKeys[k], d);
+        }
+    }
+    for (int k = 0; k < valueKeys.size(); k++) {
+        if (!record.values[k].isEmpty()) {
+            object.insert(valueKeys[k], jsonValue(record.values[k]));
+        }
+    }
+    return object;
+}
+
+static const WhazzupArchive::Record *baseRecord(const WhazzupArchive::Base &base, const QString &key) {
+    QHash<QString, WhazzupArchive::Record>::const_iterator it = base.records.constFind(key);
+    return it == base.records.constEnd()? 0: &it.value();
+}
+
+/**
+  One frame, column by column. base holds the previous frame and is
+  replaced by this one.
+**/
+static QByteArray encodePayload(const QJsonObject &root, WhazzupArchive::Base &base) {
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_12);
+    WhazzupArchive::Base next;
+
+    // "general" changes with every snapshot
+    if (root.contains("general")) {
+        out << (quint8) Changed << compactJson(root.value("general"));
+    } else {
+        out << (quint8) Missing;
+    }
+
+    QStringList sections;
+    foreach (const QString &section, sectionKeys) {
+        if (root.value(section).isArray()) {
+            sections << section;
+        }
+    }
+    out << sections;
+
+    foreach (const QString &section, sections) {
+        QStringList callsigns;
+        QVector<WhazzupArchive::Record> records;
+        foreach (const QJsonValue &value, root.value(section).toArray()) {
+            const QJsonObject object = value.toObject();
+            callsigns << object.value("callsign").toString();
+            records << splitRecord(object);
+        }
+        QVector<const WhazzupArchive::Record*> bases;
+        foreach (const QString &callsign, callsigns) {
+            bases << baseRecord(base, section + "/" + callsign);
+        }
+        out << callsigns;
+
+        for (int i = 0; i < records.size(); i++) {
+            out << records[i].present;
+        }
+        for (int k = 0; k < numberKeys.size(); k++) {
+            for (int i = 0; i < records.size(); i++) {
+                if (records[i].present & (1 << k)) {
+                    const quint64 previous = (bases[i] != 0 && (bases[i]->present & (1 << k)))?
+                                bases[i]->numbers[k]: 0;
+                    out << (records[i].numbers[k] ^ previous);
+                }
+            }
+        }
+        for (int k = 0; k < valueKeys.size(); k++) {
+            QVector<quint8> states(records.size());
+            for (int i = 0; i < records.size(); i++) {
+                if (records[i].values[k].isEmpty()) {
+                    states[i] = Missing;
+                } else if (bases[i] != 0 && bases[i]->values[k] == records[i].values[k]) {
+                    states[i] = Unchanged;
+                } else {
+                    states[i] = Changed;
+                }
+                out << states[i];
+            }
+            for (int i = 0; i < records.size(); i++) {
+                if (states[i] == Changed) {
+                    out << records[i].values[k];
+                }
+            }
+        }
+        QVector<quint8> restStates(records.size());
+        for (int i = 0; i < records.size(); i++) {
+            restStates[i] = (bases[i] != 0 && bases[i]->rest == records[i].rest)? Unchanged: Changed;
+            out << restStates[i];
+        }
+        for (int i = 0; i < records.size(); i++) {
+            if (restStates[i] == Changed) {
+                out << records[i].rest;
+            }
+        }
+
+        for (int i = 0; i < records.size(); i++) {
+            next.records.insert(section + "/" + callsigns[i], records[i]);
+        }
+    }
+
+    // servers, facilities, ratings... hardly ever change
+    QJsonObject rootRest = root;
+    rootRest.remove("general");
+    foreach (const QString &section, sections) {
+        rootRest.remove(section);
+    }
+    next.rootRest = compactJson(rootRest);
+    if (!base.rootRest.isEmpty() && next.rootRest == base.rootRest) {
+        out << (quint8) Unchanged;
+    } else {
+        out << (quint8) Changed << next.rootRest;
+    }
+
+    base = next;
+    return payload;
+}
+
+// the reverse of encodePayload(). The JSON is only built if root is given.
+static bool decodePayload(const QByteArray &payload, WhazzupArchive::Base &base, QJsonObject *root) {
+    QDataStream in(payload);
+    in.setVersion(QDataStream::Qt_5_12);
+    WhazzupArchive::Base next;
+
+    quint8 generalState;
+    QByteArray general;
+    in >> generalState;
+    if (generalState == Changed) {
+        in >> general;
+    }
+
+    QStringList sections;
+    in >> sections;
+    foreach (const QString &section, sections) {
+        QStringList callsigns;
+        in >> callsigns;
+        const int n = callsigns.size();
+        QVector<WhazzupArchive::Record> records(n);
+        QVector<const WhazzupArchive::Record*> bases;
+        for (int i = 0; i < n; i++) {
+            bases << baseRecord(base, section + "/" + callsigns[i]);
+            in >> records[i].present;
+            records[i].numbers.fill(0, numberKeys.size());
+            records[i].values.resize(valueKeys.size());
+        }
+        for (int k = 0; k < numberKeys.size(); k++) {
+            for (int i = 0; i < n; i++) {
+                if (records[i].present & (1 << k)) {
+                    const quint64 previous = (bases[i] != 0 && (bases[i]->present & (1 << k)))?
+                                bases[i]->numbers[k]: 0;
+                    quint64 bits;
+                    in >> bits;
+                    records[i].numbers[k] = bits ^ previous;
+                }
+            }
+        }
+        for (int k = 0; k < valueKeys.size(); k++) {
+            QVector<quint8> states(n);
+            for (int i = 0; i < n; i++) {
+                in >> states[i];
+            }
+            for (int i = 0; i < n; i++) {
+                if (states[i] == Changed) {
+                    in >> records[i].values[k];
+                } else if (states[i] == Unchanged && bases[i] != 0) {
+                    records[i].values[k] = bases[i]->values[k];
+                }
+            }
+        }
+        QVector<quint8> restStates(n);
+        for (int i = 0; i < n; i++) {
+            in >> restStates[i];
+        }
+        for (int i = 0; i < n; i++) {
+            if (restStates[i] == Changed) {
+                in >> records[i].rest;
+            } else if (bases[i] != 0) {
+                records[i].rest = bases[i]->rest;
+            }
+        }
+
+        if (root != 0) {
+            QJsonArray array;
+            for (int i = 0; i < n; i++) {
+                array.append(joinRecord(records[i]));
+            }
+            root->insert(section, array);
+        }
+        for (int i = 0; i < n; i++) {
+            next.records.insert(section + "/" + callsigns[i], records[i]);
+        }
+    }
+
+    quint8 rootRestState;
+    in >> rootRestState;
+    if (rootRestState == Changed) {
+        in >> next.rootRest;
+    } else {
+        next.rootRest = base.rootRest;
+    }
+
+    if (in.status() != QDataStream::Ok) {
+        base = WhazzupArchive::Base();
+        return false;
+    }
+    if (root != 0) {
+        const QJsonObject rootRest = QJsonDocument::fromJson(next.rootRest).object();
+        for (QJsonObject::const_iterator it = rootRest.constBegin(); it != rootRest.constEnd(); ++it) {
+            root->insert(it.key(), it.value());
+        }
+        if (generalState == Changed) {
+            root->insert("general", jsonValue(general));
+        }
+    }
+    base = next;
+    return true;
+}
+
+WhazzupArchive::WhazzupArchive(const QString &fileName) :
+    _fileName(fileName),
+    _framesRead(false),
+    _validSize(0),
+    _framesSinceKeyframe(0)
+{}
+
+// reads the frame headers. A frame that was cut off (crash while writing) ends the list.
+bool WhazzupArchive::readFrames() {
+    _framesRead = true;
+    _frames.clear();
+    _validSize = 0;
+
+    QFile file(_fileName);
+    if (!file.exists()) {
+        return true;
+    }
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "WhazzupArchive::readFrames() could not open" << _fileName;
+        return false;
+    }
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_12);
+    while (file.size() - _validSize >= frameHeaderSize) {
+        quint32 magic, length;
+        quint8 version, isKeyframe;
+        qint64 msecs;
+        in >> magic >> version >> isKeyframe >> msecs >> length;
+        if (magic != frameMagic || version != formatVersion || _validSize + frameHeaderSize + length > file.size()) {
+            qWarning() << "WhazzupArchive::readFrames() ignoring" << _fileName
+                       << "from offset" << _validSize;
+            break;
+        }
+        Frame frame;
+        frame.time = QDateTime::fromMSecsSinceEpoch(msecs, Qt::UTC);
+        frame.offset = _validSize + frameHeaderSize;
+        frame.length = length;
+        frame.isKeyframe = isKeyframe != 0;
+        _frames.append(frame);
+        _validSize = frame.offset + length;
+        file.seek(_validSize);
+    }
+    return true;
+}
+
+bool WhazzupArchive::append(const QByteArray &whazzupJson, const QDateTime &whazzupTime) {
+    if (!_framesRead) {
+        readFrames();
+    }
+    if (!whazzupTime.isValid() || (!_frames.isEmpty() && whazzupTime <= _frames.last().time)) {
+        return false;
+    }
+    const QJsonDocument document = QJsonDocument::fromJson(whazzupJson);
+    if (!document.isObject()) {
+        return false;
+    }
+
+    const bool isKeyframe = _writeBase.isEmpty() || _framesSinceKeyframe + 1 >= keyframeInterval;
+    if (isKeyframe) {
+        _writeBase = Base();
+    }
+    const QByteArray compressed = qCompress(encodePayload(document.object(), _writeBase), 9);
+
+    QFile file(_fileName);
+    if (!file.open(QIODevice::ReadWrite) || !file.resize(_validSize) || !file.seek(_validSize)) {
+        qWarning() << "WhazzupArchive::append() could not open" << _fileName << file.errorString();
+        _writeBase = Base();
+        return false;
+    }
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_12);
+    out << frameMagic << formatVersion << (quint8) isKeyframe
+        << whazzupTime.toMSecsSinceEpoch() << (quint32) compressed.size();
+    out.writeRawData(compressed.constData(), compressed.size());
+    if (out.status() != QDataStream::Ok || !file.flush()) {
+        qWarning() << "WhazzupArchive::append() could not write to" << _fileName << file.errorString();
+        _writeBase = Base(); // the next frame has to stand on its own
+        return false;
+    }
+
+    Frame frame;
+    frame.time = whazzupTime.toUTC();
+    frame.offset = _validSize + frameHeaderSize;
+    frame.length = compressed.size();
+    frame.isKeyframe = isKeyframe;
+    _frames.append(frame);
+    _validSize = frame.offset + frame.length;
+    _framesSinceKeyframe = isKeyframe? 0: _framesSinceKeyframe + 1;
+    return true;
+}
+
+QList<WhazzupArchive::Frame> WhazzupArchive::frames() {
+    if (!_framesRead) {
+        readFrames();
+    }
+    return _frames;
+}
+
+QList<QDateTime> WhazzupArchive::timestamps() {
+    QList<QDateTime> result;
+    foreach (const Frame &frame, frames()) {
+        result.append(frame.time);
+    }
+    return result;
+}
+
+// false if the frame is broken. base is empty then, the frames after it can not be decoded.
+bool WhazzupArchive::decodeFrame(QFile &file, const Frame &frame, Base &base, QJsonObject *root) {
+    const QByteArray payload = file.seek(frame.offset)? qUncompress(file.read(frame.length)): QByteArray();
+    if (payload.isEmpty() || !decodePayload(payload, base, root)) {
+        qWarning() << "WhazzupArchive::decodeFrame() broken frame at" << frame.offset << "in" << _fileName;
+        base = Base();
+        return false;
+    }
+    return true;
+}
+
+QByteArray WhazzupArchive::whazzupJson(const QList<Frame> &chain) {
+    if (chain.isEmpty() || !chain.first().isKeyframe) {
+        return QByteArray();
+    }
+    QFile file(_fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "WhazzupArchive::whazzupJson() could not open" << _fileName;
+        return QByteArray();
+    }
+    Base base;
+    for (int i = 0; i < chain.size() - 1; i++) {
+        if (!decodeFrame(file, chain[i], base, 0)) {
+            return QByteArray();
+        }
+    }
+    QJsonObject root;
+    if (!decodeFrame(file, chain.last(), base, &root) || root.isEmpty()) {
+        return QByteArray();
+    }
+    return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
+
+QByteArray WhazzupArchive::whazzupJson(const QDateTime &time) {
+    if (!_framesRead) {
+        readFrames();
+    }
+    int index = _frames.size() - 1;
+    while (index >= 0 && _frames[index].time > time) {
+        index--;
+    }
+    if (index < 0) {
+        return QByteArray();
+    }
+    int keyframe = index;
+    while (keyframe > 0 && !_frames[keyframe].isKeyframe) {
+        keyframe--;
+    }
+    return whazzupJson(_frames.mid(keyframe, index - keyframe + 1));
+}
+
+WhazzupData WhazzupArchive::whazzupData(const QDateTime &time) {
+    QByteArray bytes = whazzupJson(time);
+    if (bytes.isEmpty()) {
+        return WhazzupData();
+    }
+    return WhazzupData(&bytes, WhazzupData::WHAZZUP, 0);
+}
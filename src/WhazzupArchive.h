@@ -0,0 +1,77 @@
+/**************************************************************************
+ *  This file is part of QuteScoop. See README for license
+ **************************************************************************/
+
+#ifndef WHAZZUPARCHIVE_H_
+#define WHAZZUPARCHIVE_H_
+
+#include "WhazzupData.h"
+
+#include <QtCore>
+
+/**
+  Append-only archive of consecutive Whazzup v3 snapshots, one file per
+  network and UTC day. Each snapshot is a zlib compressed frame of column
+  blocks: per client section the callsigns, then every numeric field
+  (position, altitude, speed...) XORed with its value in the previous
+  snapshot, then JSON values like the flight plan which are only stored
+  when they changed. Every keyframeInterval frames (and after reopening)
+  a frame is stored without reference to the previous one, so a snapshot
+  can be rebuilt by decoding at most that many frames.
+  The rebuilt JSON holds the same values as the downloaded one, only the
+  formatting and key order differ.
+**/
+class WhazzupArchive {
+    public:
+        static const QString suffix;
+        static const int keyframeInterval = 30;
+        static const qint64 frameHeaderSize = 18; // magic, version, keyframe flag, time, payload length
+
+        struct Frame {
+            QDateTime time;
+            qint64 offset; // of the compressed payload
+            quint32 length;
+            bool isKeyframe;
+        };
+
+        explicit WhazzupArchive(const QString &fileName);
+        QString fileName() const { return _fileName; }
+
+        // false if the payload is not a Whazzup v3 object or time is not after the last snapshot
+        bool append(const QByteArray &whazzupJson, const QDateTime &whazzupTime);
+
+        QList<Frame> frames();
+        QList<QDateTime> timestamps();
+        // the snapshot taken at time or the last one before, empty if there is none
+        QByteArray whazzupJson(const QDateTime &time);
+        // the last frame of chain, which has to start with a keyframe (see WhazzupIndex)
+        QByteArray whazzupJson(const QList<Frame> &chain);
+        WhazzupData whazzupData(const QDateTime &time);
+
+        // one client record, split into its columns
+        struct Record {
+            quint16 present; // bit k: numberKeys[k] is in numbers
+            QVector<quint64> numbers;
+            QVector<QByteArray> values; // valueKeys as compact JSON [value], empty if missing
+            QByteArray rest; // everything else, compact JSON object
+        };
+        // what the next frame is encoded against: the records of the previous one
+        struct Base {
+            QHash<QString, Record> records; // by section/callsign
+            QByteArray rootRest;
+            bool isEmpty() const { return records.isEmpty() && rootRest.isEmpty(); }
+        };
+    private:
+        bool readFrames();
+        // the JSON is only built if root is given
+        bool decodeFrame(QFile &file, const Frame &frame, Base &base, QJsonObject *root);
+
+        QString _fileName;
+        bool _framesRead;
+        qint64 _validSize; // file size up to the end of the last complete frame
+        QList<Frame> _frames;
+        Base _writeBase; // empty until this instance wrote a frame
+        int _framesSinceKeyframe;
+};
+
+#endif /*WHAZZUPARCHIVE_H_*/
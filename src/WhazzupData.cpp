@@ -8,44 +8,120 @@
 #include "Pilot.h"
 #include "Controller.h"
 #include "BookedController.h"
+#include "ClientRecords.h"
 #include "NavData.h"
+#include "Geodesic.h"
 #include "Settings.h"
+#include "JsonStreamReader.h"
 
 WhazzupData::WhazzupData() :
     servers(QList<QStringList>()),
     updateEarliest(QDateTime()), whazzupTime(QDateTime()), bookingsTime(QDateTime()),
-    _dataType(UNIFIED)
+    _dataType(UNIFIED),
+    _navLookups(0),
+    _clients(new ClientStore)
 {
+    startDelta(true);
 }
 
-WhazzupData::WhazzupData(QByteArray* bytes, WhazzupType type) :
+// this is used from WhazzupDecoder's thread pool: no GUI, no Settings and
+// no NavData in here, the clients are resolved with navLookups
+WhazzupData::WhazzupData(QByteArray* bytes, WhazzupType type, int reloadInMin,
+                         QSharedPointer<const ClientRecords> previousRecords, const NavLookups *navLookups) :
     servers(QList<QStringList>()),
     updateEarliest(QDateTime()), whazzupTime(QDateTime()),
-    bookingsTime(QDateTime())
+    bookingsTime(QDateTime()),
+    _navLookups(navLookups),
+    _clients(new ClientStore)
 {
     qDebug() << "WhazzupData::WhazzupData(buffer)" << type << "[NONE, WHAZZUP, ATCBOOKINGS, UNIFIED]";
-    qApp->setOverrideCursor(QCursor(Qt::WaitCursor));
     _dataType = type;
-    int reloadInMin = Settings::downloadInterval();
-    QJsonDocument data = QJsonDocument::fromJson(*bytes);
-    if (data.isNull()) {
-        qDebug() << "Couldn't parse JSON";
-    } else if (type == WHAZZUP) {
-        QJsonObject json = data.object();
-        if (json.contains("general") && json["general"].isObject()) {
-            QJsonObject generalObject = json["general"].toObject();
+    startDelta(true);
+
+    JsonStreamReader json(*bytes);
+    if (type == WHAZZUP) {
+        parseWhazzup(json, previousRecords.data());
+    } else if (type == ATCBOOKINGS) {
+        parseBookings(json);
+    } else {
+        json.readNext();
+        json.skipCurrentValue();
+        json.readNext();
+    }
+
+    if (json.hasError()) {
+        qDebug() << "Couldn't parse JSON:" << json.errorString() << "at offset" << json.offset();
+        _records.clear();
+        clearClients();
+        whazzupTime = QDateTime();
+        bookingsTime = QDateTime();
+        servers.clear();
+    } else if (type != WHAZZUP && type != ATCBOOKINGS) {
+        // Try again in 15 seconds
+        updateEarliest = QDateTime::currentDateTime().addSecs(15);
+    }
+
+    if (!_records.isNull()) {
+        qDebug() << "WhazzupData::WhazzupData(buffer)" << (previousRecords.isNull()? "no previous records,": "reused")
+                 << _records->summary();
+    }
+
+    // set the earliest time the server will have new data
+    if (whazzupTime.isValid() && reloadInMin > 0) {
+        updateEarliest = whazzupTime.addSecs(reloadInMin * 60).toUTC();
+    }
+    _navLookups = 0;
+    storeClients();
+    qDebug() << "WhazzupData::WhazzupData(buffer) -- finished";
+}
+
+/**
+  Streams a Whazzup v3 JSON document into client records.
+  Client objects are created straight from the token stream, one record at a
+  time. Records that show up before "general" are kept back until the end so
+  that every client sees the final whazzupTime, as with the DOM parser.
+  Records that previousRecords has seen before reuse what was derived from
+  them then.
+**/
+void WhazzupData::parseWhazzup(JsonStreamReader& json, const ClientRecords *previousRecords) {
+    _records = QSharedPointer<ClientRecords>(new ClientRecords);
+    if (json.readNext() != JsonStreamReader::StartObject) {
+        json.skipCurrentValue();
+        if (!json.hasError()) {
+            whazzupTime = QDateTime::currentDateTime();
+        }
+        return;
+    }
+
+    bool generalRead = false;
+    QList<QPair<QString, QJsonObject> > deferred;
+
+    ClientRecords *records = _records.data();
+    auto addClient = [this, records, previousRecords](const QString& section, const QJsonObject& object) {
+        if (section == "pilots") {
+            Pilot* p = records->createPilot(object, false, this, _clients->arena, previousRecords);
+            pilots[p->label] = p;
+        } else if (section == "prefiles") {
+            Pilot* p = records->createPilot(object, true, this, _clients->arena, previousRecords);
+            bookedPilots[p->label] = p;
+        } else { // controllers, atis
+            Controller* c = records->createController(object, this, _clients->arena, previousRecords);
+            controllers[c->label] = c;
+        }
+    };
+
+    while (json.readNext() == JsonStreamReader::Key) {
+        const QString section = json.text();
+        json.readNext();
+        if (section == "general" && json.tokenType() == JsonStreamReader::StartObject) {
+            QJsonObject generalObject = json.currentValue().toObject();
             if (generalObject.contains("update_timestamp") && generalObject["update_timestamp"].isString()) {
                 whazzupTime = QDateTime::fromString(generalObject["update_timestamp"].toString(), Qt::ISODate);
             }
-        }
-        if (!whazzupTime.isValid()) {
-            // Assume it's the current time
-            whazzupTime = QDateTime::currentDateTime();
-        }
-        if (json.contains("servers") && json["servers"].isArray()) {
-            QJsonArray serversArray = json["servers"].toArray();
-            for (int i = 0; i < serversArray.size(); ++i)  {
-                QJsonObject serverObject = serversArray[i].toObject();
+            generalRead = true;
+        } else if (section == "servers" && json.tokenType() == JsonStreamReader::StartArray) {
+            while (json.readNext() != JsonStreamReader::EndArray && !json.hasError()) {
+                QJsonObject serverObject = json.currentValue().toObject();
                 if (
                     serverObject.contains("ident") && serverObject["ident"].isString()
                     && serverObject.contains("hostname_or_ip") && serverObject["hostname_or_ip"].isString()
@@ -62,60 +138,71 @@ WhazzupData::WhazzupData(QByteArray* bytes, WhazzupType type) :
                     servers += server;
                 }
             }
-        }
-        if (json.contains("pilots") && json["pilots"].isArray()) {
-            QJsonArray pilotsArray = json["pilots"].toArray();
-            for (int i = 0; i < pilotsArray.size(); ++i) {
-                QJsonObject pilotObject = pilotsArray[i].toObject();
-                Pilot* p = new Pilot(pilotObject, this);
-                pilots[p->label] = p;
+        } else if (
+            (section == "pilots" || section == "controllers" || section == "atis" || section == "prefiles")
+            && json.tokenType() == JsonStreamReader::StartArray
+        ) {
+            if (generalRead && !whazzupTime.isValid()) {
+                // Assume it's the current time
+                whazzupTime = QDateTime::currentDateTime();
             }
-        }
-
-        if (json.contains("controllers") && json["controllers"].isArray()) {
-            QJsonArray controllersArray = json["controllers"].toArray();
-            for (int i = 0; i < controllersArray.size(); ++i) {
-                QJsonObject controllerObject = controllersArray[i].toObject();
-                Controller* c = new Controller(controllerObject, this);
-                controllers[c->label] = c;
+            while (json.readNext() != JsonStreamReader::EndArray && !json.hasError()) {
+                const QJsonObject object = json.currentValue().toObject();
+                if (json.hasError()) {
+                    break;
+                }
+                if (generalRead) {
+                    addClient(section, object);
+                } else {
+                    deferred.append(qMakePair(section, object));
+                }
             }
+        } else {
+            json.skipCurrentValue();
         }
+    }
 
-        if (json.contains("atis") && json["atis"].isArray()) {
-            QJsonArray atisArray = json["atis"].toArray();
-            for (int i = 0; i < atisArray.size(); ++i) {
-                QJsonObject atisObject = atisArray[i].toObject();
-                Controller* c = new Controller(atisObject, this);
-                controllers[c->label] = c;
+    if (json.tokenType() == JsonStreamReader::EndObject) {
+        json.readNext(); // EndDocument or an error on trailing garbage
+    }
+    if (json.hasError()) {
+        return;
+    }
+
+    if (!whazzupTime.isValid()) {
+        // Assume it's the current time
+        whazzupTime = QDateTime::currentDateTime();
+    }
+
+    // keep the same section order as the DOM parser had for clashing callsigns
+    foreach (const QString section, QStringList({ "pilots", "controllers", "atis", "prefiles" })) {
+        for (int i = 0; i < deferred.size(); i++) {
+            if (deferred[i].first == section) {
+                addClient(section, deferred[i].second);
             }
         }
+    }
+}
 
-        if (json.contains("prefiles") && json["prefiles"].isArray()) {
-            QJsonArray prefilesArray = json["prefiles"].toArray();
-            for (int i = 0; i < prefilesArray.size(); ++i) {
-                QJsonObject prefileObject = prefilesArray[i].toObject();
-                Pilot* p = new Pilot(prefileObject, this);
-                bookedPilots[p->label] = p;
+void WhazzupData::parseBookings(JsonStreamReader& json) {
+    if (json.readNext() == JsonStreamReader::StartArray) {
+        while (json.readNext() != JsonStreamReader::EndArray && !json.hasError()) {
+            QJsonObject bookedControllerJson = json.currentValue().toObject();
+            if (json.hasError()) {
+                break;
             }
-        }
-    } else if (type == ATCBOOKINGS) {
-        QJsonArray json = data.array();
-        for (int i = 0; i < json.size(); ++i) {
-            QJsonObject bookedControllerJson = json[i].toObject();
-            BookedController* bc = new BookedController(bookedControllerJson, this);
+            BookedController* bc = _clients->arena.create<BookedController>(bookedControllerJson, this);
             bookedControllers.append(bc);
         }
-        bookingsTime = QDateTime::currentDateTime();
+        json.readNext();
     } else {
-        // Try again in 15 seconds
-        updateEarliest = QDateTime::currentDateTime().addSecs(15);
+        json.skipCurrentValue();
+        json.readNext();
     }
-    // set the earliest time the server will have new data
-    if (whazzupTime.isValid() && reloadInMin > 0) {
-        updateEarliest = whazzupTime.addSecs(reloadInMin * 60).toUTC();
+    if (json.hasError()) {
+        return;
     }
-    qApp->restoreOverrideCursor();
-    qDebug() << "WhazzupData::WhazzupData(buffer) -- finished";
+    bookingsTime = QDateTime::currentDateTime();
 }
 
 //faking WhazzupData based on valid data and a predictTime
@@ -123,8 +210,11 @@ WhazzupData::WhazzupData(const QDateTime predictTime, const WhazzupData &data) :
     servers(QList<QStringList>()),
     updateEarliest(QDateTime()), whazzupTime(QDateTime()),
     bookingsTime(QDateTime()), predictionBasedOnTime(QDateTime()),
-    predictionBasedOnBookingsTime(QDateTime()) {
+    predictionBasedOnBookingsTime(QDateTime()),
+    _navLookups(0),
+    _clients(new ClientStore) {
     qApp->setOverrideCursor(QCursor(Qt::WaitCursor));
+    startDelta(true);
     qDebug() << "WhazzupData::WhazzupData(predictTime)" << predictTime;
 
     whazzupTime = predictTime;
@@ -161,7 +251,7 @@ WhazzupData::WhazzupData(const QDateTime predictTime, const WhazzupData &data) :
             //visualRange = getField(stringList, 19).toInt();
             controllerObject["visual_range"] = 0;
 
-            controllers[bc->label] = new Controller(controllerObject, this);
+            controllers[bc->label] = _clients->arena.create<Controller>(controllerObject, this);
         }
     }
 
@@ -179,7 +269,7 @@ WhazzupData::WhazzupData(const QDateTime predictTime, const WhazzupData &data) :
         }
 
         if (predictTime <= showUntil && predictTime >= predictionBasedOnTime) {
-            controllers[c->label] = new Controller(*c);
+            controllers[c->label] = _clients->arena.create<Controller>(*c);
         }
     }
 
@@ -202,8 +292,9 @@ WhazzupData::WhazzupData(const QDateTime predictTime, const WhazzupData &data) :
         if (p->etd() > predictTime || p->eta() < predictTime) {
             if (p->flightStatus() == Pilot::PREFILED && p->etd() > predictTime) { // we want prefiled before their
                 //departure as in non-Warped view
-                Pilot* np = new Pilot(*p);
+                Pilot* np = _clients->arena.create<Pilot>(*p);
                 np->whazzupTime = QDateTime(predictTime);
+                np->derive();
                 bookedPilots[np->label] = np; // just copy him over
                 continue;
             }
@@ -239,56 +330,146 @@ WhazzupData::WhazzupData(const QDateTime predictTime, const WhazzupData &data) :
         // position
         double fraction = (double) startTime.secsTo(predictTime)
          / startTime.secsTo(endTime);
-        QPair<double, double> pos = NavData::greatCircleFraction(
-            startLat, startLon,
-            endLat, endLon, fraction
-        );
+        const Geodesic::Vector start = Geodesic::vector(startLat, startLon), end = Geodesic::vector(endLat, endLon);
+        const Geodesic::Vector pos = Geodesic::fraction(start, end, fraction);
 
-        double dist = NavData::distance(startLat, startLon, endLat, endLon);
+        double dist = Geodesic::distance(start, end);
         double enrouteHrs = ((double) startTime.secsTo(endTime)) / 3600.0;
         if (qFuzzyIsNull(enrouteHrs)) { enrouteHrs = 0.1; }
         double groundspeed = dist / enrouteHrs;
-        double trueHeading = NavData::courseTo(pos.first, pos.second, endLat, endLon);
+        double trueHeading = Geodesic::course(pos, end);
 
         // create Pilot instance and assign values
-        Pilot* np = new Pilot(*p);
+        Pilot* np = _clients->arena.create<Pilot>(*p);
         np->whazzupTime = QDateTime(predictTime);
-        np->lat = pos.first;
-        np->lon = pos.second;
+        np->lat = Geodesic::lat(pos);
+        np->lon = Geodesic::lon(pos);
         np->altitude = altitude;
         np->trueHeading = trueHeading;
         np->groundspeed = (int) groundspeed;
+        np->derive();
 
         pilots[np->label] = np;
     }
+    storeClients();
     qApp->restoreOverrideCursor();
     qDebug() << "WhazzupData::WhazzupData(predictTime) -- finished";
 }
 
-WhazzupData::WhazzupData(const WhazzupData &data) {
+WhazzupData::WhazzupData(const WhazzupData &data) :
+    _dataType(data._dataType),
+    _navLookups(0),
+    _clients(new ClientStore)
+{
     assignFrom(data);
 }
 
+const NavLookups &WhazzupData::navLookups() const {
+    return _navLookups != 0? *_navLookups: NavData::instance()->lookups();
+}
+
+void WhazzupData::moveClientsToThread(QThread *thread) {
+    foreach (Pilot *p, pilots) {
+        p->moveToThread(thread);
+    }
+    foreach (Pilot *p, bookedPilots) {
+        p->moveToThread(thread);
+    }
+    foreach (Controller *c, controllers) {
+        c->moveToThread(thread);
+    }
+    foreach (BookedController *bc, bookedControllers) {
+        bc->moveToThread(thread);
+    }
+}
+
 WhazzupData::~WhazzupData() {
-    foreach (const QString s, pilots.keys()) {
-        delete pilots[s];
+    // the clients are deleted with the last reference to _clients
+}
+
+WhazzupData::ClientStore::~ClientStore() {
+    // the memory goes with the arena
+    foreach (const Pilot *p, pilots) {
+        arena.destroy(p);
     }
-    pilots.clear();
+    foreach (const Pilot *p, bookedPilots) {
+        arena.destroy(p);
+    }
+    foreach (const Controller *c, controllers) {
+        arena.destroy(c);
+    }
+    foreach (const BookedController *bc, bookedControllers) {
+        arena.destroy(bc);
+    }
+}
 
-    foreach (const QString s, bookedPilots.keys()) {
-        delete bookedPilots[s];
+void WhazzupData::destroyWhazzupClients() {
+    foreach (const Pilot *p, _clients->pilots) {
+        _clients->arena.destroy(p);
+    }
+    foreach (const Pilot *p, _clients->bookedPilots) {
+        _clients->arena.destroy(p);
+    }
+    foreach (const Controller *c, _clients->controllers) {
+        _clients->arena.destroy(c);
+    }
+}
+
+void WhazzupData::destroyBookedControllers() {
+    foreach (const BookedController *bc, _clients->bookedControllers) {
+        _clients->arena.destroy(bc);
+    }
+}
+
+// hands the clients over to the store. Only valid if it is not shared.
+void WhazzupData::storeClients() {
+    Q_ASSERT(isDetached());
+    pilotTable.rebuild(pilots);
+    _clients->pilots = pilots;
+    _clients->bookedPilots = bookedPilots;
+    _clients->controllers = controllers;
+    _clients->bookedControllers = bookedControllers;
+}
+
+void WhazzupData::clearClients() {
+    if (isDetached()) {
+        storeClients(); // whatever has been created so far is deleted with the store
     }
+    pilots.clear();
     bookedPilots.clear();
+    controllers.clear();
+    bookedControllers.clear();
+    pilotTable.clear();
+    _clients = new ClientStore;
+}
 
+void WhazzupData::copyWhazzupClients() {
+    foreach (const QString s, pilots.keys()) {
+        pilots[s] = _clients->arena.create<Pilot>(*pilots[s]);
+    }
+    foreach (const QString s, bookedPilots.keys()) {
+        bookedPilots[s] = _clients->arena.create<Pilot>(*bookedPilots[s]);
+    }
     foreach (const QString s, controllers.keys()) {
-        delete controllers[s];
+        controllers[s] = _clients->arena.create<Controller>(*controllers[s]);
     }
-    controllers.clear();
+}
 
-    foreach (const BookedController* bc, bookedControllers) {
-        delete bc;
+void WhazzupData::copyBookedControllers() {
+    for (int i = 0; i < bookedControllers.size(); i++) {
+        bookedControllers[i] = _clients->arena.create<BookedController>(*bookedControllers[i]);
     }
-    bookedControllers.clear();
+}
+
+void WhazzupData::detach() {
+    if (isDetached()) {
+        return;
+    }
+    qDebug() << "WhazzupData::detach()";
+    _clients = new ClientStore;
+    copyWhazzupClients();
+    copyBookedControllers();
+    storeClients();
 }
 
 WhazzupData &WhazzupData::operator=(const WhazzupData &data) {
@@ -301,59 +482,120 @@ void WhazzupData::assignFrom(const WhazzupData &data) {
     if (this == &data) {
         return;
     }
+    startDelta(true);
+
+    const bool assignsWhazzup = data._dataType == WHAZZUP || data._dataType == UNIFIED;
+    const bool assignsBookings = data._dataType == ATCBOOKINGS || data._dataType == UNIFIED;
+    // we can only share the clients with data if we do not keep some of our own
+    const bool keepsClients =
+            (!assignsWhazzup && !(pilots.isEmpty() && bookedPilots.isEmpty() && controllers.isEmpty()))
+            || (!assignsBookings && !bookedControllers.isEmpty());
+    if (keepsClients) {
+        detach();
+    }
 
-    if (data._dataType == WHAZZUP || data._dataType == UNIFIED) {
+    if (assignsWhazzup) {
         if (_dataType == ATCBOOKINGS) { _dataType = UNIFIED; }
         servers = data.servers;
         whazzupTime = data.whazzupTime;
         predictionBasedOnTime = data.predictionBasedOnTime;
         updateEarliest = data.updateEarliest;
 
-        pilots.clear();
-        foreach (const QString s, data.pilots.keys()) {
-            pilots[s] = new Pilot(*data.pilots[s]);
-        }
-
-        bookedPilots.clear();
-        foreach (const QString s, data.bookedPilots.keys()) {
-            bookedPilots[s] = new Pilot(*data.bookedPilots[s]);
-        }
-
-        controllers.clear();
-        foreach (const QString s, data.controllers.keys()) {
-            controllers[s] = new Controller(*data.controllers[s]);
+        pilots = data.pilots;
+        bookedPilots = data.bookedPilots;
+        controllers = data.controllers;
+        pilotTable = data.pilotTable; // rebuilt by storeClients() if we copy
+        if (keepsClients) {
+            destroyWhazzupClients();
+            copyWhazzupClients();
         }
     }
-    if (data._dataType == ATCBOOKINGS || data._dataType == UNIFIED) {
+    if (assignsBookings) {
         if (_dataType == WHAZZUP) { _dataType = UNIFIED; }
 
-        bookedControllers.clear();
-        foreach (const BookedController* bc, data.bookedControllers) {
-            bookedControllers.append(new BookedController(*bc));
+        bookedControllers = data.bookedControllers;
+        if (keepsClients) {
+            destroyBookedControllers();
+            copyBookedControllers();
         }
 
         bookingsTime = QDateTime(data.bookingsTime);
         predictionBasedOnBookingsTime = QDateTime(data.predictionBasedOnBookingsTime);
     }
+
+    if (keepsClients) {
+        storeClients();
+    } else {
+        _clients = data._clients; // O(1), our previous clients go with the old store
+    }
     qDebug() << "WhazzupData::assignFrom() -- finished";
 }
 
-void WhazzupData::updatePilotsFrom(const WhazzupData &data) {
+void WhazzupData::startDelta(bool full) {
+    static QAtomicInt lastGeneration; // unique over all instances, some are created on the decoder threads
+    const int baseGeneration = _delta.generation;
+    _delta = Delta();
+    _delta.full = full;
+    _delta.baseGeneration = baseGeneration;
+    _delta.generation = lastGeneration.fetchAndAddOrdered(1) + 1;
+    _delta.bookedControllersChanged = full;
+}
+
+static bool sameFlightplan(const Pilot *a, const Pilot *b) {
+    return a->planDep == b->planDep && a->planDest == b->planDest
+            && a->planAltAirport == b->planAltAirport && a->planRoute == b->planRoute
+            && a->planAlt == b->planAlt && a->planRevision == b->planRevision
+            && a->planAircraft == b->planAircraft && a->planAircraftFull == b->planAircraftFull
+            && a->planFlighttype == b->planFlighttype && a->planTAS == b->planTAS
+            && a->planDeptime == b->planDeptime && a->planActtime == b->planActtime
+            && a->planRemarks == b->planRemarks
+            && a->planEnroute_hrs == b->planEnroute_hrs && a->planEnroute_mins == b->planEnroute_mins
+            && a->planFuel_hrs == b->planFuel_hrs && a->planFuel_mins == b->planFuel_mins
+            && a->transponderAssigned == b->transponderAssigned;
+}
+
+static bool sameLiveData(const Pilot *a, const Pilot *b) {
+    return a->lat == b->lat && a->lon == b->lon
+            && a->altitude == b->altitude && a->groundspeed == b->groundspeed
+            && a->trueHeading == b->trueHeading && a->transponder == b->transponder
+            && a->qnh_mb == b->qnh_mb && a->server == b->server && a->rating == b->rating
+            && a->timeConnected == b->timeConnected;
+}
+
+static bool sameController(const Controller *a, const Controller *b) {
+    return a->frequency == b->frequency && a->facilityType == b->facilityType
+            && a->visualRange == b->visualRange && a->atisCode == b->atisCode
+            && a->atisMessage == b->atisMessage && a->lat == b->lat && a->lon == b->lon
+            && a->server == b->server && a->rating == b->rating
+            && a->timeConnected == b->timeConnected && a->assumeOnlineUntil == b->assumeOnlineUntil;
+}
+
+void WhazzupData::updatePilotsFrom(const WhazzupData &data, bool ownsClients) {
     qDebug() << "WhazzupData::updatePilotsFrom()";
     foreach (const QString s, pilots.keys()) { // remove pilots that are no longer there
         if (!data.pilots.contains(s)) {
-            foreach (const Pilot* p, pilots.values(s)) { // there might be several...
-                delete p;
+            if (ownsClients) {
+                foreach (const Pilot* p, pilots.values(s)) { // there might be several...
+                    _clients->arena.destroy(p);
+                }
             }
             pilots.remove(s);
+            _delta.removedPilots.insert(s);
         }
     }
     foreach (const QString s, data.pilots.keys()) {
         if (!pilots.contains(s)) { // new pilots
             // create a new copy of new pilot
-            Pilot* p = new Pilot(*data.pilots[s]);
+            Pilot* p = _clients->arena.create<Pilot>(*data.pilots[s]);
             pilots[s] = p;
+            _delta.addedPilots.insert(s);
         } else { // existing pilots: data saved in the object needs to be transferred
+            if (!sameFlightplan(pilots[s], data.pilots[s])) {
+                _delta.flightplanChangedPilots.insert(s);
+            } else if (!sameLiveData(pilots[s], data.pilots[s])) {
+                _delta.movedPilots.insert(s);
+            }
+
             data.pilots[s]->showDepDestLine = pilots[s]->showDepDestLine;
             data.pilots[s]->routeWaypointsCache = pilots[s]->routeWaypointsCache;
             data.pilots[s]->routeWaypointsPlanDepCache = pilots[s]->routeWaypointsPlanDepCache;
@@ -361,56 +603,89 @@ void WhazzupData::updatePilotsFrom(const WhazzupData &data) {
             data.pilots[s]->routeWaypointsPlanRouteCache = pilots[s]->routeWaypointsPlanRouteCache;
             data.pilots[s]->checkStatus();
 
-            *pilots[s] = *data.pilots[s];
+            if (ownsClients) {
+                *pilots[s] = *data.pilots[s];
+            } else {
+                pilots[s] = _clients->arena.create<Pilot>(*data.pilots[s]);
+            }
         }
     }
 
     foreach (const QString s, bookedPilots.keys()) { // remove pilots that are no longer there
         if (!data.bookedPilots.contains(s)) {
-            foreach (const Pilot* p, bookedPilots.values(s)) { // there might be several...
-                delete p;
+            if (ownsClients) {
+                foreach (const Pilot* p, bookedPilots.values(s)) { // there might be several...
+                    _clients->arena.destroy(p);
+                }
             }
             bookedPilots.remove(s);
+            _delta.removedBookedPilots.insert(s);
         }
     }
     foreach (const QString s, data.bookedPilots.keys()) {
         if (!bookedPilots.contains(s)) { // new pilots
-            Pilot* p = new Pilot(*data.bookedPilots[s]);
+            Pilot* p = _clients->arena.create<Pilot>(*data.bookedPilots[s]);
             bookedPilots[s] = p;
+            _delta.addedBookedPilots.insert(s);
         } else { // existing pilots
-            *bookedPilots[s] = *data.bookedPilots[s];
+            if (!sameFlightplan(bookedPilots[s], data.bookedPilots[s])
+                    || !sameLiveData(bookedPilots[s], data.bookedPilots[s])) {
+                _delta.changedBookedPilots.insert(s);
+            }
+            if (ownsClients) {
+                *bookedPilots[s] = *data.bookedPilots[s];
+            } else {
+                bookedPilots[s] = _clients->arena.create<Pilot>(*data.bookedPilots[s]);
+            }
         }
     }
     qDebug() << "WhazzupData::updatePilotsFrom() -- finished";
 }
 
-void WhazzupData::updateControllersFrom(const WhazzupData &data) {
+void WhazzupData::updateControllersFrom(const WhazzupData &data, bool ownsClients) {
     qDebug() << "WhazzupData::updateControllersFrom()";
     foreach (const QString s, controllers.keys()) {
         if (!data.controllers.contains(s)) {
             // remove controllers that are no longer there
-            delete controllers[s];
+            if (ownsClients) {
+                _clients->arena.destroy(controllers[s]);
+            }
             controllers.remove(s);
+            _delta.removedControllers.insert(s);
         }
     }
     foreach (const QString s, data.controllers.keys()) {
         if (!controllers.contains(s)) {
             // create a new copy of new controllers
-            Controller* c = new Controller(*data.controllers[s]);
+            Controller* c = _clients->arena.create<Controller>(*data.controllers[s]);
             controllers[c->label] = c;
+            _delta.addedControllers.insert(s);
         } else { // controller already exists, assign values from data
-            *controllers[s] = *data.controllers[s];
+            if (!sameController(controllers[s], data.controllers[s])) {
+                _delta.changedControllers.insert(s);
+            }
+            if (ownsClients) {
+                *controllers[s] = *data.controllers[s];
+            } else {
+                controllers[s] = _clients->arena.create<Controller>(*data.controllers[s]);
+            }
         }
     }
     qDebug() << "WhazzupData::updateControllersFrom() -- finished";
 }
 
-void WhazzupData::updateBookedControllersFrom(const WhazzupData &data) {
+void WhazzupData::updateBookedControllersFrom(const WhazzupData &data, bool ownsClients) {
     qDebug() << "WhazzupData::updateBookedControllersFrom()";
+    if (ownsClients) {
+        foreach (const BookedController *bc, bookedControllers) {
+            _clients->arena.destroy(bc);
+        }
+    }
     bookedControllers.clear();
     foreach (const BookedController* bc, data.bookedControllers) {
-        bookedControllers.append(new BookedController(*bc));
+        bookedControllers.append(_clients->arena.create<BookedController>(*bc));
     }
+    _delta.bookedControllersChanged = true;
     qDebug() << "WhazzupData::updateBookedControllersFrom() -- finished";
 }
 
@@ -424,27 +699,52 @@ void WhazzupData::updateFrom(const WhazzupData &data) {
         return;
     }
 
-    if (data._dataType == WHAZZUP || data._dataType == UNIFIED) {
+    startDelta(false);
+    const bool updatesWhazzup = data._dataType == WHAZZUP || data._dataType == UNIFIED;
+    const bool updatesBookings = data._dataType == ATCBOOKINGS || data._dataType == UNIFIED;
+
+    // If the clients are shared with another copy, they are left alone: the
+    // parts that are updated get rebuilt from data, the rest is copied.
+    const bool ownsClients = isDetached();
+    if (!ownsClients) {
+        _clients = new ClientStore;
+        if (!updatesWhazzup) {
+            copyWhazzupClients();
+        }
+        if (!updatesBookings) {
+            copyBookedControllers();
+        }
+    }
+
+    if (updatesWhazzup) {
         if (_dataType == ATCBOOKINGS) {
             _dataType = UNIFIED;
         }
-        updatePilotsFrom(data);
-        updateControllersFrom(data);
+        updatePilotsFrom(data, ownsClients);
+        updateControllersFrom(data, ownsClients);
 
         servers = data.servers;
         whazzupTime = data.whazzupTime;
         updateEarliest = data.updateEarliest;
         predictionBasedOnTime = data.predictionBasedOnTime;
     }
-    if (data._dataType == ATCBOOKINGS || data._dataType == UNIFIED) {
+    if (updatesBookings) {
         if (_dataType == WHAZZUP) {
             _dataType = UNIFIED;
         }
-        updateBookedControllersFrom(data);
+        updateBookedControllersFrom(data, ownsClients);
         bookingsTime = data.bookingsTime;
         predictionBasedOnBookingsTime = data.predictionBasedOnBookingsTime;
     }
-    qDebug() << "WhazzupData::updateFrom() -- finished";
+    storeClients();
+    if (!ownsClients) {
+        _delta.full = true; // all client objects are new
+    }
+    qDebug() << "WhazzupData::updateFrom() -- finished: pilots"
+             << _delta.addedPilots.size() << "added," << _delta.removedPilots.size() << "removed,"
+             << _delta.movedPilots.size() << "moved," << _delta.flightplanChangedPilots.size() << "flightplan changed;"
+             << "controllers" << _delta.addedControllers.size() << "added,"
+             << _delta.removedControllers.size() << "removed," << _delta.changedControllers.size() << "changed";
 }
 
 QSet<Controller*> WhazzupData::controllersWithSectors() const {
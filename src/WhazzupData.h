@@ -6,31 +6,86 @@
 #define WHAZZUPDATA_H_
 
 #include "MapObjectVisitor.h"
+#include "ClientArena.h"
+#include "PilotTable.h"
 
 class Pilot;
 class Controller;
 class BookedController;
 class Client;
+class ClientRecords;
+class JsonStreamReader;
+class NavLookups;
 
 class WhazzupData {
     public:
         enum WhazzupType { NONE, WHAZZUP, ATCBOOKINGS, UNIFIED };
 
+        /**
+          What changed with the last updateFrom(), by callsign.
+          Every change of the client lists gets a new, process-wide unique
+          generation. A consumer that remembers the generation it last
+          synchronized with can apply the delta if it follows directly on
+          that (see followsGeneration()), otherwise it has to rebuild.
+        **/
+        struct Delta {
+            Delta() : full(true), generation(0), baseGeneration(0), bookedControllersChanged(true) {}
+
+            // everything has to be considered changed (initial data, assignment)
+            bool full;
+            int generation, baseGeneration;
+
+            QSet<QString> addedPilots, removedPilots,
+                movedPilots, // position and other live data changed, same flightplan
+                flightplanChangedPilots;
+            QSet<QString> addedBookedPilots, removedBookedPilots, changedBookedPilots;
+            QSet<QString> addedControllers, removedControllers, changedControllers;
+            bool bookedControllersChanged;
+
+            bool followsGeneration(int generation) const {
+                return !full && baseGeneration == generation;
+            }
+            bool hasPilotListChanges() const {
+                return full || !addedPilots.isEmpty() || !removedPilots.isEmpty();
+            }
+            bool hasControllerChanges() const {
+                return full || !addedControllers.isEmpty() || !removedControllers.isEmpty()
+                        || !changedControllers.isEmpty();
+            }
+        };
+
         WhazzupData();
-        WhazzupData(QByteArray *bytes, WhazzupType type);
+        // previousRecords: of the last snapshot, to reuse what its clients derived (see ClientRecords)
+        // navLookups: what the clients are resolved with, NavData's own if 0 (GUI thread only then)
+        WhazzupData(QByteArray *bytes, WhazzupType type, int reloadInMin,
+                    QSharedPointer<const ClientRecords> previousRecords = QSharedPointer<const ClientRecords>(),
+                    const NavLookups *navLookups = 0);
         WhazzupData(const QDateTime predictTime, const WhazzupData &data); // predict whazzup data
         ~WhazzupData();
-        // copy constructor and assignment operator
+        // copies share the client objects until one of them is updated (copy-on-write)
         WhazzupData(const WhazzupData &data);
         WhazzupData &operator=(const WhazzupData &data);
+        // deep copies the client objects if they are shared with another copy
+        void detach();
+        bool isDetached() const { return _clients->ref.loadRelaxed() == 1; }
 
         bool isNull() const { return (whazzupTime.isNull() && bookingsTime.isNull()); }
         void updateFrom(const WhazzupData &data);
+        const Delta &lastDelta() const { return _delta; }
+        int generation() const { return _delta.generation; }
+        // what the clients were built from; only parsed WHAZZUP data has them
+        QSharedPointer<const ClientRecords> records() const { return _records; }
+        // what clients are built with: the lookups given for parsing while parsing, NavData's otherwise
+        const NavLookups &navLookups() const;
+        // the clients are QObjects of the thread that parsed them; for handing them over to another one
+        void moveClientsToThread(QThread *thread);
 
         QSet<Controller*> controllersWithSectors() const;
         QHash<QString, Pilot*> pilots, bookedPilots;
         QHash<QString, Controller*> controllers;
         QList<Pilot*> allPilots() const { return bookedPilots.values() + pilots.values(); }
+        // positions of the pilots (not bookedPilots) for linear scans, in sync with pilots
+        PilotTable pilotTable;
         QList<BookedController*> bookedControllers;
 
         QList<QPair<double, double> > friendsLatLon() const;
@@ -51,12 +106,38 @@ class WhazzupData {
 
         void accept(MapObjectVisitor *visitor) const;
     private:
+        void parseWhazzup(JsonStreamReader &json, const ClientRecords *previousRecords);
+        void parseBookings(JsonStreamReader &json);
+        void clearClients();
         void assignFrom(const WhazzupData &data);
-        void updatePilotsFrom(const WhazzupData &data);
-        void updateControllersFrom(const WhazzupData &data);
-        void updateBookedControllersFrom(const WhazzupData &data);
+        void updatePilotsFrom(const WhazzupData &data, bool ownsClients);
+        void updateControllersFrom(const WhazzupData &data, bool ownsClients);
+        void updateBookedControllersFrom(const WhazzupData &data, bool ownsClients);
+        void copyWhazzupClients();
+        void copyBookedControllers();
+        void destroyWhazzupClients();
+        void destroyBookedControllers();
+        void startDelta(bool full);
         int _whazzupVersion;
         WhazzupType _dataType;
+        Delta _delta;
+        QSharedPointer<ClientRecords> _records;
+        const NavLookups *_navLookups; // while parsing
+
+        // Owns the client objects, which live in its arena. Copies of a
+        // WhazzupData share it and the last one to let go deletes the clients.
+        // The public hashes and lists are what counts; they are handed over
+        // with storeClients() whenever this instance has changed them.
+        class ClientStore : public QSharedData {
+            public:
+                ~ClientStore();
+                QHash<QString, Pilot*> pilots, bookedPilots;
+                QHash<QString, Controller*> controllers;
+                QList<BookedController*> bookedControllers;
+                ClientArena arena;
+        };
+        QExplicitlySharedDataPointer<ClientStore> _clients;
+        void storeClients();
 };
 
 #endif /*WHAZZUPDATA_H_*/
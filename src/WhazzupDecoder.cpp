@@ -0,0 +1,141 @@
+/**************************************************************************
+ *  This file is part of QuteScoop. See README for license
+ **************************************************************************/
+
+#include "WhazzupDecoder.h"
+
+#include "NavData.h"
+
+#include <QAbstractEventDispatcher>
+
+/**
+  The clients of a decoded WhazzupData are QObjects of thread, so it is
+  deleted there: right away on that thread, later through its event loop
+  from any other one. The last reference might go on a pool thread, if the
+  queued delivery is done before the pool task returns.
+**/
+static QSharedPointer<WhazzupData> ownedOn(WhazzupData *data, QThread *thread) {
+    return QSharedPointer<WhazzupData>(data, [thread](WhazzupData *d) {
+        QAbstractEventDispatcher *dispatcher = QAbstractEventDispatcher::instance(thread);
+        if (QThread::currentThread() == thread || dispatcher == 0) {
+            delete d;
+        } else {
+            QMetaObject::invokeMethod(dispatcher, [d]() { delete d; }, Qt::QueuedConnection);
+        }
+    });
+}
+
+WhazzupDecoder::WhazzupDecoder(QObject *parent) :
+    QObject(parent),
+    _navDataLoads(0)
+{
+    // leave a core for the GUI thread
+    _pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+    connect(NavData::instance(), &NavData::loaded, this, [this]() {
+        _records.clear();
+        _navDataLoads++;
+    });
+}
+
+WhazzupDecoder::~WhazzupDecoder() {
+    _pool.waitForDone();
+}
+
+WhazzupDecoder::Status WhazzupDecoder::parseStatus(const QByteArray &bytes) {
+    Status status;
+    status.isValid = false;
+
+    QJsonDocument data = QJsonDocument::fromJson(bytes);
+    if (data.isNull()) {
+        return status;
+    }
+    status.isValid = true;
+
+    QJsonObject json = data.object();
+    if(json.contains("data") && json["data"].isObject()) {
+        QJsonObject vatsimDataSources = json["data"].toObject();
+        if(vatsimDataSources.contains("v3") && vatsimDataSources["v3"].isArray()) {
+            QJsonArray v3Urls = vatsimDataSources["v3"].toArray();
+            for(int i = 0; i < v3Urls.size(); ++i) {
+                if(v3Urls[i].isString()) {
+                    status.json3Urls.append(v3Urls[i].toString());
+                }
+            }
+        }
+    }
+
+    if(json.contains("user") && json["user"].isArray()) {
+        QJsonArray userUrls = json["user"].toArray();
+        if (userUrls.first() != QJsonValue::Undefined) {
+            status.user0Url = userUrls.first().toString();
+        }
+    }
+
+    if(json.contains("metar") && json["metar"].isArray()) {
+        QJsonArray metarUrls = json["metar"].toArray();
+        if (metarUrls.first() != QJsonValue::Undefined) {
+            status.metar0Url = metarUrls.first().toString();
+        }
+    }
+    return status;
+}
+
+void WhazzupDecoder::decodeStatus(const QByteArray &bytes) {
+    _pool.start([this, bytes]() {
+        const Status status = parseStatus(bytes);
+        QMetaObject::invokeMethod(this, [this, status]() {
+            emit statusDecoded(status);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void WhazzupDecoder::decodeWhazzup(const QByteArray &bytes, WhazzupData::WhazzupType type, int reloadInMin) {
+    const int serial = ++_queuedSerial[type];
+    qDebug() << "WhazzupDecoder::decodeWhazzup()" << type << "serial" << serial << "-" << bytes.size() << "bytes";
+
+    const QSharedPointer<const ClientRecords> records = type == WhazzupData::WHAZZUP?
+                _records: QSharedPointer<const ClientRecords>();
+    const int navDataLoads = _navDataLoads;
+    // NavData is refilled on this thread by load(), the pool reads a copy
+    const NavLookups lookups = NavData::instance()->lookups();
+    QThread *target = thread();
+    _pool.start([this, bytes, type, reloadInMin, serial, records, navDataLoads, lookups, target]() {
+        QByteArray buffer(bytes);
+        const QSharedPointer<WhazzupData> data = ownedOn(
+                    new WhazzupData(&buffer, type, reloadInMin, records, &lookups), target);
+        data->moveClientsToThread(target);
+        // freed with the call if it is dropped (decoder destroyed while decoding)
+        QMetaObject::invokeMethod(this, [this, type, serial, data, bytes, reloadInMin, navDataLoads]() {
+            deliver(type, serial, data, bytes, reloadInMin, navDataLoads);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void WhazzupDecoder::deliver(WhazzupData::WhazzupType type, int serial, QSharedPointer<WhazzupData> data,
+                             const QByteArray &bytes, int reloadInMin, int navDataLoads) {
+    if (serial < _deliveredSerial.value(type, 0)) {
+        qDebug() << "WhazzupDecoder::deliver() dropping outdated result" << type << "serial" << serial;
+        return;
+    }
+    // its clients point to airports, sectors and airlines of the last NavData
+    if (type == WhazzupData::WHAZZUP && navDataLoads != _navDataLoads) {
+        if (serial == _queuedSerial.value(type, 0)) {
+            qDebug() << "WhazzupDecoder::deliver() decoding again after NavData::load()" << type << "serial" << serial;
+            decodeWhazzup(bytes, type, reloadInMin);
+        } else {
+            qDebug() << "WhazzupDecoder::deliver() dropping result from before NavData::load()" << type
+                     << "serial" << serial;
+        }
+        return;
+    }
+    _deliveredSerial[type] = serial;
+    if (!data->records().isNull()) {
+        _records = data->records();
+    }
+
+    if (type == WhazzupData::ATCBOOKINGS) {
+        emit bookingsDecoded(data, bytes);
+    } else {
+        emit whazzupDecoded(data, bytes);
+    }
+}
@@ -0,0 +1,58 @@
+/**************************************************************************
+ *  This file is part of QuteScoop. See README for license
+ **************************************************************************/
+
+#ifndef WHAZZUPDECODER_H_
+#define WHAZZUPDECODER_H_
+
+#include "WhazzupData.h"
+
+#include <QThreadPool>
+
+/**
+  Decodes downloaded network status, Whazzup and bookings payloads on a
+  thread pool. Results are handed back to the thread the decoder lives in
+  (the GUI thread) through queued calls, so the decoded* signals are always
+  emitted there.
+  If several payloads of the same kind are in flight, results that arrive
+  after a newer one has been delivered are dropped.
+  Clients are resolved with a copy of NavData::lookups() taken when the
+  decode is queued, and handed back to the decoder's thread with the result.
+  Each Whazzup decode gets the ClientRecords of the last delivered one, so
+  unchanged clients reuse what was derived for them. NavData::load() drops
+  them, they point into NavData. For the same reason Whazzup results that
+  were queued before a NavData::load() are not emitted: the latest one is
+  decoded again, older ones are dropped.
+**/
+class WhazzupDecoder : public QObject {
+        Q_OBJECT
+    public:
+        struct Status {
+            bool isValid;
+            QStringList json3Urls;
+            QString user0Url, metar0Url;
+        };
+
+        explicit WhazzupDecoder(QObject *parent = 0);
+        virtual ~WhazzupDecoder();
+
+        static Status parseStatus(const QByteArray &bytes);
+
+        void decodeStatus(const QByteArray &bytes);
+        // the reload interval is passed in as Settings are not to be used from the pool
+        void decodeWhazzup(const QByteArray &bytes, WhazzupData::WhazzupType type, int reloadInMin);
+    signals:
+        void statusDecoded(const WhazzupDecoder::Status &status);
+        void whazzupDecoded(QSharedPointer<WhazzupData> data, const QByteArray &bytes);
+        void bookingsDecoded(QSharedPointer<WhazzupData> data, const QByteArray &bytes);
+    private:
+        void deliver(WhazzupData::WhazzupType type, int serial, QSharedPointer<WhazzupData> data,
+                     const QByteArray &bytes, int reloadInMin, int navDataLoads);
+
+        QThreadPool _pool;
+        QHash<int, int> _queuedSerial, _deliveredSerial;
+        QSharedPointer<const ClientRecords> _records; // of the last delivered Whazzup
+        int _navDataLoads; // Whazzup decodes queued before the last NavData::load() are not delivered
+};
+
+#endif /*WHAZZUPDECODER_H_*/
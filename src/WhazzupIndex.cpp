@@ -0,0 +1,250 @@
+/**************************************************************************
+ *  This file is part of QuteScoop. See README for license
+ **************************************************************************/
+
+#include "WhazzupIndex.h"
+
+#include <algorithm>
+
+static const quint32 indexMagic = 0x51535749; // "QSWI"
+static const quint32 indexVersion = 1;
+
+WhazzupIndex::WhazzupIndex(const QString &directory, int network) :
+    _directory(QDir(directory).absolutePath() + "/"),
+    _network(network),
+    _file(QString("%1%2.whazzupindex").arg(_directory).arg(network)),
+    _map(0),
+    _count(0)
+{
+    qint64 fileBytes;
+    qint32 fileCount;
+    directoryStatus(fileBytes, fileCount);
+    if (map() && header()->magic == indexMagic && header()->version == indexVersion
+            && header()->fileBytes == fileBytes && header()->fileCount == fileCount) {
+        qDebug() << "WhazzupIndex: using" << _file.fileName() << "with" << _count << "snapshots";
+        return;
+    }
+    rebuild();
+}
+
+WhazzupIndex::~WhazzupIndex() {
+    unmap();
+}
+
+bool WhazzupIndex::map() {
+    unmap();
+    if (!_file.isOpen() && !_file.open(QIODevice::ReadWrite)) {
+        return false;
+    }
+    const qint64 size = _file.size();
+    if (size < (qint64) sizeof(Header) || (size - sizeof(Header)) % sizeof(Entry) != 0) {
+        return false;
+    }
+    _map = _file.map(0, size);
+    if (_map == 0) {
+        return false;
+    }
+    _count = (size - sizeof(Header)) / sizeof(Entry);
+    return true;
+}
+
+void WhazzupIndex::unmap() {
+    if (_map != 0) {
+        _file.unmap(_map);
+    }
+    _map = 0;
+    _count = 0;
+}
+
+int WhazzupIndex::size() const {
+    return _count;
+}
+
+QDateTime WhazzupIndex::time(int i) const {
+    return QDateTime::fromMSecsSinceEpoch(entries()[i].msecs, Qt::UTC);
+}
+
+int WhazzupIndex::indexAtOrBefore(const QDateTime &time) const {
+    if (_count == 0) {
+        return -1;
+    }
+    const Entry *begin = entries(), *end = entries() + _count;
+    const Entry *it = std::upper_bound(begin, end, time.toMSecsSinceEpoch(),
+                                       [](qint64 msecs, const Entry &entry) { return msecs < entry.msecs; });
+    return (it - begin) - 1;
+}
+
+int WhazzupIndex::indexAtOrAfter(const QDateTime &time) const {
+    if (_count == 0) {
+        return 0;
+    }
+    const Entry *begin = entries(), *end = entries() + _count;
+    const Entry *it = std::lower_bound(begin, end, time.toMSecsSinceEpoch(),
+                                       [](const Entry &entry, qint64 msecs) { return entry.msecs < msecs; });
+    return it - begin;
+}
+
+QString WhazzupIndex::archiveName(qint64 msecs) const {
+    return QString("%1_%2%3").arg(_network)
+            .arg(QDateTime::fromMSecsSinceEpoch(msecs, Qt::UTC).toString("yyyyMMdd"))
+            .arg(WhazzupArchive::suffix);
+}
+
+QString WhazzupIndex::rawName(qint64 msecs) const {
+    return QString("%1_%2.whazzup").arg(_network)
+            .arg(QDateTime::fromMSecsSinceEpoch(msecs, Qt::UTC).toString("yyyyMMdd-HHmmss"));
+}
+
+QString WhazzupIndex::fileName(int i) const {
+    const Entry &entry = entries()[i];
+    return _directory + ((entry.flags & Raw)? rawName(entry.msecs): archiveName(entry.msecs));
+}
+
+QByteArray WhazzupIndex::whazzupJson(int i) const {
+    if (i < 0 || i >= _count) {
+        return QByteArray();
+    }
+    const Entry &entry = entries()[i];
+    if (entry.flags & Raw) {
+        QFile file(fileName(i));
+        if (!file.open(QIODevice::ReadOnly)) {
+            qWarning() << "WhazzupIndex::whazzupJson() could not open" << file.fileName();
+            return QByteArray();
+        }
+        return file.readAll();
+    }
+
+    // the frames of the same archive back to the last keyframe
+    const QString name = archiveName(entry.msecs);
+    QList<WhazzupArchive::Frame> chain;
+    for (int k = i; k >= 0; k--) {
+        const Entry &e = entries()[k];
+        if (e.flags & Raw) {
+            continue;
+        }
+        if (archiveName(e.msecs) != name) {
+            break;
+        }
+        WhazzupArchive::Frame frame;
+        frame.time = time(k);
+        frame.offset = e.offset;
+        frame.length = e.length;
+        frame.isKeyframe = (e.flags & Keyframe) != 0;
+        chain.prepend(frame);
+        if (frame.isKeyframe) {
+            break;
+        }
+    }
+    return WhazzupArchive(_directory + name).whazzupJson(chain);
+}
+
+void WhazzupIndex::directoryStatus(qint64 &fileBytes, qint32 &fileCount) const {
+    fileBytes = 0;
+    fileCount = 0;
+    const QFileInfoList files = QDir(_directory).entryInfoList(
+                QStringList({ QString("%1_*.whazzup").arg(_network),
+                              QString("%1_*%2").arg(_network).arg(WhazzupArchive::suffix) }),
+                QDir::Files | QDir::Readable);
+    foreach (const QFileInfo &file, files) {
+        fileBytes += file.size();
+        fileCount++;
+    }
+}
+
+void WhazzupIndex::rebuild() {
+    QElapsedTimer timer;
+    timer.start();
+    Header header;
+    header.magic = indexMagic;
+    header.version = indexVersion;
+    header.reserved = 0;
+    directoryStatus(header.fileBytes, header.fileCount);
+
+    QVector<Entry> list;
+    QDir dir(_directory);
+    QRegExp dtRe("_(\\d{8}-\\d{6})\\.whazzup$"); // dateTime: 20110301-191050
+    foreach (const QFileInfo &file, dir.entryInfoList(QStringList(QString("%1_*.whazzup").arg(_network)),
+                                                      QDir::Files | QDir::Readable)) {
+        if (dtRe.indexIn(file.fileName()) < 0) {
+            continue;
+        }
+        QDateTime dt = QDateTime::fromString(dtRe.cap(1), "yyyyMMdd-HHmmss");
+        dt.setTimeSpec(Qt::UTC);
+        Entry entry = { dt.toMSecsSinceEpoch(), 0, (quint32) file.size(), Raw };
+        if (rawName(entry.msecs) == file.fileName()) {
+            list.append(entry);
+        }
+    }
+    foreach (const QFileInfo &file, dir.entryInfoList(
+                 QStringList(QString("%1_*%2").arg(_network).arg(WhazzupArchive::suffix)),
+                 QDir::Files | QDir::Readable)) {
+        foreach (const WhazzupArchive::Frame &frame, WhazzupArchive(file.filePath()).frames()) {
+            Entry entry = { frame.time.toMSecsSinceEpoch(), frame.offset, frame.length,
+                            frame.isKeyframe? (quint32) Keyframe: 0 };
+            // entries find their archive by the day
+            if (archiveName(entry.msecs) == file.fileName()) {
+                list.append(entry);
+            }
+        }
+    }
+    std::stable_sort(list.begin(), list.end(),
+                     [](const Entry &a, const Entry &b) { return a.msecs < b.msecs; });
+
+    write(header, list);
+    qDebug() << "WhazzupIndex::rebuild()" << _file.fileName() << "with" << list.size() << "snapshots in"
+             << timer.elapsed() << "ms";
+}
+
+bool WhazzupIndex::write(const Header &header, const QVector<Entry> &entries) {
+    unmap();
+    _file.close();
+    if (!_file.open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+        qWarning() << "WhazzupIndex::write() could not open" << _file.fileName() << _file.errorString();
+        return false;
+    }
+    _file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    _file.write(reinterpret_cast<const char*>(entries.constData()), entries.size() * sizeof(Entry));
+    if (!_file.flush()) {
+        qWarning() << "WhazzupIndex::write() could not write" << _file.fileName() << _file.errorString();
+        return false;
+    }
+    return map();
+}
+
+void WhazzupIndex::insert(const Entry &entry, qint64 addedBytes, bool addedFile) {
+    if (_map == 0) { // the index could not be written before, the new snapshot is on disk already
+        rebuild();
+        return;
+    }
+    Header newHeader = *header();
+    newHeader.fileBytes += addedBytes;
+    newHeader.fileCount += addedFile? 1: 0;
+
+    if (_count == 0 || entries()[_count - 1].msecs <= entry.msecs) {
+        // the usual case: a new snapshot at the end
+        unmap();
+        if (!_file.seek(_file.size())
+                || _file.write(reinterpret_cast<const char*>(&entry), sizeof(Entry)) != sizeof(Entry)
+                || !_file.seek(0)
+                || _file.write(reinterpret_cast<const char*>(&newHeader), sizeof(Header)) != sizeof(Header)
+                || !_file.flush()) {
+            qWarning() << "WhazzupIndex::insert() could not write" << _file.fileName() << _file.errorString();
+        }
+        map();
+        return;
+    }
+
+    QVector<Entry> list(_count);
+    std::copy(entries(), entries() + _count, list.begin());
+    const Entry *position = std::upper_bound(list.constBegin(), list.constEnd(), entry,
+                                             [](const Entry &a, const Entry &b) { return a.msecs < b.msecs; });
+    list.insert(position - list.constBegin(), entry);
+    write(newHeader, list);
+}
+
+void WhazzupIndex::addArchived(const WhazzupArchive::Frame &frame) {
+    Entry entry = { frame.time.toMSecsSinceEpoch(), frame.offset, frame.length,
+                    frame.isKeyframe? (quint32) Keyframe: 0 };
+    insert(entry, WhazzupArchive::frameHeaderSize + frame.length,
+           frame.offset == WhazzupArchive::frameHeaderSize); // first frame of a new archive
+}
@@ -0,0 +1,76 @@
+/**************************************************************************
+ *  This file is part of QuteScoop. See README for license
+ **************************************************************************/
+
+#ifndef WHAZZUPINDEX_H_
+#define WHAZZUPINDEX_H_
+
+#include "WhazzupArchive.h"
+
+#include <QtCore>
+
+/**
+  Persistent, memory-mapped index of the downloaded snapshots of one
+  network: archived frames (see WhazzupArchive) and old raw *.whazzup
+  files, sorted by time. downloaded/<network>.whazzupindex holds fixed
+  size entries, so lookups are binary searches on the mapped file.
+  The archive and raw file of an entry follow from its time, the index
+  does not store file names.
+  The index is checked against the directory once when it is opened
+  (number and total size of the files) and rebuilt if it does not match.
+  After that, saved snapshots are added with addArchived().
+**/
+class WhazzupIndex {
+    public:
+        WhazzupIndex(const QString &directory, int network);
+        ~WhazzupIndex();
+
+        int network() const { return _network; }
+        int size() const;
+        QDateTime time(int i) const;
+        // the last snapshot at or before time, -1 if there is none
+        int indexAtOrBefore(const QDateTime &time) const;
+        // the first snapshot at or after time, size() if there is none
+        int indexAtOrAfter(const QDateTime &time) const;
+        QString fileName(int i) const;
+
+        // the Whazzup JSON of snapshot i, straight from the disk
+        QByteArray whazzupJson(int i) const;
+
+        // a frame that has just been appended to its archive
+        void addArchived(const WhazzupArchive::Frame &frame);
+    private:
+        Q_DISABLE_COPY(WhazzupIndex)
+
+        struct Header {
+            quint32 magic, version;
+            qint64 fileBytes; // total size of the indexed files
+            qint32 fileCount, reserved;
+        };
+        struct Entry {
+            qint64 msecs; // since epoch
+            qint64 offset; // frame payload in the archive, 0 for raw files
+            quint32 length;
+            quint32 flags;
+        };
+        enum EntryFlags { Raw = 1, Keyframe = 2 };
+
+        QString archiveName(qint64 msecs) const;
+        QString rawName(qint64 msecs) const;
+        void directoryStatus(qint64 &fileBytes, qint32 &fileCount) const;
+        void rebuild();
+        void insert(const Entry &entry, qint64 addedBytes, bool addedFile);
+        bool write(const Header &header, const QVector<Entry> &entries);
+        bool map();
+        void unmap();
+        const Header *header() const { return reinterpret_cast<const Header*>(_map); }
+        const Entry *entries() const { return reinterpret_cast<const Entry*>(_map + sizeof(Header)); }
+
+        QString _directory;
+        int _network;
+        QFile _file;
+        uchar *_map;
+        int _count;
+};
+
+#endif /*WHAZZUPINDEX_H_*/
@@ -15,7 +15,6 @@
 #include "ListClientsDialog.h"
 #include "Whazzup.h"
 #include "Settings.h"
-#include "SearchVisitor.h"
 #include "MetarSearchVisitor.h"
 #include "NavData.h"
 #include "FriendsVisitor.h"
@@ -398,12 +397,10 @@ void Window::performSearch() {
         return;
 
     _timerSearch.stop();
-    SearchVisitor *visitor = new SearchVisitor(searchEdit->text());
-    NavData::instance()->accept(visitor);
-    Whazzup::instance()->whazzupData().accept(visitor);
-
-    _modelSearchResult.setSearchResults(visitor->result());
-    delete visitor;
+    const WhazzupData &data = Whazzup::instance()->whazzupData();
+    SearchIndex &index = NavData::instance()->searchIndex;
+    index.updateClients(data); // only does something if the data changed without NavData::updateData()
+    _modelSearchResult.setSearchResults(index.find(searchEdit->text(), data));
 
     searchResult->reset();
 }
@@ -525,21 +522,21 @@ void Window::performWarp() {
     qDebug() << "Window::performWarp() warpToTime=" << warpToTime << " realWhazzupTime=" << realWhazzupTime;
     if(cbUseDownloaded->isChecked() && warpToTime < realWhazzupTime) {
         qDebug() << "Window::performWarp() Looking for downloaded Whazzups";
-        QList<QPair<QDateTime, QString> > downloaded = Whazzup::instance()->downloadedWhazzups();
-        for (int i = downloaded.size() - 1; i > -1; i--) {
-            if((downloaded[i].first <= warpToTime && realWhazzupTime < downloaded[i].first) || (i == 0)) {
-                // only if different
-                if (downloaded[i].first != realWhazzupTime) {
-                    // disconnect to inhibit update because will be updated later
-                    disconnect(Whazzup::instance(), &Whazzup::newData, mapScreen->glWidget, &GLWidget::newWhazzupData);
-                    disconnect(Whazzup::instance(), &Whazzup::newData, this, &Window::processWhazzup);
-
-                    Whazzup::instance()->fromFile(downloaded[i].second);
-
-                    connect(Whazzup::instance(), &Whazzup::newData, mapScreen->glWidget, &GLWidget::newWhazzupData);
-                    connect(Whazzup::instance(), &Whazzup::newData, this, &Window::processWhazzup);
-                }
-                break;
+        WhazzupIndex *downloaded = Whazzup::instance()->downloadedIndex();
+        if (downloaded->size() > 0) {
+            int i = downloaded->indexAtOrBefore(warpToTime);
+            if (i < 0 || downloaded->time(i) <= realWhazzupTime)
+                i = 0;
+            // only if different
+            if (downloaded->time(i) != realWhazzupTime) {
+                // disconnect to inhibit update because will be updated later
+                disconnect(Whazzup::instance(), &Whazzup::newData, mapScreen->glWidget, &GLWidget::newWhazzupData);
+                disconnect(Whazzup::instance(), &Whazzup::newData, this, &Window::processWhazzup);
+
+                Whazzup::instance()->fromDownloaded(downloaded->time(i));
+
+                connect(Whazzup::instance(), &Whazzup::newData, mapScreen->glWidget, &GLWidget::newWhazzupData);
+                connect(Whazzup::instance(), &Whazzup::newData, this, &Window::processWhazzup);
             }
         }
     }
@@ -612,13 +609,9 @@ void Window::runPredict() {
     // when only using downloaded Whazzups, select the next available
     if(cbOnlyUseDownloaded->isChecked()) {
         qDebug() << "Window::runPredict() restricting Warp target to downloaded Whazzups";
-        QList<QPair<QDateTime, QString> > downloaded = Whazzup::instance()->downloadedWhazzups();
-        for (int i = 0; i < downloaded.size(); i++) {
-            if((downloaded[i].first >= to) || (i == downloaded.size() - 1)) {
-                to = downloaded[i].first;
-                break;
-            }
-        }
+        WhazzupIndex *downloaded = Whazzup::instance()->downloadedIndex();
+        if (downloaded->size() > 0)
+            to = downloaded->time(qMin(downloaded->indexAtOrAfter(to), downloaded->size() - 1));
     }
 
     qDebug() << to;
@@ -681,22 +674,12 @@ void Window::dateTimePredict_dateTimeChanged(QDateTime dateTime) {
     if(cbOnlyUseDownloaded->isChecked()) {
         qDebug() << "Window::dateTimePredict_dateTimeChanged()"
                  << "restricting Warp target to downloaded Whazzups";
-        QList<QPair<QDateTime, QString> > downloaded =
-                Whazzup::instance()->downloadedWhazzups();
-        if (dateTime > _dateTimePredict_old) { // selecting a later date
-            for (int i = 0; i < downloaded.size(); i++) {
-                if((downloaded[i].first >= dateTime) || (i == downloaded.size() - 1)) {
-                    dateTime = downloaded[i].first;
-                    break;
-                }
-            }
-        } else { // selecting an earlier date
-            for (int i = downloaded.size() - 1; i > -1; i--) {
-                if((downloaded[i].first <= dateTime) || (i == 0)) {
-                    dateTime = downloaded[i].first;
-                    break;
-                }
-            }
+        WhazzupIndex *downloaded = Whazzup::instance()->downloadedIndex();
+        if (downloaded->size() > 0) {
+            if (dateTime > _dateTimePredict_old) // selecting a later date
+                dateTime = downloaded->time(qMin(downloaded->indexAtOrAfter(dateTime), downloaded->size() - 1));
+            else // selecting an earlier date
+                dateTime = downloaded->time(qMax(downloaded->indexAtOrBefore(dateTime), 0));
         }
     }
 
@@ -944,7 +927,10 @@ void Window::cloudDownloadFinished() {
              << Settings::dataDirectory("textures/clouds/");
 
     _timerCloud.start(12600000); //start download in 3,5 h again
-    mapScreen->glWidget->useClouds();
+    // during startup the download might finish before the window is shown,
+    // the texture is then picked up by GLWidget::initializeGL()
+    if(isVisible())
+        mapScreen->glWidget->useClouds();
 }
 
 void Window::on_actionHighlight_Friends_triggered(bool checked) {